@@ -323,3 +323,36 @@ then
 _UPDATE_TO_VER4
 SCHEMA_VERSION=$(sqlite3 "$DBFILE" "SELECT value FROM meta WHERE name='version'")
 fi
+
+if [ "x$SCHEMA_VERSION" = "x4" ]
+then
+    # dept_closure holds every (ancestor, descendant) pair of the department hierarchy, plus (deptid, deptid, 0)
+    # for every department, so that descendant and recursive package queries don't need recursive CTEs.
+    sqlite3 "$DBFILE" << _UPDATE_TO_VER5
+    BEGIN TRANSACTION;
+
+    CREATE TABLE IF NOT EXISTS dept_closure (ancestor TEXT, descendant TEXT, depth INTEGER, CONSTRAINT pkey PRIMARY KEY (ancestor, descendant));
+    CREATE INDEX IF NOT EXISTS dept_closure_descendant ON dept_closure (descendant);
+    CREATE INDEX IF NOT EXISTS pkgmap_deptid ON pkgmap (deptid);
+
+    DELETE FROM dept_closure;
+    INSERT OR IGNORE INTO dept_closure (ancestor, descendant, depth) SELECT deptid, deptid, 0 FROM depts;
+    WITH RECURSIVE closure(ancestor, descendant, depth) AS (SELECT parentid, deptid, 1 FROM depts UNION SELECT closure.ancestor, depts.deptid, closure.depth + 1 FROM closure, depts WHERE closure.descendant=depts.parentid AND closure.depth < 64) INSERT OR IGNORE INTO dept_closure (ancestor, descendant, depth) SELECT ancestor, descendant, MIN(depth) FROM closure GROUP BY ancestor, descendant;
+
+    UPDATE meta SET value='5' WHERE name='version';
+    END TRANSACTION;
+_UPDATE_TO_VER5
+SCHEMA_VERSION=$(sqlite3 "$DBFILE" "SELECT value FROM meta WHERE name='version'")
+fi
+
+if [ "x$SCHEMA_VERSION" = "x5" ]
+then
+    # pkgmap records the version of each package stored by init-departments;
+    # DepartmentsDb adds the column itself when it opens the database for writing, so it may already be there.
+    if ! sqlite3 "$DBFILE" "SELECT version FROM pkgmap LIMIT 1" > /dev/null 2>&1
+    then
+        sqlite3 "$DBFILE" "ALTER TABLE pkgmap ADD COLUMN version TEXT"
+    fi
+    sqlite3 "$DBFILE" "UPDATE meta SET value='6' WHERE name='version'"
+SCHEMA_VERSION=$(sqlite3 "$DBFILE" "SELECT value FROM meta WHERE name='version'")
+fi
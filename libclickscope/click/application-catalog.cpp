@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "application-catalog.h"
+
+#include <click/collation.h>
+#include <click/configuration.h>
+#include <click/desktop-entry.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QString>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Installing or removing a package touches several desktop files in a row;
+// wait until the directories have been quiet for this long before rebuilding.
+constexpr int SETTLE_TIMEOUT_MS = 250;
+
+// how often to try watching a directory again that went away
+constexpr int RETRY_TIMEOUT_MS = 2000;
+
+constexpr std::uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM |
+    IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+bool is_desktop_file(const char* name)
+{
+    static const std::string suffix(".desktop");
+    const std::string s(name);
+    return s.size() >= suffix.size() &&
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+click::ApplicationCatalog::ApplicationCatalog(const std::string& systemApplicationsDir,
+                                              const std::string& userApplicationsDir,
+                                              const std::string& desktopFileCache)
+    : KeyFileLocator(systemApplicationsDir, userApplicationsDir, desktopFileCache),
+      generation_(0),
+      wakeup_fds{-1, -1},
+      watches{-1, -1}
+{
+}
+
+click::ApplicationCatalog::~ApplicationCatalog()
+{
+    stop();
+}
+
+void click::ApplicationCatalog::start()
+{
+    rebuild();
+
+    if (watcher.joinable()) {
+        return;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "Failed to initialize inotify, application catalog won't be updated:" << strerror(errno);
+        return;
+    }
+    if (pipe2(wakeup_fds, O_CLOEXEC) != 0) {
+        qWarning() << "Failed to create wakeup pipe, application catalog won't be updated:" << strerror(errno);
+        close(fd);
+        return;
+    }
+
+    add_watches(fd);
+    watcher = std::thread(&ApplicationCatalog::watch, this, fd);
+}
+
+void click::ApplicationCatalog::stop()
+{
+    if (watcher.joinable()) {
+        const char c = 0;
+        if (write(wakeup_fds[1], &c, 1) != 1) {
+            qWarning() << "Failed to wake up application catalog watcher";
+        }
+        watcher.join();
+        watches[0] = watches[1] = -1;
+    }
+    for (auto& fd: wakeup_fds) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool click::ApplicationCatalog::add_watches(int inotify_fd)
+{
+    const std::string* dirs[2] = {&systemApplicationsDir, &userApplicationsDir};
+    bool all_watched = true;
+    for (int i = 0; i < 2; i++) {
+        if (watches[i] >= 0) {
+            continue;
+        }
+        // the user applications directory may not exist until the first click package gets installed
+        if (dirs[i] == &userApplicationsDir) {
+            QDir("/").mkpath(QString::fromStdString(userApplicationsDir));
+        }
+        watches[i] = inotify_add_watch(inotify_fd, dirs[i]->c_str(), WATCH_MASK);
+        if (watches[i] < 0) {
+            qWarning() << "Failed to watch" << QString::fromStdString(*dirs[i]) << ":" << strerror(errno);
+            all_watched = false;
+        }
+    }
+    return all_watched;
+}
+
+void click::ApplicationCatalog::rebuild()
+{
+    std::lock_guard<std::mutex> rebuild_lock(rebuild_mutex);
+    rebuild_locked();
+}
+
+void click::ApplicationCatalog::rebuild_locked()
+{
+    std::shared_ptr<Snapshot> snapshot(new Snapshot());
+    const std::string lang = click::Configuration().get_language();
+    KeyFileLocator::enumerateDesktopEntriesForInstalledApplications([&snapshot](const DesktopEntry& entry) {
+        snapshot->entries.push_back(entry);
+    });
+    const std::string collation = click::collation_language();
+    for (auto& entry: snapshot->entries) {
+        entry.sort_key = click::collation_key(entry.name, collation);
+    }
+    std::stable_sort(snapshot->entries.begin(), snapshot->entries.end(),
+                     [](const DesktopEntry& a, const DesktopEntry& b) {
+        return a.sort_key < b.sort_key;
+    });
+    snapshot->index = SearchIndex(snapshot->entries);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    current = snapshot;
+    language = lang;
+    ++generation_;
+    qDebug() << "Application catalog rebuilt with" << snapshot->entries.size() << "entries, generation" << generation_.load();
+}
+
+std::uint64_t click::ApplicationCatalog::generation() const
+{
+    return generation_;
+}
+
+std::shared_ptr<const click::ApplicationCatalog::Entries> click::ApplicationCatalog::entries() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!current) {
+        return nullptr;
+    }
+    return std::shared_ptr<const Entries>(current, &current->entries);
+}
+
+std::shared_ptr<const click::ApplicationCatalog::Snapshot> click::ApplicationCatalog::snapshot()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current && language == click::Configuration().get_language()) {
+            return current;
+        }
+    }
+
+    // not started yet or the language changed under us; another thread may
+    // have rebuilt the catalog while we waited for it
+    std::lock_guard<std::mutex> rebuild_lock(rebuild_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current && language == click::Configuration().get_language()) {
+            return current;
+        }
+    }
+    rebuild_locked();
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+void click::ApplicationCatalog::enumerateDesktopEntriesForInstalledApplications(const EntryEnumerator& enumerator)
+{
+    auto snapshot = this->snapshot();
+    for (auto const& entry: snapshot->entries) {
+        enumerator(entry);
+    }
+}
+
+void click::ApplicationCatalog::enumerateDesktopEntriesMatching(const std::string& normalizedQuery,
+                                                                const EntryEnumerator& enumerator)
+{
+    auto snapshot = this->snapshot();
+    for (auto position: snapshot->index.candidates(normalizedQuery)) {
+        enumerator(snapshot->entries[position]);
+    }
+}
+
+bool click::ApplicationCatalog::enumeratesInCollationOrder() const
+{
+    return true;
+}
+
+void click::ApplicationCatalog::watch(int inotify_fd)
+{
+    // large enough for at least one event with the longest possible name
+    alignas(struct inotify_event) char buffer[4096 + sizeof(struct inotify_event) + NAME_MAX + 1];
+    struct pollfd fds[2] = {
+        {inotify_fd, POLLIN, 0},
+        {wakeup_fds[0], POLLIN, 0}
+    };
+    bool dirty = false;
+    bool all_watched = watches[0] >= 0 && watches[1] >= 0;
+
+    while (true) {
+        int r = poll(fds, 2, dirty ? SETTLE_TIMEOUT_MS : (all_watched ? -1 : RETRY_TIMEOUT_MS));
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "Application catalog watcher failed:" << strerror(errno);
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break; // stop() was called
+        }
+        if (r == 0) {
+            // watch directories that were removed and created again before
+            // rebuilding, so that no change in between gets lost
+            const bool was_watched = all_watched;
+            all_watched = add_watches(inotify_fd);
+            if (dirty || all_watched != was_watched) {
+                dirty = false;
+                rebuild();
+            }
+            continue;
+        }
+
+        ssize_t len;
+        while ((len = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + len; ) {
+                auto event = reinterpret_cast<const struct inotify_event*>(ptr);
+                if ((event->mask & (IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF)) ||
+                    (event->len > 0 && is_desktop_file(event->name))) {
+                    dirty = true;
+                }
+                // a moved directory is still watched at its new path, a
+                // removed one isn't watched anymore (IN_IGNORED)
+                for (auto& wd: watches) {
+                    if (wd >= 0 && event->wd == wd && (event->mask & (IN_MOVE_SELF | IN_IGNORED))) {
+                        if (event->mask & IN_MOVE_SELF) {
+                            inotify_rm_watch(inotify_fd, wd);
+                        }
+                        wd = -1;
+                        all_watched = false;
+                    }
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+
+    close(inotify_fd);
+}
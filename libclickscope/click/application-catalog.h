@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_APPLICATION_CATALOG_H
+#define CLICK_APPLICATION_CATALOG_H
+
+#include <click/key_file_locator.h>
+#include <click/search-index.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace click
+{
+
+// In-memory catalog of the desktop entries of all installed applications.
+//
+// The catalog is built once by start() and then kept up to date by watching
+// the application directories with inotify, so that queries never have to
+// touch the filesystem. Every rebuild bumps generation(), which lets callers
+// tell whether anything derived from an earlier state of the catalog is stale.
+// Each state comes with a SearchIndex, so searches only look at the entries
+// that can match, and entries are kept in collation order so that results
+// can be streamed without sorting them first.
+class ApplicationCatalog : public KeyFileLocator
+{
+public:
+    typedef std::vector<DesktopEntry> Entries;
+
+    ApplicationCatalog(const std::string& systemApplicationsDir = systemApplicationsDirectory(),
+                       const std::string& userApplicationsDir = userApplicationsDirectory(),
+                       const std::string& desktopFileCache = desktopFileCachePath());
+    virtual ~ApplicationCatalog();
+
+    // Builds the catalog and starts watching for changes.
+    virtual void start();
+    virtual void stop();
+
+    // Re-reads all desktop files (from the on-disk cache where possible).
+    virtual void rebuild();
+
+    virtual std::uint64_t generation() const;
+    virtual std::shared_ptr<const Entries> entries() const;
+
+    void enumerateDesktopEntriesForInstalledApplications(const EntryEnumerator& enumerator) override;
+    void enumerateDesktopEntriesMatching(const std::string& normalizedQuery,
+                                         const EntryEnumerator& enumerator) override;
+    bool enumeratesInCollationOrder() const override;
+
+private:
+    struct Snapshot
+    {
+        Entries entries;
+        SearchIndex index;
+    };
+
+    std::shared_ptr<const Snapshot> snapshot();
+    // rebuild() with rebuild_mutex held
+    void rebuild_locked();
+    void watch(int inotify_fd);
+    // (Re-)adds the watches of the application directories that aren't
+    // watched; false if one of them can't be watched (yet).
+    bool add_watches(int inotify_fd);
+
+    // held for the whole of rebuild(), so that snapshots are published in order
+    std::mutex rebuild_mutex;
+    mutable std::mutex mutex;
+    std::shared_ptr<const Snapshot> current;
+    std::string language;
+    std::atomic<std::uint64_t> generation_;
+    std::thread watcher;
+    int wakeup_fds[2];
+    // watch descriptors of the system and user applications directories, or
+    // -1; only used by start() and then the watcher thread
+    int watches[2];
+};
+
+} // namespace click
+
+#endif // CLICK_APPLICATION_CATALOG_H
@@ -58,6 +58,11 @@ struct Application : public Package {
 
     std::string description;
     std::vector<std::string> keywords;
+    // search_key() of title and keywords, see search-keys.h
+    std::string search_title;
+    std::vector<std::string> search_keywords;
+    // collation_key() of title, see collation.h; computed on demand if empty
+    std::string sort_key;
     std::string main_screenshot;
     std::string default_department;
     std::string real_department;
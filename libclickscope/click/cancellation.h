@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_CANCELLATION_H
+#define CLICK_CANCELLATION_H
+
+#include <atomic>
+#include <memory>
+
+namespace click
+{
+
+// Flag shared between a long running operation and whoever may want to
+// stop it. Copies of a token share its state; the operation checks
+// is_cancelled() at convenient points and gives up early once it is set.
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : state(std::make_shared<std::atomic<bool>>(false))
+    {
+    }
+
+    void cancel()
+    {
+        state->store(true);
+    }
+
+    bool is_cancelled() const
+    {
+        return state->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+} // namespace click
+
+#endif // CLICK_CANCELLATION_H
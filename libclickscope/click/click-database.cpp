@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "click-database.h"
+
+#include <unity/Exception.h>
+#include <unity/util/IniParser.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QString>
+#include <QStringList>
+
+#include <climits>
+#include <cstdlib>
+#include <set>
+
+#include <pwd.h>
+#include <unistd.h>
+
+namespace
+{
+static const char* CONFIG_GROUP("Click Database");
+static const char* CONFIG_ROOT("root");
+static const std::string USERS_DIR("/.click/users/");
+static const std::string ALL_USERS("@all");
+static const std::string HIDDEN("@hidden");
+
+std::string current_user()
+{
+    const struct passwd* pw = getpwuid(getuid());
+    if (pw != nullptr && pw->pw_name != nullptr) {
+        return pw->pw_name;
+    }
+    const char* user = getenv("USER");
+    return user != nullptr ? user : "";
+}
+
+// Target of the symlink at path, false if it isn't one.
+bool read_link(const std::string& path, std::string& target)
+{
+    char buffer[PATH_MAX];
+    const ssize_t size = readlink(path.c_str(), buffer, sizeof(buffer));
+    if (size <= 0 || static_cast<std::size_t>(size) >= sizeof(buffer)) {
+        return false;
+    }
+    target.assign(buffer, size);
+    return true;
+}
+
+void list_registrations(const std::string& users_dir, std::set<std::string>& names)
+{
+    // links to @hidden are dangling, and only listed as system entries
+    QDir dir(QString::fromStdString(users_dir), QString(), QDir::Unsorted,
+             QDir::Files | QDir::Dirs | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot);
+    for (auto const& entry: dir.entryList()) {
+        names.insert(entry.toStdString());
+    }
+}
+}
+
+std::string click::ClickDatabase::Registration::manifest_path() const
+{
+    return directory + "/.click/info/" + name + ".manifest";
+}
+
+std::vector<std::string> click::ClickDatabase::configured_roots(const std::string& config_dir)
+{
+    std::vector<std::string> roots;
+    QDir dir(QString::fromStdString(config_dir), "*.conf",
+             QDir::Name, QDir::Readable | QDir::Files);
+    for (auto const& entry: dir.entryList()) {
+        const std::string path = dir.absoluteFilePath(entry).toStdString();
+        try {
+            roots.push_back(unity::util::IniParser(path.c_str()).get_string(CONFIG_GROUP, CONFIG_ROOT));
+        } catch (const unity::Exception& e) {
+            qWarning() << "Error reading click database configuration:" << e.to_string().c_str();
+        }
+    }
+    return roots;
+}
+
+click::ClickDatabase::ClickDatabase()
+    : ClickDatabase(configured_roots(), current_user())
+{
+}
+
+click::ClickDatabase::ClickDatabase(const std::vector<std::string>& roots, const std::string& user)
+    : roots(roots),
+      user(user)
+{
+}
+
+bool click::ClickDatabase::is_valid() const
+{
+    return !roots.empty() && !user.empty();
+}
+
+std::vector<click::ClickDatabase::Registration> click::ClickDatabase::registrations() const
+{
+    std::set<std::string> names;
+    for (auto const& root: roots) {
+        list_registrations(root + USERS_DIR + user, names);
+        list_registrations(root + USERS_DIR + ALL_USERS, names);
+    }
+
+    std::vector<Registration> found;
+    for (auto const& name: names) {
+        Registration registration;
+        if (find(name, registration)) {
+            found.push_back(registration);
+        }
+    }
+    return found;
+}
+
+bool click::ClickDatabase::find(const std::string& package, Registration& registration) const
+{
+    if (package.empty() || package[0] == '.' || package.find('/') != std::string::npos) {
+        return false;
+    }
+
+    for (auto root = roots.rbegin(); root != roots.rend(); ++root) {
+        const std::string users_dir = *root + USERS_DIR;
+        switch (lookup(users_dir + user + "/", package, registration)) {
+        case Lookup::Found:
+            registration.removable = true;
+            return true;
+        case Lookup::Hidden:
+            return false;
+        case Lookup::Missing:
+            break;
+        }
+        if (lookup(users_dir + ALL_USERS + "/", package, registration) == Lookup::Found) {
+            registration.removable = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+click::ClickDatabase::Lookup click::ClickDatabase::lookup(const std::string& users_dir,
+                                                          const std::string& package,
+                                                          Registration& registration) const
+{
+    std::string target;
+    if (!read_link(users_dir + package, target)) {
+        return Lookup::Missing;
+    }
+    if (target == HIDDEN) {
+        return Lookup::Hidden;
+    }
+    if (target[0] != '/') {
+        target = users_dir + target;
+    }
+    target = QDir::cleanPath(QString::fromStdString(target)).toStdString();
+
+    // the link points to <root>/<package>/<version>
+    const std::string version = target.substr(target.rfind('/') + 1);
+    if (version.empty()) {
+        return Lookup::Missing;
+    }
+    registration.name = package;
+    registration.version = version;
+    registration.directory = target;
+    return Lookup::Found;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_CLICK_DATABASE_H
+#define CLICK_CLICK_DATABASE_H
+
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// Reads the click package database directly, instead of through the click
+// command line tool, whose interpreter takes hundreds of milliseconds to
+// start.
+//
+// The databases are the roots configured in /etc/click/databases/*.conf, in
+// increasing order of priority. A package is registered for a user by a
+// symlink <root>/.click/users/<user>/<package>, or for all users by one in
+// <root>/.click/users/@all, pointing to <root>/<package>/<version>; a link
+// to @hidden hides the package from the user. As in click, registrations
+// of the user in a database take precedence over ones for all users, and
+// databases of higher priority over those of lower priority.
+class ClickDatabase
+{
+public:
+    struct Registration
+    {
+        std::string name;
+        std::string version;
+        // directory of the unpacked package
+        std::string directory;
+        // registered for the user rather than for all users
+        bool removable = false;
+
+        // .click/info/<name>.manifest in the package directory
+        std::string manifest_path() const;
+    };
+
+    constexpr static const char* DEFAULT_CONFIG_DIR {"/etc/click/databases"};
+
+    // Roots of the databases configured in config_dir, lowest priority first.
+    static std::vector<std::string> configured_roots(const std::string& config_dir = DEFAULT_CONFIG_DIR);
+
+    // Database of the user running the process.
+    ClickDatabase();
+    ClickDatabase(const std::vector<std::string>& roots, const std::string& user);
+
+    // False if there are no databases to read, so that callers fall back
+    // to the click tool.
+    bool is_valid() const;
+
+    // Packages registered for the user, sorted by name, like `click list`.
+    std::vector<Registration> registrations() const;
+    // Looks up the registration of a single package.
+    bool find(const std::string& package, Registration& registration) const;
+
+private:
+    enum class Lookup
+    {
+        Found,
+        Hidden,
+        Missing
+    };
+
+    Lookup lookup(const std::string& users_dir, const std::string& package, Registration& registration) const;
+
+    std::vector<std::string> roots;
+    std::string user;
+};
+
+} // namespace click
+
+#endif // CLICK_CLICK_DATABASE_H
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "collation.h"
+
+#include <click/configuration.h>
+
+#include <boost/locale/collator.hpp>
+#include <boost/locale/generator.hpp>
+
+#include <cstdlib>
+#include <locale>
+#include <map>
+#include <mutex>
+
+namespace
+{
+
+// Generating a locale is expensive, so keep one per language.
+std::locale collation_locale(const std::string& language)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::locale> locales;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = locales.find(language);
+    if (it == locales.end()) {
+        boost::locale::generator gen;
+        it = locales.insert(std::make_pair(language, gen(language))).first;
+    }
+    return it->second;
+}
+
+}
+
+std::string click::collation_language()
+{
+    const char* lang = getenv(click::Configuration::LANGUAGE_ENVVAR);
+    if (lang == NULL) {
+        lang = "C.UTF-8";
+    }
+    return lang;
+}
+
+std::string click::collation_key(const std::string& text, const std::string& language)
+{
+    typedef boost::locale::collator<char> coll_type;
+    const std::locale loc = collation_locale(language);
+    return std::use_facet<coll_type>(loc).transform(boost::locale::collator_base::quaternary, text);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "department-facets.h"
+#include "departments-db.h"
+
+namespace click
+{
+
+DepartmentFacets::DepartmentFacets(DepartmentsDb& db, const std::string& department_id)
+    : top_departments(db.get_top_departments_under(department_id))
+{
+}
+
+void DepartmentFacets::add(const std::string& app_department)
+{
+    auto it = top_departments.find(app_department);
+    if (it != top_departments.end())
+    {
+        ++child_counts[it->second];
+    }
+}
+
+std::size_t DepartmentFacets::count(const std::string& child_id) const
+{
+    auto it = child_counts.find(child_id);
+    return it == child_counts.end() ? 0 : it->second;
+}
+
+const std::unordered_map<std::string, std::size_t>& DepartmentFacets::counts() const
+{
+    return child_counts;
+}
+
+} // namespace click
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DEPARTMENT_FACETS_H
+#define CLICK_DEPARTMENT_FACETS_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+namespace click
+{
+
+class DepartmentsDb;
+
+// Counts apps per direct child of a department.
+//
+// The subtree of the department is fetched once, as a map from every
+// department below it to the child it descends from, so that each app is
+// attributed to its child with a single lookup instead of one ancestor
+// query per child and app department.
+class DepartmentFacets
+{
+public:
+    DepartmentFacets(DepartmentsDb& db, const std::string& department_id);
+
+    // Counts an app of the given department; apps of departments outside
+    // the subtree are ignored.
+    void add(const std::string& app_department);
+
+    // Number of apps added within the subtree of the given child.
+    std::size_t count(const std::string& child_id) const;
+
+    const std::unordered_map<std::string, std::size_t>& counts() const;
+
+private:
+    std::unordered_map<std::string, std::string> top_departments;
+    std::unordered_map<std::string, std::size_t> child_counts;
+};
+
+} // namespace click
+
+#endif // CLICK_DEPARTMENT_FACETS_H
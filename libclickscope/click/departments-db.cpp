@@ -28,112 +28,380 @@
  */
 
 #include "departments-db.h"
+#include "departments-snapshot.h"
+#include "departments-sql.h"
+#include "mapped-departments.h"
+#include "mapped-departments-db.h"
+#include "native-departments-db.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <stdexcept>
-#include <iostream>
+#include <utility>
 #include <QSqlError>
 #include <QSqlRecord>
 #include <QVariant>
 #include <QStandardPaths>
 #include <QDir>
+#include <QDebug>
 
 namespace click
 {
 
-std::unique_ptr<click::DepartmentsDb> DepartmentsDb::open(bool create)
+std::unique_ptr<click::DepartmentsDb> DepartmentsDb::open(bool create, bool use_mapped)
 {
     auto const path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
     if (!path.isEmpty())
     {
         QDir("/").mkpath(path);
         const std::string dbpath = path.toStdString() + "/click-departments.db";
-        return std::unique_ptr<DepartmentsDb>(new DepartmentsDb(dbpath, create));
+        return open_file(dbpath, create, use_mapped);
     }
     throw std::runtime_error("Cannot determine cache directory");
 }
 
+std::unique_ptr<click::DepartmentsDb> DepartmentsDb::open_file(const std::string& path, bool create, bool use_mapped)
+{
+    const char* backend = getenv(ENV_BACKEND);
+    if (backend != nullptr && strcmp(backend, "sqlite3") == 0)
+    {
+        return std::unique_ptr<DepartmentsDb>(new NativeDepartmentsDb(path, create));
+    }
+    if (backend == nullptr && !create && use_mapped)
+    {
+        if (auto db = MappedDepartmentsDb::open(path, mapped_path(path)))
+        {
+            return db;
+        }
+    }
+    return std::unique_ptr<DepartmentsDb>(new DepartmentsDb(path, create));
+}
+
+std::string DepartmentsDb::mapped_path(const std::string& db_path)
+{
+    return db_path + ".mapped";
+}
+
+namespace
+{
+// makes the names of connections unique across DepartmentsDb instances
+std::atomic<unsigned> connection_counter(0);
+}
+
+DepartmentsDb::Profile DepartmentsDb::Profile::from_env()
+{
+    Profile profile;
+    const char* name = getenv(ENV_PROFILE);
+    if (name != nullptr && strcmp(name, "sqlite") == 0)
+    {
+        profile.mmap_size = -1;
+        profile.cache_size = 0;
+        profile.temp_store_memory = false;
+    }
+    return profile;
+}
+
+std::vector<std::string> DepartmentsDb::Profile::pragmas() const
+{
+    std::vector<std::string> pragmas;
+    if (mmap_size >= 0)
+    {
+        pragmas.push_back("PRAGMA mmap_size=" + std::to_string(mmap_size));
+    }
+    if (cache_size != 0)
+    {
+        pragmas.push_back("PRAGMA cache_size=" + std::to_string(cache_size));
+    }
+    if (temp_store_memory)
+    {
+        pragmas.push_back("PRAGMA temp_store=MEMORY");
+    }
+    if (query_only)
+    {
+        pragmas.push_back("PRAGMA query_only=1");
+    }
+    return pragmas;
+}
+
 DepartmentsDb::DepartmentsDb(const std::string& name, bool create)
+    : db_path_(name),
+      profile_(Profile::from_env())
 {
-    db_ = QSqlDatabase::addDatabase("QSQLITE");
-    db_.setDatabaseName(QString::fromStdString(name));
-    if (!db_.open())
+    set_up(create);
+}
+
+DepartmentsDb::DepartmentsDb(const std::string& name, Deferred)
+    : db_path_(name),
+      profile_(Profile::from_env())
+{
+}
+
+void DepartmentsDb::set_up(bool create)
+{
+    //
+    // set up the database with a connection of its own; the connections of
+    // threads prepare their queries depending on what this finds
+    const QString setup_name = QString::fromStdString("click-departments-setup-" + std::to_string(connection_counter++));
+    try
     {
-        throw std::runtime_error("Cannot open departments database");
+        QSqlDatabase db = open_database(setup_name);
+        QSqlQuery query(db);
+
+        // activate write-ahead logging, see http://sqlite.org/wal.html to avoid transaction errors with concurrent reads and writes,
+        // and to let readers on other connections proceed while the database is written
+        query.exec("PRAGMA journal_mode=WAL");
+
+        if (create)
+        {
+            init_db(db);
+        }
+        else
+        {
+            // check for existence of meta table to see if we're dealing with uninitialized database
+            if (!query.exec("SELECT 1 FROM meta"))
+            {
+                throw std::runtime_error("Invalid departments database");
+            }
+        }
+
+        // databases that weren't migrated to schema version 5 yet have no closure table
+        has_closure_ = query.exec("SELECT 1 FROM sqlite_master WHERE type='table' AND name='dept_closure'") && query.next();
+        query.finish();
+    }
+    catch (...)
+    {
+        QSqlDatabase::removeDatabase(setup_name);
+        throw;
     }
+    QSqlDatabase::removeDatabase(setup_name);
 
+    // init_db() may have just added the closure table to an older database
     if (create)
     {
-        init_db();
+        rebuild_closure();
     }
-    else
+}
+
+DepartmentsDb::~DepartmentsDb()
+{
+    join_warm_up();
+    // connections of other threads may only be closed by those threads, see
+    // ThreadConnections
+    release_connection();
+}
+
+QSqlDatabase DepartmentsDb::open_database(const QString& connection_name) const
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+    db.setDatabaseName(QString::fromStdString(db_path_));
+    // wait for writers on other connections instead of failing right away
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open())
+    {
+        throw std::runtime_error("Cannot open departments database");
+    }
+    return db;
+}
+
+DepartmentsDb::Connection& DepartmentsDb::connection() const
+{
+    if (auto conn = connections_.find())
+    {
+        return *conn;
+    }
+
+    const QString name = QString::fromStdString("click-departments-" + std::to_string(connection_counter++));
+    std::shared_ptr<Connection> opened(new Connection(), [](Connection* conn) {
+        const QString name = conn->name;
+        // queries and the database handle have to be gone before the connection is removed
+        delete conn;
+        QSqlDatabase::removeDatabase(name);
+    });
+    opened->name = name;
+    opened->db = open_database(name);
+    QSqlQuery query(opened->db);
+    for (auto const& pragma: profile().pragmas())
     {
-        QSqlQuery query;
-        // check for existence of meta table to see if we're dealing with uninitialized database
-        if (!query.exec("SELECT 1 FROM meta"))
+        if (!query.exec(QString::fromStdString(pragma)))
         {
-            throw std::runtime_error("Invalid departments database");
+            qWarning() << "Failed to set" << QString::fromStdString(pragma) << ":" << query.lastError().text();
         }
     }
+    query.finish();
+    prepare_queries(*opened);
+    return connections_.add(opened);
+}
 
-    delete_pkgmap_query_.reset(new QSqlQuery(db_));
-    delete_depts_query_.reset(new QSqlQuery(db_));
-    delete_deptnames_query_.reset(new QSqlQuery(db_));
-    insert_pkgmap_query_.reset(new QSqlQuery(db_));
-    insert_dept_id_query_.reset(new QSqlQuery(db_));
-    insert_dept_name_query_.reset(new QSqlQuery(db_));
-    select_pkgs_by_dept_.reset(new QSqlQuery(db_));
-    select_dept_for_pkg_.reset(new QSqlQuery(db_));
-    select_pkg_by_pkgid_.reset(new QSqlQuery(db_));
-    select_pkgs_by_dept_recursive_.reset(new QSqlQuery(db_));
-    select_pkgs_count_in_dept_recursive_.reset(new QSqlQuery(db_));
-    select_parent_dept_.reset(new QSqlQuery(db_));
-    select_children_depts_.reset(new QSqlQuery(db_));
-    select_dept_name_.reset(new QSqlQuery(db_));
-    select_is_descendant_of_dept_.reset(new QSqlQuery(db_));
-
-    delete_pkgmap_query_->prepare("DELETE FROM pkgmap WHERE pkgid=:pkgid");
-    delete_depts_query_->prepare("DELETE FROM depts");
-    delete_deptnames_query_->prepare("DELETE FROM deptnames WHERE locale=:locale");
-    insert_pkgmap_query_->prepare("INSERT OR REPLACE INTO pkgmap (pkgid, deptid) VALUES (:pkgid, :deptid)");
-    insert_dept_id_query_->prepare("INSERT OR REPLACE INTO depts (deptid, parentid) VALUES (:deptid, :parentid)");
-    insert_dept_name_query_->prepare("INSERT OR REPLACE INTO deptnames (deptid, locale, name) VALUES (:deptid, :locale, :name)");
-    select_pkgs_by_dept_->prepare("SELECT pkgid FROM pkgmap WHERE deptid=:deptid");
-    select_pkgs_by_dept_recursive_->prepare("WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE deptid=:deptid OR parentid=:deptid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT pkgid FROM pkgmap NATURAL JOIN recdepts");
-    select_dept_for_pkg_->prepare("SELECT deptid from pkgmap WHERE pkgid=:pkgid");
-    select_pkgs_count_in_dept_recursive_->prepare("WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE deptid=:deptid OR parentid=:deptid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT COUNT(pkgid) FROM pkgmap NATURAL JOIN recdepts");
-    select_pkg_by_pkgid_->prepare("SELECT pkgid FROM pkgmap WHERE pkgid=:pkgid");
-    select_children_depts_->prepare("SELECT deptid,(SELECT COUNT(1) from depts AS inner WHERE inner.parentid=outer.deptid) FROM depts AS outer WHERE parentid=:parentid");
-    select_parent_dept_->prepare("SELECT parentid FROM depts WHERE deptid=:deptid");
-    select_dept_name_->prepare("SELECT name FROM deptnames WHERE deptid=:deptid AND locale=:locale");
-    select_is_descendant_of_dept_->prepare("WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE parentid=:parentid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT COUNT(1) FROM recdepts WHERE deptid=:deptid");
+void DepartmentsDb::release_connection() const
+{
+    connections_.release();
 }
 
-DepartmentsDb::~DepartmentsDb()
+void DepartmentsDb::set_profile(const Profile& profile)
+{
+    std::lock_guard<std::mutex> lock(profile_mutex_);
+    profile_ = profile;
+}
+
+DepartmentsDb::Profile DepartmentsDb::profile() const
 {
+    std::lock_guard<std::mutex> lock(profile_mutex_);
+    return profile_;
 }
 
-void DepartmentsDb::init_db()
+void DepartmentsDb::warm_up(bool write_mapped)
+{
+    std::lock_guard<std::mutex> lock(warm_up_mutex_);
+    if (!warm_up_thread_.joinable())
+    {
+        warm_up_thread_ = std::thread([this, write_mapped]() {
+            run_warm_up(write_mapped);
+        });
+    }
+}
+
+bool DepartmentsDb::warmed_up()
+{
+    return warmed_up_;
+}
+
+void DepartmentsDb::join_warm_up()
+{
+    std::lock_guard<std::mutex> lock(warm_up_mutex_);
+    if (warm_up_thread_.joinable())
+    {
+        warm_up_thread_.join();
+    }
+}
+
+void DepartmentsDb::run_warm_up(bool write_mapped)
+{
+    auto const started = std::chrono::steady_clock::now();
+    try
+    {
+        {
+            QSqlQuery query(connection().db);
+            for (auto const sql: departments_sql::WARM_UP)
+            {
+                if (query.exec(sql))
+                {
+                    query.next();
+                }
+            }
+            query.finish();
+        }
+        // the snapshot reads depts and pkgmap
+        snapshot();
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "Failed to warm up departments database:" << e.what();
+    }
+    if (write_mapped)
+    {
+        const std::string path = mapped_path(db_path_);
+        try
+        {
+            if (!MappedDepartmentsDb::open(db_path_, path))
+            {
+                export_mapped(path);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            qWarning() << "Failed to write" << QString::fromStdString(path) << ":" << e.what();
+        }
+    }
+    // connections can't be used by other threads
+    release_connection();
+
+    warmed_up_ = true;
+    auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    qDebug() << "Departments database warmed up in" << elapsed.count() << "ms";
+}
+
+void DepartmentsDb::prepare_queries(Connection& conn) const
+{
+    conn.delete_pkgmap_query.reset(new QSqlQuery(conn.db));
+    conn.delete_depts_query.reset(new QSqlQuery(conn.db));
+    conn.delete_deptnames_query.reset(new QSqlQuery(conn.db));
+    conn.insert_pkgmap_query.reset(new QSqlQuery(conn.db));
+    conn.insert_dept_id_query.reset(new QSqlQuery(conn.db));
+    conn.insert_dept_name_query.reset(new QSqlQuery(conn.db));
+    conn.select_pkgs_by_dept.reset(new QSqlQuery(conn.db));
+    conn.select_dept_for_pkg.reset(new QSqlQuery(conn.db));
+    conn.select_pkg_by_pkgid.reset(new QSqlQuery(conn.db));
+    conn.select_pkgs_by_dept_recursive.reset(new QSqlQuery(conn.db));
+    conn.select_pkgs_count_in_dept_recursive.reset(new QSqlQuery(conn.db));
+    conn.select_parent_dept.reset(new QSqlQuery(conn.db));
+    conn.select_children_depts.reset(new QSqlQuery(conn.db));
+    conn.select_dept_names.reset(new QSqlQuery(conn.db));
+    conn.select_is_descendant_of_dept.reset(new QSqlQuery(conn.db));
+    conn.select_top_depts_under.reset(new QSqlQuery(conn.db));
+    conn.delete_closure_query.reset(new QSqlQuery(conn.db));
+    conn.insert_closure_self_query.reset(new QSqlQuery(conn.db));
+    conn.insert_closure_query.reset(new QSqlQuery(conn.db));
+
+    conn.delete_pkgmap_query->prepare(departments_sql::DELETE_PKGMAP);
+    conn.delete_depts_query->prepare(departments_sql::DELETE_DEPTS);
+    conn.delete_deptnames_query->prepare(departments_sql::DELETE_DEPTNAMES);
+    conn.insert_pkgmap_query->prepare(departments_sql::INSERT_PKGMAP);
+    conn.insert_dept_id_query->prepare(departments_sql::INSERT_DEPT_ID);
+    conn.insert_dept_name_query->prepare(departments_sql::INSERT_DEPT_NAME);
+    conn.select_pkgs_by_dept->prepare(departments_sql::SELECT_PKGS_BY_DEPT);
+    conn.select_dept_for_pkg->prepare(departments_sql::SELECT_DEPT_FOR_PKG);
+    conn.select_pkg_by_pkgid->prepare(departments_sql::SELECT_PKG_BY_PKGID);
+    conn.select_children_depts->prepare(departments_sql::SELECT_CHILDREN_DEPTS);
+    conn.select_parent_dept->prepare(departments_sql::SELECT_PARENT_DEPT);
+    conn.select_dept_names->prepare(departments_sql::SELECT_DEPT_NAMES);
+
+    if (has_closure_)
+    {
+        conn.select_pkgs_by_dept_recursive->prepare(departments_sql::SELECT_PKGS_BY_DEPT_RECURSIVE);
+        conn.select_pkgs_count_in_dept_recursive->prepare(departments_sql::SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE);
+        conn.select_is_descendant_of_dept->prepare(departments_sql::SELECT_IS_DESCENDANT_OF_DEPT);
+        conn.select_top_depts_under->prepare(departments_sql::SELECT_TOP_DEPTS_UNDER);
+
+        conn.delete_closure_query->prepare(departments_sql::DELETE_CLOSURE);
+        conn.insert_closure_self_query->prepare(departments_sql::INSERT_CLOSURE_SELF);
+        conn.insert_closure_query->prepare(departments_sql::INSERT_CLOSURE);
+    }
+    else
+    {
+        conn.select_pkgs_by_dept_recursive->prepare(departments_sql::SELECT_PKGS_BY_DEPT_RECURSIVE_CTE);
+        conn.select_pkgs_count_in_dept_recursive->prepare(departments_sql::SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE_CTE);
+        conn.select_is_descendant_of_dept->prepare(departments_sql::SELECT_IS_DESCENDANT_OF_DEPT_CTE);
+        conn.select_top_depts_under->prepare(departments_sql::SELECT_TOP_DEPTS_UNDER_CTE);
+    }
+}
+
+void DepartmentsDb::init_db(QSqlDatabase& db)
 {
     //
     // CAUTION:
     // DON'T FORGET TO BUMP SCHEMA VERSION BELOW AND HANDLE SCHEMA UPGRADE IN data/update_schema.sh
     // WHENEVER YOU CHANGE ANY OF THE TABLES BELOW!
 
-    QSqlQuery query;
+    QSqlQuery query(db);
 
     // FIXME: for some reason enabling foreign keys gives errors about number of arguments of prepared queries when doing query.exec(); do not enable
     // them for now.
     // query.exec("PRAGMA foreign_keys = ON");
 
-    // activate write-ahead logging, see http://sqlite.org/wal.html to avoid transaction errors with concurrent reads and writes
-    query.exec("PRAGMA journal_mode=WAL");
-
-    db_.transaction();
+    db.transaction();
 
     // package id -> department id mapping table
-    if (!query.exec("CREATE TABLE IF NOT EXISTS pkgmap (pkgid TEXT, deptid TEXT, CONSTRAINT pkey PRIMARY KEY (pkgid, deptid))"))
+    if (!query.exec("CREATE TABLE IF NOT EXISTS pkgmap (pkgid TEXT, deptid TEXT, version TEXT, CONSTRAINT pkey PRIMARY KEY (pkgid, deptid))"))
     {
         report_db_error(query.lastError(), "Failed to create pkgmap table");
     }
+    // package versions were added in schema version 6
+    if (!query.exec("SELECT version FROM pkgmap LIMIT 1") && !query.exec("ALTER TABLE pkgmap ADD COLUMN version TEXT"))
+    {
+        report_db_error(query.lastError(), "Failed to add version column to pkgmap table");
+    }
 
     // department id -> parent department id mapping table
     if (!query.exec("CREATE TABLE IF NOT EXISTS depts (deptid TEXT, parentid TEXT, CONSTRAINT pkey PRIMARY KEY (deptid, parentid), CONSTRAINT fkey FOREIGN KEY (deptid) REFERENCES deptnames(deptid))"))
@@ -153,14 +421,28 @@ void DepartmentsDb::init_db()
         report_db_error(query.lastError(), "Failed to create meta table");
     }
 
+    // ancestor -> descendant mapping table; transitive closure of depts, maintained by rebuild_closure()
+    if (!query.exec("CREATE TABLE IF NOT EXISTS dept_closure (ancestor TEXT, descendant TEXT, depth INTEGER, CONSTRAINT pkey PRIMARY KEY (ancestor, descendant))"))
+    {
+        report_db_error(query.lastError(), "Failed to create dept_closure table");
+    }
+    if (!query.exec("CREATE INDEX IF NOT EXISTS dept_closure_descendant ON dept_closure (descendant)"))
+    {
+        report_db_error(query.lastError(), "Failed to create dept_closure index");
+    }
+    if (!query.exec("CREATE INDEX IF NOT EXISTS pkgmap_deptid ON pkgmap (deptid)"))
+    {
+        report_db_error(query.lastError(), "Failed to create pkgmap index");
+    }
+
     //
     // note: this will fail due to unique constraint, but that's fine; it's expected to succeed only when new database is created; in other
     // cases the version needs to be bumped in the update_schema.sh script.
-    query.exec("INSERT INTO meta (name, value) VALUES ('version', 4)");
+    query.exec("INSERT INTO meta (name, value) VALUES ('version', 6)");
 
-    if (!db_.commit())
+    if (!db.commit())
     {
-        report_db_error(db_.lastError(), "Failed to commit init transaction");
+        report_db_error(db.lastError(), "Failed to commit init transaction");
     }
 }
 
@@ -169,98 +451,293 @@ void DepartmentsDb::report_db_error(const QSqlError& error, const std::string& m
     throw std::runtime_error(message + ": " + error.text().toStdString());
 }
 
-std::string DepartmentsDb::get_department_name(const std::string& department_id, const std::list<std::string>& locales)
+void DepartmentsDb::stamp_db_files(FileStamp stamps[2]) const
 {
-    for (auto const& locale: locales)
+    // in WAL mode changes by other connections only reach the -wal file
+    // until they are checkpointed
+    const std::string paths[2] = { db_path_, db_path_ + "-wal" };
+    for (int i = 0; i < 2; i++)
     {
-        select_dept_name_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-        select_dept_name_->bindValue(":locale", QVariant(QString::fromStdString(locale)));
+        stamps[i] = FileStamp::of(paths[i]);
+    }
+}
 
-        if (!select_dept_name_->exec())
-        {
-            report_db_error(select_dept_name_->lastError(), "Failed to query for department name of " + department_id + ", locale " + locale);
-        }
+bool DepartmentsDb::load_hierarchy(Rows& depts, Rows& pkgmap)
+{
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+    if (!query.exec(departments_sql::SELECT_DEPTS))
+    {
+        qWarning() << "Failed to load departments:" << query.lastError().text();
+        return false;
+    }
+    while (query.next())
+    {
+        depts.push_back(std::make_pair(query.value(0).toString().toStdString(), query.value(1).toString().toStdString()));
+    }
+    if (!query.exec(departments_sql::SELECT_PKGMAP))
+    {
+        qWarning() << "Failed to load package mappings:" << query.lastError().text();
+        return false;
+    }
+    while (query.next())
+    {
+        pkgmap.push_back(std::make_pair(query.value(0).toString().toStdString(), query.value(1).toString().toStdString()));
+    }
+    query.finish();
+    return true;
+}
+
+std::shared_ptr<const DepartmentsSnapshot> DepartmentsDb::load_snapshot()
+{
+    Rows depts, pkgmap;
+    if (!load_hierarchy(depts, pkgmap))
+    {
+        return nullptr;
+    }
+
+    auto snapshot = DepartmentsSnapshot::build(depts, pkgmap);
+    if (!snapshot)
+    {
+        qWarning() << "Departments don't form a tree, using SQL queries";
+    }
+    return snapshot;
+}
+
+std::shared_ptr<const DepartmentsSnapshot> DepartmentsDb::snapshot()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    FileStamp stamps[2];
+    stamp_db_files(stamps);
+    if (!snapshot_valid_ || !(stamps[0] == snapshot_stamps_[0]) || !(stamps[1] == snapshot_stamps_[1]))
+    {
+        snapshot_ = load_snapshot();
+        snapshot_stamps_[0] = stamps[0];
+        snapshot_stamps_[1] = stamps[1];
+        snapshot_valid_ = true;
+    }
+    return snapshot_;
+}
 
-        if (select_dept_name_->next())
+std::uint64_t DepartmentsDb::generation()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    FileStamp stamps[2];
+    stamp_db_files(stamps);
+    if (generation_ == 0 || !(stamps[0] == generation_stamps_[0]) || !(stamps[1] == generation_stamps_[1]))
+    {
+        generation_stamps_[0] = stamps[0];
+        generation_stamps_[1] = stamps[1];
+        generation_++;
+    }
+    return generation_;
+}
+
+void DepartmentsDb::invalidate_snapshot()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    snapshot_valid_ = false;
+    snapshot_.reset();
+}
+
+const std::unordered_map<std::string, std::string>& DepartmentsDb::names_for_locale(const std::string& locale)
+{
+    FileStamp stamps[2];
+    stamp_db_files(stamps);
+    if (!names_valid_ || !(stamps[0] == names_stamps_[0]) || !(stamps[1] == names_stamps_[1]))
+    {
+        names_.clear();
+        names_stamps_[0] = stamps[0];
+        names_stamps_[1] = stamps[1];
+        names_valid_ = true;
+    }
+
+    auto it = names_.find(locale);
+    if (it != names_.end())
+    {
+        return it->second;
+    }
+
+    return names_[locale] = load_department_names(locale);
+}
+
+std::unordered_map<std::string, std::string> DepartmentsDb::load_department_names(const std::string& locale)
+{
+    auto& conn = connection();
+    conn.select_dept_names->bindValue(":locale", QVariant(QString::fromStdString(locale)));
+    if (!conn.select_dept_names->exec())
+    {
+        report_db_error(conn.select_dept_names->lastError(), "Failed to query for department names of locale " + locale);
+    }
+    std::unordered_map<std::string, std::string> names;
+    while (conn.select_dept_names->next())
+    {
+        names[conn.select_dept_names->value(0).toString().toStdString()] = conn.select_dept_names->value(1).toString().toStdString();
+    }
+    conn.select_dept_names->finish();
+    return names;
+}
+
+void DepartmentsDb::invalidate_department_names(const std::string& locale)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    names_.erase(locale);
+}
+
+void DepartmentsDb::invalidate_department_names()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    names_.clear();
+}
+
+bool DepartmentsDb::in_bulk() const
+{
+    return connection().in_bulk;
+}
+
+std::string DepartmentsDb::get_department_name(const std::string& department_id, const std::list<std::string>& locales)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    for (auto const& locale: locales)
+    {
+        auto const& names = names_for_locale(locale);
+        auto it = names.find(department_id);
+        if (it != names.end())
         {
-            auto const res = select_dept_name_->value(0).toString().toStdString();
-            select_dept_name_->finish();
-            return res;
+            return it->second;
         }
     }
-    select_dept_name_->finish();
     throw std::logic_error("No name for department " + department_id);
 }
 
 std::string DepartmentsDb::get_parent_department_id(const std::string& department_id)
 {
-    select_parent_dept_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    if (!select_parent_dept_->exec())
+    auto& conn = connection();
+    if (auto snap = snapshot())
     {
-        report_db_error(select_parent_dept_->lastError(), "Failed to query for parent department " + department_id);
+        return snap->parent_of(department_id);
     }
-    if (!select_parent_dept_->next())
+
+    conn.select_parent_dept->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+    if (!conn.select_parent_dept->exec())
     {
-        select_dept_name_->finish();
+        report_db_error(conn.select_parent_dept->lastError(), "Failed to query for parent department " + department_id);
+    }
+    if (!conn.select_parent_dept->next())
+    {
+        conn.select_parent_dept->finish();
         throw std::logic_error("Unknown department '" + department_id + "'");
     }
-    auto const res = select_parent_dept_->value(0).toString().toStdString();
-    select_parent_dept_->finish();
+    auto const res = conn.select_parent_dept->value(0).toString().toStdString();
+    conn.select_parent_dept->finish();
     return res;
 }
 
 std::list<DepartmentsDb::DepartmentInfo> DepartmentsDb::get_children_departments(const std::string& department_id)
 {
-    select_children_depts_->bindValue(":parentid", QVariant(QString::fromStdString(department_id)));
-    if (!select_children_depts_->exec())
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        std::list<DepartmentInfo> depts;
+        for (auto const& child: snap->children_of(department_id))
+        {
+            depts.push_back(DepartmentInfo(child.first, child.second));
+        }
+        return depts;
+    }
+
+    conn.select_children_depts->bindValue(":parentid", QVariant(QString::fromStdString(department_id)));
+    if (!conn.select_children_depts->exec())
     {
-        report_db_error(select_children_depts_->lastError(), "Failed to query for children departments of " + department_id);
+        report_db_error(conn.select_children_depts->lastError(), "Failed to query for children departments of " + department_id);
     }
 
     std::list<DepartmentInfo> depts;
-    while (select_children_depts_->next())
+    while (conn.select_children_depts->next())
     {
-        auto const child_id = select_children_depts_->value(0).toString().toStdString();
-        const DepartmentInfo inf(child_id, select_children_depts_->value(1).toBool());
+        auto const child_id = conn.select_children_depts->value(0).toString().toStdString();
+        const DepartmentInfo inf(child_id, conn.select_children_depts->value(1).toBool());
         depts.push_back(inf);
     }
 
-    select_children_depts_->finish();
+    conn.select_children_depts->finish();
 
     return depts;
 }
 
 bool DepartmentsDb::is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id)
 {
-    select_is_descendant_of_dept_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    select_is_descendant_of_dept_->bindValue(":parentid", QVariant(QString::fromStdString(parent_department_id)));
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        return snap->is_descendant_of(department_id, parent_department_id);
+    }
 
-    if (!select_is_descendant_of_dept_->exec() || !select_is_descendant_of_dept_->next())
+    conn.select_is_descendant_of_dept->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+    conn.select_is_descendant_of_dept->bindValue(":parentid", QVariant(QString::fromStdString(parent_department_id)));
+
+    if (!conn.select_is_descendant_of_dept->exec() || !conn.select_is_descendant_of_dept->next())
     {
-        report_db_error(select_is_descendant_of_dept_->lastError(), "Failed to query for package count of department " + department_id);
+        report_db_error(conn.select_is_descendant_of_dept->lastError(), "Failed to query for package count of department " + department_id);
     }
-    auto cnt = select_is_descendant_of_dept_->value(0).toInt();
-    select_is_descendant_of_dept_->finish();
+    auto cnt = conn.select_is_descendant_of_dept->value(0).toInt();
+    conn.select_is_descendant_of_dept->finish();
 
     return cnt > 0;
 }
 
+std::unordered_map<std::string, std::string> DepartmentsDb::get_top_departments_under(const std::string& department_id)
+{
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        return snap->top_departments_under(department_id);
+    }
+
+    conn.select_top_depts_under->bindValue(":parentid", QVariant(QString::fromStdString(department_id)));
+    if (!conn.select_top_depts_under->exec())
+    {
+        report_db_error(conn.select_top_depts_under->lastError(), "Failed to query for subdepartments of " + department_id);
+    }
+
+    std::unordered_map<std::string, std::string> tops;
+    while (conn.select_top_depts_under->next())
+    {
+        tops.insert(std::make_pair(conn.select_top_depts_under->value(0).toString().toStdString(),
+                                   conn.select_top_depts_under->value(1).toString().toStdString()));
+    }
+    conn.select_top_depts_under->finish();
+    return tops;
+}
+
 bool DepartmentsDb::is_empty(const std::string& department_id)
 {
-    select_pkgs_count_in_dept_recursive_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    if (!select_pkgs_count_in_dept_recursive_->exec() || !select_pkgs_count_in_dept_recursive_->next())
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        return snap->is_empty(department_id);
+    }
+
+    conn.select_pkgs_count_in_dept_recursive->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+    if (!conn.select_pkgs_count_in_dept_recursive->exec() || !conn.select_pkgs_count_in_dept_recursive->next())
     {
-        report_db_error(select_pkgs_count_in_dept_recursive_->lastError(), "Failed to query for package count of department " + department_id);
+        report_db_error(conn.select_pkgs_count_in_dept_recursive->lastError(), "Failed to query for package count of department " + department_id);
     }
-    auto cnt = select_pkgs_count_in_dept_recursive_->value(0).toInt();
-    select_pkgs_count_in_dept_recursive_->finish();
+    auto cnt = conn.select_pkgs_count_in_dept_recursive->value(0).toInt();
+    conn.select_pkgs_count_in_dept_recursive->finish();
     return cnt == 0;
 }
 
 std::unordered_set<std::string> DepartmentsDb::get_packages_for_department(const std::string& department_id, bool recursive)
 {
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        return snap->packages_of(department_id, recursive);
+    }
+
     std::unordered_set<std::string> pkgs;
-    QSqlQuery *query = recursive ? select_pkgs_by_dept_recursive_.get() : select_pkgs_by_dept_.get();
+    QSqlQuery *query = recursive ? conn.select_pkgs_by_dept_recursive.get() : conn.select_pkgs_by_dept.get();
     query->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
     if (!query->exec())
     {
@@ -276,41 +753,111 @@ std::unordered_set<std::string> DepartmentsDb::get_packages_for_department(const
 
 std::string DepartmentsDb::get_department_for_package(const std::string& package_id)
 {
-    select_dept_for_pkg_->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
-    if (!select_dept_for_pkg_->exec())
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        auto dept = snap->department_of(package_id);
+        if (dept == nullptr)
+        {
+            throw std::logic_error("Unknown package '" + package_id + "'");
+        }
+        return *dept;
+    }
+
+    conn.select_dept_for_pkg->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
+    if (!conn.select_dept_for_pkg->exec())
     {
-        report_db_error(select_dept_for_pkg_->lastError(), "Failed to query for department of package " + package_id);
+        report_db_error(conn.select_dept_for_pkg->lastError(), "Failed to query for department of package " + package_id);
     }
-    if (!select_dept_for_pkg_->next())
+    if (!conn.select_dept_for_pkg->next())
     {
-        select_dept_for_pkg_->finish();
+        conn.select_dept_for_pkg->finish();
         throw std::logic_error("Unknown package '" + package_id + "'");
     }
-    auto const res = select_dept_for_pkg_->value(0).toString().toStdString();
-    select_dept_for_pkg_->finish();
+    auto const res = conn.select_dept_for_pkg->value(0).toString().toStdString();
+    conn.select_dept_for_pkg->finish();
     return res;
 
 }
 
+std::unordered_map<std::string, std::string> DepartmentsDb::get_departments_for_packages(const std::vector<std::string>& package_ids)
+{
+    auto& conn = connection();
+    std::unordered_map<std::string, std::string> depts;
+    if (auto snap = snapshot())
+    {
+        for (auto const& pkg: package_ids)
+        {
+            if (auto dept = snap->department_of(pkg))
+            {
+                depts[pkg] = *dept;
+            }
+        }
+        return depts;
+    }
+
+    // stay well below SQLITE_MAX_VARIABLE_NUMBER, which defaults to 999
+    static const std::size_t max_chunk = 500;
+
+    QSqlQuery query(conn.db);
+    for (std::size_t first = 0; first < package_ids.size(); first += max_chunk)
+    {
+        const std::size_t count = std::min(max_chunk, package_ids.size() - first);
+        std::string sql("SELECT pkgid, deptid FROM pkgmap WHERE pkgid IN (");
+        for (std::size_t i = 0; i < count; i++)
+        {
+            sql += i == 0 ? "?" : ",?";
+        }
+        sql += ") ORDER BY pkgid, deptid";
+
+        if (!query.prepare(QString::fromStdString(sql)))
+        {
+            report_db_error(query.lastError(), "Failed to prepare query for departments of packages");
+        }
+        for (std::size_t i = 0; i < count; i++)
+        {
+            query.addBindValue(QVariant(QString::fromStdString(package_ids[first + i])));
+        }
+        if (!query.exec())
+        {
+            report_db_error(query.lastError(), "Failed to query for departments of packages");
+        }
+        while (query.next())
+        {
+            // like get_department_for_package(), keep the first department of a package
+            depts.insert(std::make_pair(query.value(0).toString().toStdString(), query.value(1).toString().toStdString()));
+        }
+        query.finish();
+    }
+    return depts;
+}
+
 bool DepartmentsDb::has_package(const std::string& package_id)
 {
-    select_pkg_by_pkgid_->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
-    if (!select_pkg_by_pkgid_->exec())
+    auto& conn = connection();
+    if (auto snap = snapshot())
+    {
+        return snap->has_package(package_id);
+    }
+
+    conn.select_pkg_by_pkgid->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
+    if (!conn.select_pkg_by_pkgid->exec())
     {
-        report_db_error(select_parent_dept_->lastError(), "Failed to query for package " + package_id);
+        report_db_error(conn.select_parent_dept->lastError(), "Failed to query for package " + package_id);
     }
-    if (!select_pkg_by_pkgid_->next())
+    if (!conn.select_pkg_by_pkgid->next())
     {
-        select_pkg_by_pkgid_->finish();
+        conn.select_pkg_by_pkgid->finish();
         return false;
     }
-    select_pkg_by_pkgid_->finish();
+    conn.select_pkg_by_pkgid->finish();
     return true;
 
 }
 
-void DepartmentsDb::store_package_mapping(const std::string& package_id, const std::string& department_id)
+void DepartmentsDb::store_package_mapping_(const std::string& package_id, const std::string& department_id)
 {
+    auto& conn = connection();
     if (package_id.empty())
     {
         throw std::logic_error("Invalid empty package_id");
@@ -321,54 +868,328 @@ void DepartmentsDb::store_package_mapping(const std::string& package_id, const s
         throw std::logic_error("Invalid empty department id");
     }
 
-    if (!db_.transaction())
+    invalidate_snapshot();
+
+    // delete package mapping first from any departments
+    conn.delete_pkgmap_query->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
+    conn.delete_pkgmap_query->exec();
+    conn.delete_pkgmap_query->finish();
+
+    conn.insert_pkgmap_query->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
+    conn.insert_pkgmap_query->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+    if (!conn.insert_pkgmap_query->exec())
     {
-        std::cerr << "Failed to start transaction" << std::endl;
+        report_db_error(conn.insert_pkgmap_query->lastError(), "Failed to insert into pkgmap");
     }
 
-    // delete package mapping first from any departments
-    delete_pkgmap_query_->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
-    delete_pkgmap_query_->exec();
-    delete_pkgmap_query_->finish();
+    conn.insert_pkgmap_query->finish();
+}
 
-    insert_pkgmap_query_->bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
-    insert_pkgmap_query_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    if (!insert_pkgmap_query_->exec())
+void DepartmentsDb::store_package_mapping(const std::string& package_id, const std::string& department_id)
+{
+    auto& conn = connection();
+    if (conn.in_bulk)
     {
-        if (!db_.rollback())
+        store_package_mapping_(package_id, department_id);
+        return;
+    }
+
+    if (!conn.db.transaction())
+    {
+        qWarning() << "Failed to start transaction";
+    }
+
+    try
+    {
+        store_package_mapping_(package_id, department_id);
+    }
+    catch (...)
+    {
+        if (!conn.db.rollback())
         {
-            std::cerr << "Failed to rollback transaction" << std::endl;
+            qWarning() << "Failed to rollback transaction";
         }
-        report_db_error(insert_pkgmap_query_->lastError(), "Failed to insert into pkgmap");
+        throw;
+    }
+
+    if (!conn.db.commit())
+    {
+        conn.db.rollback();
+        report_db_error(conn.db.lastError(), "Failed to commit transaction in store_package_mapping");
     }
+}
 
-    insert_pkgmap_query_->finish();
+std::unordered_map<std::string, std::string> DepartmentsDb::get_package_versions()
+{
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+    if (!query.exec(departments_sql::SELECT_PKGMAP_VERSIONS))
+    {
+        report_db_error(query.lastError(), "Failed to query for package versions");
+    }
+    std::unordered_map<std::string, std::string> versions;
+    while (query.next())
+    {
+        versions[query.value(0).toString().toStdString()] = query.value(1).toString().toStdString();
+    }
+    query.finish();
+    return versions;
+}
+
+void DepartmentsDb::store_package_version(const std::string& package_id, const std::string& version)
+{
+    auto& conn = connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("Package versions can only be stored in a bulk load");
+    }
 
-    if (!db_.commit())
+    QSqlQuery query(conn.db);
+    query.prepare(departments_sql::UPDATE_PKGMAP_VERSION);
+    query.bindValue(":pkgid", QVariant(QString::fromStdString(package_id)));
+    query.bindValue(":version", QVariant(QString::fromStdString(version)));
+    if (!query.exec())
     {
-        db_.rollback();
-        report_db_error(db_.lastError(), "Failed to commit transaction in store_package_mapping");
+        report_db_error(query.lastError(), "Failed to store version of package " + package_id);
     }
+    query.finish();
+}
+
+void DepartmentsDb::remove_all()
+{
+    auto& conn = connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("Departments can only be removed in a bulk load");
+    }
+
+    invalidate_snapshot();
+    invalidate_department_names();
+    QSqlQuery query(conn.db);
+    for (auto const sql: {departments_sql::DELETE_ALL_PKGMAP, departments_sql::DELETE_DEPTS, departments_sql::DELETE_ALL_DEPTNAMES})
+    {
+        if (!query.exec(sql))
+        {
+            report_db_error(query.lastError(), "Failed to remove departments");
+        }
+    }
+    query.finish();
+    rebuild_closure();
+}
+
+std::unordered_map<std::string, std::string> DepartmentsDb::get_meta(const std::string& prefix)
+{
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+    query.prepare(departments_sql::SELECT_META);
+    query.bindValue(":prefix", QVariant(QString::fromStdString(prefix)));
+    if (!query.exec())
+    {
+        report_db_error(query.lastError(), "Failed to query meta table");
+    }
+    std::unordered_map<std::string, std::string> values;
+    while (query.next())
+    {
+        values[query.value(0).toString().toStdString()] = query.value(1).toString().toStdString();
+    }
+    query.finish();
+    return values;
+}
+
+void DepartmentsDb::store_meta(const std::string& name, const std::string& value)
+{
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+    query.prepare(departments_sql::INSERT_META);
+    query.bindValue(":name", QVariant(QString::fromStdString(name)));
+    query.bindValue(":value", QVariant(QString::fromStdString(value)));
+    if (!query.exec())
+    {
+        report_db_error(query.lastError(), "Failed to store meta value " + name);
+    }
+    query.finish();
+}
+
+void DepartmentsDb::remove_meta(const std::string& prefix)
+{
+    if (prefix.empty())
+    {
+        throw std::logic_error("Refusing to remove all meta values");
+    }
+
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+    query.prepare(departments_sql::DELETE_META);
+    query.bindValue(":prefix", QVariant(QString::fromStdString(prefix)));
+    if (!query.exec())
+    {
+        report_db_error(query.lastError(), "Failed to remove meta values " + prefix);
+    }
+    query.finish();
+}
+
+void DepartmentsDb::begin_bulk(bool relax_sync)
+{
+    auto& conn = connection();
+    if (conn.in_bulk)
+    {
+        throw std::logic_error("Bulk load already in progress");
+    }
+
+    if (relax_sync)
+    {
+        // synchronous can't be changed within a transaction
+        QSqlQuery query(conn.db);
+        if (query.exec("PRAGMA synchronous") && query.next())
+        {
+            conn.bulk_synchronous = query.value(0).toInt();
+            query.finish();
+            if (!query.exec("PRAGMA synchronous=OFF"))
+            {
+                conn.bulk_synchronous = -1;
+                qWarning() << "Failed to relax synchronous writes:" << query.lastError().text();
+            }
+        }
+    }
+
+    if (!conn.db.transaction())
+    {
+        restore_synchronous();
+        report_db_error(conn.db.lastError(), "Failed to start bulk transaction");
+    }
+    conn.in_bulk = true;
+}
+
+void DepartmentsDb::commit_bulk()
+{
+    auto& conn = connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("No bulk load in progress");
+    }
+    conn.in_bulk = false;
+
+    if (!conn.db.commit())
+    {
+        auto const error = conn.db.lastError();
+        conn.db.rollback();
+        restore_synchronous();
+        report_db_error(error, "Failed to commit bulk transaction");
+    }
+    restore_synchronous();
+}
+
+void DepartmentsDb::rollback_bulk()
+{
+    auto& conn = connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("No bulk load in progress");
+    }
+    conn.in_bulk = false;
+
+    invalidate_snapshot();
+    if (!conn.db.rollback())
+    {
+        qWarning() << "Failed to rollback transaction";
+    }
+    restore_synchronous();
+}
+
+void DepartmentsDb::restore_synchronous()
+{
+    auto& conn = connection();
+    if (conn.bulk_synchronous < 0)
+    {
+        return;
+    }
+    QSqlQuery query(conn.db);
+    if (!query.exec(QString::fromStdString("PRAGMA synchronous=" + std::to_string(conn.bulk_synchronous))))
+    {
+        qWarning() << "Failed to restore synchronous writes:" << query.lastError().text();
+    }
+    conn.bulk_synchronous = -1;
 }
 
 void DepartmentsDb::store_department_mapping(const std::string& department_id, const std::string& parent_department_id)
 {
+    auto& conn = connection();
     if (department_id.empty())
     {
         throw std::logic_error("Invalid empty department id");
     }
 
-    insert_dept_id_query_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    insert_dept_id_query_->bindValue(":parentid", QVariant(QString::fromStdString(parent_department_id)));
-    if (!insert_dept_id_query_->exec())
+    invalidate_snapshot();
+
+    // within store_departments() and bulk loads the mapping becomes part of
+    // their transaction; otherwise readers must not see the closure while
+    // it is rebuilt
+    const bool own_transaction = !conn.in_bulk && !conn.storing_departments;
+    if (own_transaction && !conn.db.transaction())
+    {
+        qWarning() << "Failed to start transaction";
+    }
+
+    try
     {
-        report_db_error(insert_dept_id_query_->lastError(), "Failed to insert into depts");
+        conn.insert_dept_id_query->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+        conn.insert_dept_id_query->bindValue(":parentid", QVariant(QString::fromStdString(parent_department_id)));
+        if (!conn.insert_dept_id_query->exec())
+        {
+            report_db_error(conn.insert_dept_id_query->lastError(), "Failed to insert into depts");
+        }
+        conn.insert_dept_id_query->finish();
+
+        // store_departments() rebuilds the closure once all mappings are stored
+        if (!conn.storing_departments)
+        {
+            rebuild_closure();
+        }
+    }
+    catch (...)
+    {
+        if (own_transaction && !conn.db.rollback())
+        {
+            qWarning() << "Failed to rollback transaction";
+        }
+        throw;
+    }
+
+    if (own_transaction && !conn.db.commit())
+    {
+        conn.db.rollback();
+        report_db_error(conn.db.lastError(), "Failed to commit transaction in store_department_mapping");
     }
-    insert_dept_id_query_->finish();
+}
+
+void DepartmentsDb::rebuild_closure()
+{
+    auto& conn = connection();
+    if (!has_closure_)
+    {
+        return;
+    }
+
+    if (!conn.delete_closure_query->exec())
+    {
+        report_db_error(conn.delete_closure_query->lastError(), "Failed to delete from dept_closure");
+    }
+    conn.delete_closure_query->finish();
+    if (!conn.insert_closure_self_query->exec())
+    {
+        report_db_error(conn.insert_closure_self_query->lastError(), "Failed to insert into dept_closure");
+    }
+    conn.insert_closure_self_query->finish();
+    if (!conn.insert_closure_query->exec())
+    {
+        report_db_error(conn.insert_closure_query->lastError(), "Failed to insert into dept_closure");
+    }
+    conn.insert_closure_query->finish();
 }
 
 void DepartmentsDb::store_department_name(const std::string& department_id, const std::string& locale, const std::string& name)
 {
+    auto& conn = connection();
     if (department_id.empty())
     {
         throw std::logic_error("Invalid empty department id");
@@ -379,20 +1200,22 @@ void DepartmentsDb::store_department_name(const std::string& department_id, cons
         throw std::logic_error("Invalid empty department name");
     }
 
-    insert_dept_name_query_->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
-    insert_dept_name_query_->bindValue(":locale", QVariant(QString::fromStdString(locale)));
-    insert_dept_name_query_->bindValue(":name", QVariant(QString::fromStdString(name)));
+    conn.insert_dept_name_query->bindValue(":deptid", QVariant(QString::fromStdString(department_id)));
+    conn.insert_dept_name_query->bindValue(":locale", QVariant(QString::fromStdString(locale)));
+    conn.insert_dept_name_query->bindValue(":name", QVariant(QString::fromStdString(name)));
 
-    if (!insert_dept_name_query_->exec())
+    if (!conn.insert_dept_name_query->exec())
     {
-        report_db_error(insert_dept_name_query_->lastError(), "Failed to insert into deptnames");
+        report_db_error(conn.insert_dept_name_query->lastError(), "Failed to insert into deptnames");
     }
-    insert_dept_name_query_->finish();
+    conn.insert_dept_name_query->finish();
+    invalidate_department_names(locale);
 }
 
 int DepartmentsDb::department_mapping_count() const
 {
-    QSqlQuery q(db_);
+    auto& conn = connection();
+    QSqlQuery q(conn.db);
     if (!q.exec("SELECT COUNT(*) FROM depts") || !q.next())
     {
         report_db_error(q.lastError(), "Failed to query depts table");
@@ -402,7 +1225,8 @@ int DepartmentsDb::department_mapping_count() const
 
 int DepartmentsDb::package_count() const
 {
-    QSqlQuery q(db_);
+    auto& conn = connection();
+    QSqlQuery q(conn.db);
     if (!q.exec("SELECT COUNT(*) FROM pkgmap") || !q.next())
     {
         report_db_error(q.lastError(), "Failed to query pkgmap table");
@@ -412,7 +1236,8 @@ int DepartmentsDb::package_count() const
 
 int DepartmentsDb::department_name_count() const
 {
-    QSqlQuery q(db_);
+    auto& conn = connection();
+    QSqlQuery q(conn.db);
     if (!q.exec("SELECT COUNT(*) FROM deptnames") || !q.next())
     {
         report_db_error(q.lastError(), "Failed to query deptnames table");
@@ -420,6 +1245,58 @@ int DepartmentsDb::department_name_count() const
     return q.value(0).toInt();
 }
 
+void DepartmentsDb::export_mapped(const std::string& path)
+{
+    auto& conn = connection();
+    QSqlQuery query(conn.db);
+
+    // move committed changes into the database file, so that readers find
+    // an empty -wal file (see MappedDepartmentsDb)
+    if (!query.exec("PRAGMA wal_checkpoint(TRUNCATE)"))
+    {
+        qWarning() << "Failed to checkpoint departments database:" << query.lastError().text();
+    }
+    query.finish();
+
+    // the stamps are taken before reading, so that changes made meanwhile
+    // leave the file stale rather than with data older than its stamps
+    FileStamp stamps[2];
+    stamp_db_files(stamps);
+
+    // read everything from the same state of the database, through the
+    // connection of the transaction also in subclasses
+    const bool own_transaction = !conn.in_bulk;
+    if (own_transaction && !conn.db.transaction())
+    {
+        report_db_error(conn.db.lastError(), "Failed to start transaction");
+    }
+    Rows depts, pkgmap;
+    std::vector<MappedDepartments::Name> names;
+    if (!DepartmentsDb::load_hierarchy(depts, pkgmap) || !query.exec(departments_sql::SELECT_ALL_DEPT_NAMES))
+    {
+        if (own_transaction)
+        {
+            conn.db.rollback();
+        }
+        throw std::runtime_error("Failed to load departments");
+    }
+    while (query.next())
+    {
+        MappedDepartments::Name name;
+        name.department_id = query.value(0).toString().toStdString();
+        name.locale = query.value(1).toString().toStdString();
+        name.name = query.value(2).toString().toStdString();
+        names.push_back(name);
+    }
+    query.finish();
+    if (own_transaction)
+    {
+        conn.db.commit();
+    }
+
+    MappedDepartments::write(path, stamps, depts, pkgmap, names);
+}
+
 void DepartmentsDb::store_departments_(const click::DepartmentList& depts, const std::string& locale)
 {
     for (auto const& dept: depts)
@@ -435,40 +1312,67 @@ void DepartmentsDb::store_departments_(const click::DepartmentList& depts, const
 
 void DepartmentsDb::store_departments(const click::DepartmentList& depts, const std::string& locale)
 {
-    if (!db_.transaction())
+    auto& conn = connection();
+    invalidate_snapshot();
+
+    // within a bulk load the departments become part of it
+    const bool own_transaction = !conn.in_bulk;
+    if (own_transaction && !conn.db.transaction())
     {
-        std::cerr << "Failed to start transaction" << std::endl;
+        qWarning() << "Failed to start transaction";
     }
 
     //
     // delete existing departments for given locale first
-    delete_deptnames_query_->bindValue(":locale", QVariant(QString::fromStdString(locale)));
-    if (!delete_deptnames_query_->exec())
+    conn.delete_deptnames_query->bindValue(":locale", QVariant(QString::fromStdString(locale)));
+    if (!conn.delete_deptnames_query->exec())
     {
-        db_.rollback();
-        report_db_error(delete_deptnames_query_->lastError(), "Failed to delete from deptnames");
+        if (own_transaction)
+        {
+            conn.db.rollback();
+        }
+        report_db_error(conn.delete_deptnames_query->lastError(), "Failed to delete from deptnames");
     }
-    if (!delete_depts_query_->exec())
+    if (!conn.delete_depts_query->exec())
     {
-        db_.rollback();
-        report_db_error(delete_depts_query_->lastError(), "Failed to delete from depts");
+        if (own_transaction)
+        {
+            conn.db.rollback();
+        }
+        report_db_error(conn.delete_depts_query->lastError(), "Failed to delete from depts");
     }
 
-    delete_deptnames_query_->finish();
-    delete_depts_query_->finish();
+    conn.delete_deptnames_query->finish();
+    conn.delete_depts_query->finish();
+    invalidate_department_names(locale);
 
-    // store mapping of top level departments to root ""
-    for (auto const& dept: depts)
+    conn.storing_departments = true;
+    try
     {
-        store_department_mapping(dept->id(), "");
-    }
+        // store mapping of top level departments to root ""
+        for (auto const& dept: depts)
+        {
+            store_department_mapping(dept->id(), "");
+        }
 
-    store_departments_(depts, locale);
+        store_departments_(depts, locale);
+        conn.storing_departments = false;
+        rebuild_closure();
+    }
+    catch (...)
+    {
+        conn.storing_departments = false;
+        if (own_transaction)
+        {
+            conn.db.rollback();
+        }
+        throw;
+    }
 
-    if (!db_.commit())
+    if (own_transaction && !conn.db.commit())
     {
-        db_.rollback();
-        report_db_error(db_.lastError(), "Failed to commit transaction in store_departments");
+        conn.db.rollback();
+        report_db_error(conn.db.lastError(), "Failed to commit transaction in store_departments");
     }
 }
 
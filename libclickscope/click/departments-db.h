@@ -31,19 +31,31 @@
 #define CLICK_DEPARTMENTS_DB_H
 
 #include <click/departments.h>
+#include <click/file-stamp.h>
+#include <click/thread-connections.h>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 #include <list>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <memory>
+#include <cstdint>
+#include <atomic>
 
 class QSqlError;
 
 namespace click
 {
 
+class DepartmentsSnapshot;
+
 class DepartmentsDb
 {
 public:
@@ -59,6 +71,28 @@ public:
         }
     };
 
+    // sqlite settings of the connections to the database
+    struct Profile
+    {
+        // PRAGMA mmap_size in bytes, or -1 to keep the sqlite default
+        std::int64_t mmap_size = 16 * 1024 * 1024;
+        // PRAGMA cache_size, in KiB if negative, or 0 to keep the sqlite default
+        int cache_size = -4096;
+        // PRAGMA temp_store=MEMORY
+        bool temp_store_memory = true;
+        // PRAGMA query_only, for databases that are only read
+        bool query_only = false;
+
+        // The defaults above, or the sqlite defaults if
+        // CLICK_SCOPE_DEPARTMENTS_PROFILE is set to "sqlite".
+        static Profile from_env();
+        std::vector<std::string> pragmas() const;
+    };
+
+    // Methods may be called from several threads at once; each thread uses
+    // a connection of its own to the database, which is switched to WAL
+    // mode so that readers don't block each other. A bulk load belongs to
+    // the thread that called begin_bulk().
     DepartmentsDb(const std::string& name, bool create = true);
     DepartmentsDb(const DepartmentsDb& other) = delete;
     DepartmentsDb& operator=(const DepartmentsDb&) = delete;
@@ -67,13 +101,39 @@ public:
     virtual std::string get_department_name(const std::string& department_id, const std::list<std::string>& locales);
     virtual std::unordered_set<std::string> get_packages_for_department(const std::string& department_id, bool recursive = true);
     virtual std::string get_department_for_package(const std::string& package_id);
+    // Like get_department_for_package() for all the given packages at once;
+    // packages that aren't in the database are left out of the result.
+    virtual std::unordered_map<std::string, std::string> get_departments_for_packages(const std::vector<std::string>& package_ids);
     virtual bool is_empty(const std::string& department_id);
     virtual bool has_package(const std::string& package_id);
     virtual std::string get_parent_department_id(const std::string& department_id);
     virtual std::list<DepartmentInfo> get_children_departments(const std::string& department_id);
     virtual bool is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id);
+    // Maps every department below department_id to the direct child of
+    // department_id it descends from (children map to themselves), with a
+    // single query.
+    virtual std::unordered_map<std::string, std::string> get_top_departments_under(const std::string& department_id);
 
     virtual void store_package_mapping(const std::string& package_id, const std::string& department_id);
+    // Stores (package id, department id) pairs; within a bulk load they
+    // become part of it, otherwise they are stored in one transaction.
+    template <typename Range>
+    void store_package_mappings(const Range& mappings);
+    // Versions recorded with store_package_version(), by package id; empty
+    // for packages stored without one.
+    virtual std::unordered_map<std::string, std::string> get_package_versions();
+    // Only within a bulk load: records the version of a package stored before.
+    virtual void store_package_version(const std::string& package_id, const std::string& version);
+    // Only within a bulk load: removes all package mappings, departments
+    // and department names, for loads that replace all of them.
+    virtual void remove_all();
+    // Rows of the meta table whose name starts with prefix, by name, and
+    // writes to it; within a bulk load writes become part of it. Tools keep
+    // their own state there, such as the progress of an interrupted run.
+    virtual std::unordered_map<std::string, std::string> get_meta(const std::string& prefix);
+    virtual void store_meta(const std::string& name, const std::string& value);
+    // Removes the rows whose name starts with the (non-empty) prefix.
+    virtual void remove_meta(const std::string& prefix);
     virtual void store_department_mapping(const std::string& department_id, const std::string& parent_department_id);
     virtual void store_department_name(const std::string& department_id, const std::string& locale, const std::string& name);
 
@@ -82,33 +142,200 @@ public:
     virtual int package_count() const;
     virtual int department_name_count() const;
 
+    // Replaces the departments of the given locale; within a bulk load they
+    // become part of it, otherwise they are stored in one transaction.
     virtual void store_departments(const click::DepartmentList& depts, const std::string& locale);
 
-    static std::unique_ptr<DepartmentsDb> open(bool create = true);
+    // Package mappings stored between begin_bulk() and commit_bulk() share a
+    // single transaction instead of committing one each. With relax_sync,
+    // sqlite doesn't wait for writes to reach the disk until commit_bulk(),
+    // so a power loss during the load may leave the database corrupt; only
+    // use it for databases that can be regenerated.
+    virtual void begin_bulk(bool relax_sync = false);
+    virtual void commit_bulk();
+    virtual void rollback_bulk();
+
+    // Writes the hierarchy, the package mappings and the names of all
+    // locales to a MappedDepartments file (see mapped-departments.h).
+    virtual void export_mapped(const std::string& path);
+
+    // The profile applies to the connections opened afterwards, so it should
+    // be set right after opening the database; it defaults to
+    // Profile::from_env().
+    void set_profile(const Profile& profile);
+    Profile profile() const;
+
+    // Increases whenever the database files were changed since the previous
+    // call, so that results computed from the database can be tied to what
+    // it contained.
+    std::uint64_t generation();
+
+    // Reads the indexes of the database on a background thread, so that the
+    // first lookups don't wait for the disk. Returns right away. With
+    // write_mapped, the thread then also writes mapped_path() unless an
+    // up-to-date file exists, for the next open() that uses it.
+    virtual void warm_up(bool write_mapped = false);
+    // True once the database has nothing left to warm up.
+    virtual bool warmed_up();
+
+    constexpr static const char* ENV_BACKEND {"CLICK_SCOPE_DEPARTMENTS_BACKEND"};
+    constexpr static const char* ENV_PROFILE {"CLICK_SCOPE_DEPARTMENTS_PROFILE"};
+
+    // Opens the database in the cache directory, or at the given path. The
+    // implementation is DepartmentsDb, or NativeDepartmentsDb if
+    // CLICK_SCOPE_DEPARTMENTS_BACKEND is set to "sqlite3". With use_mapped
+    // and without a backend set, databases that aren't created are read
+    // through MappedDepartmentsDb if an up-to-date mapped_path() file
+    // exists; only readers should ask for that, as writes stop using it.
+    static std::unique_ptr<DepartmentsDb> open(bool create = true, bool use_mapped = false);
+    static std::unique_ptr<DepartmentsDb> open_file(const std::string& path, bool create = true, bool use_mapped = false);
+    // path of the MappedDepartments file written for the database at db_path
+    static std::string mapped_path(const std::string& db_path);
 
 protected:
-    void init_db();
+    // For implementations that don't touch the database until they need to;
+    // they have to call set_up() before using any method of DepartmentsDb.
+    struct Deferred {};
+    DepartmentsDb(const std::string& name, Deferred);
+    void set_up(bool create);
+
+    // Snapshot of the department hierarchy, reloaded whenever the database
+    // files changed since it was taken, or nullptr if the hierarchy can't
+    // be represented by one; callers then fall back to SQL.
+    std::shared_ptr<const DepartmentsSnapshot> snapshot();
+    void invalidate_snapshot();
+    void invalidate_department_names(const std::string& locale);
+    // of all locales
+    void invalidate_department_names();
+
+    // (first, second) pairs of (deptid, parentid) or (pkgid, deptid) rows
+    typedef std::vector<std::pair<std::string, std::string>> Rows;
+
+    // Hooks through which the snapshot and the department name cache are
+    // filled, for implementations that don't use QtSql. load_hierarchy()
+    // returns pkgmap rows ordered by pkgid and deptid, and false on errors.
+    virtual bool load_hierarchy(Rows& depts, Rows& pkgmap);
+    virtual std::unordered_map<std::string, std::string> load_department_names(const std::string& locale);
+    // True while the calling thread is within begin_bulk() and commit_bulk().
+    virtual bool in_bulk() const;
+
+    // Database connection of one thread. QSqlDatabase connections and
+    // their queries may only be used by the thread that created them, so
+    // every thread gets its own, with its own prepared statements.
+    struct Connection
+    {
+        QString name;
+        QSqlDatabase db;
+        std::unique_ptr<QSqlQuery> delete_pkgmap_query;
+        std::unique_ptr<QSqlQuery> delete_depts_query;
+        std::unique_ptr<QSqlQuery> delete_deptnames_query;
+        std::unique_ptr<QSqlQuery> insert_pkgmap_query;
+        std::unique_ptr<QSqlQuery> insert_dept_id_query;
+        std::unique_ptr<QSqlQuery> insert_dept_name_query;
+        std::unique_ptr<QSqlQuery> select_pkgs_by_dept;
+        std::unique_ptr<QSqlQuery> select_dept_for_pkg;
+        std::unique_ptr<QSqlQuery> select_pkg_by_pkgid;
+        std::unique_ptr<QSqlQuery> select_pkgs_by_dept_recursive;
+        std::unique_ptr<QSqlQuery> select_pkgs_count_in_dept_recursive;
+        std::unique_ptr<QSqlQuery> select_parent_dept;
+        std::unique_ptr<QSqlQuery> select_children_depts;
+        std::unique_ptr<QSqlQuery> select_dept_names;
+        std::unique_ptr<QSqlQuery> select_is_descendant_of_dept;
+        std::unique_ptr<QSqlQuery> select_top_depts_under;
+        std::unique_ptr<QSqlQuery> delete_closure_query;
+        std::unique_ptr<QSqlQuery> insert_closure_self_query;
+        std::unique_ptr<QSqlQuery> insert_closure_query;
+        bool storing_departments = false;
+        bool in_bulk = false;
+        // value of PRAGMA synchronous to restore after a relaxed bulk load, or -1
+        int bulk_synchronous = -1;
+    };
+
+    // Connection of the calling thread, opened on first use and closed
+    // when the thread exits.
+    Connection& connection() const;
+    // Closes the connection of the calling thread, if it has one.
+    void release_connection() const;
+
+    // Waits for warm_up() to finish; implementations that override the
+    // hooks used by it have to call this in their destructor.
+    void join_warm_up();
+
+    void init_db(QSqlDatabase& db);
+    // Stores a mapping without a transaction of its own.
+    virtual void store_package_mapping_(const std::string& package_id, const std::string& department_id);
+    // Recomputes dept_closure from depts; a no-op for databases without it.
+    void rebuild_closure();
     void store_departments_(const click::DepartmentList& depts, const std::string& locale);
     static void report_db_error(const QSqlError& error, const std::string& message);
 
-    QSqlDatabase db_;
-    std::unique_ptr<QSqlQuery> delete_pkgmap_query_;
-    std::unique_ptr<QSqlQuery> delete_depts_query_;
-    std::unique_ptr<QSqlQuery> delete_deptnames_query_;
-    std::unique_ptr<QSqlQuery> insert_pkgmap_query_;
-    std::unique_ptr<QSqlQuery> insert_dept_id_query_;
-    std::unique_ptr<QSqlQuery> insert_dept_name_query_;
-    std::unique_ptr<QSqlQuery> select_pkgs_by_dept_;
-    std::unique_ptr<QSqlQuery> select_dept_for_pkg_;
-    std::unique_ptr<QSqlQuery> select_pkg_by_pkgid_;
-    std::unique_ptr<QSqlQuery> select_pkgs_by_dept_recursive_;
-    std::unique_ptr<QSqlQuery> select_pkgs_count_in_dept_recursive_;
-    std::unique_ptr<QSqlQuery> select_parent_dept_;
-    std::unique_ptr<QSqlQuery> select_children_depts_;
-    std::unique_ptr<QSqlQuery> select_dept_name_;
-    std::unique_ptr<QSqlQuery> select_is_descendant_of_dept_;
+    bool has_closure_ = false;
+
+    // stamps of the database file and its -wal file
+    void stamp_db_files(FileStamp stamps[2]) const;
+
+private:
+    QSqlDatabase open_database(const QString& connection_name) const;
+    void prepare_queries(Connection& conn) const;
+    std::shared_ptr<const DepartmentsSnapshot> load_snapshot();
+    void restore_synchronous();
+    void run_warm_up(bool write_mapped);
+    // All department names of the given locale, loaded with one query and
+    // kept until the locale is rewritten or the database files change.
+    // cache_mutex_ must be held.
+    const std::unordered_map<std::string, std::string>& names_for_locale(const std::string& locale);
+
+    std::string db_path_;
+
+    ThreadConnections<Connection> connections_;
+    mutable std::mutex profile_mutex_;
+    Profile profile_;
+
+    std::mutex warm_up_mutex_;
+    std::thread warm_up_thread_;
+    std::atomic<bool> warmed_up_{false};
+
+    // guards the snapshot and the department names shared by all threads
+    std::mutex cache_mutex_;
+    bool snapshot_valid_ = false;
+    FileStamp snapshot_stamps_[2];
+    std::shared_ptr<const DepartmentsSnapshot> snapshot_;
+    bool names_valid_ = false;
+    FileStamp names_stamps_[2];
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> names_;
+    std::uint64_t generation_ = 0;
+    FileStamp generation_stamps_[2];
 };
 
+template <typename Range>
+void DepartmentsDb::store_package_mappings(const Range& mappings)
+{
+    const bool own_bulk = !in_bulk();
+    if (own_bulk)
+    {
+        begin_bulk();
+    }
+    try
+    {
+        for (auto const& mapping: mappings)
+        {
+            store_package_mapping_(mapping.first, mapping.second);
+        }
+    }
+    catch (...)
+    {
+        if (own_bulk)
+        {
+            rollback_bulk();
+        }
+        throw;
+    }
+    if (own_bulk)
+    {
+        commit_bulk();
+    }
+}
+
 }
 
 #endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "departments-import.h"
+
+#include <click/departments-db.h>
+#include <click/departments.h>
+#include <click/package.h>
+#include <click/worker-pool.h>
+
+#include <QDebug>
+#include <QDir>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace click
+{
+
+namespace
+{
+
+// A saved bootstrap or details response.
+struct Dump
+{
+    std::string path;
+    std::string locale;
+    DepartmentList departments;
+    PackageDetails details;
+    bool valid = false;
+};
+
+std::vector<Dump> list_dumps(const std::string& dir_path, bool departments)
+{
+    std::vector<Dump> dumps;
+    QDir dir(QString::fromStdString(dir_path), "*.json",
+             QDir::Name, QDir::Readable | QDir::Files);
+    for (auto const& entry: dir.entryInfoList())
+    {
+        Dump dump;
+        dump.path = entry.absoluteFilePath().toStdString();
+        if (departments)
+        {
+            dump.locale = entry.completeBaseName().toStdString();
+        }
+        dumps.push_back(dump);
+    }
+    return dumps;
+}
+
+bool read_file(const std::string& path, std::string& contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+std::chrono::milliseconds elapsed_since(const std::chrono::steady_clock::time_point& since)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since);
+}
+
+} // namespace
+
+DepartmentsImportStats import_departments(DepartmentsDb& db, const std::string& dir,
+                                          const std::list<std::pair<std::string, std::string>>& extra_mappings)
+{
+    DepartmentsImportStats stats;
+    auto const started = std::chrono::steady_clock::now();
+    auto bootstraps = list_dumps(dir + "/departments", true);
+    auto packages = list_dumps(dir + "/packages", false);
+    if (bootstraps.empty())
+    {
+        qWarning() << "No departments found in" << QString::fromStdString(dir + "/departments");
+        return stats;
+    }
+
+    // results land in their own slot, so that files are stored in the order they were listed
+    auto parse = [&bootstraps, &packages](std::size_t i) {
+        std::string json;
+        if (i < bootstraps.size())
+        {
+            auto& dump = bootstraps[i];
+            if (read_file(dump.path, json))
+            {
+                dump.departments = Department::from_json(json);
+                dump.valid = !dump.departments.empty();
+            }
+        }
+        else
+        {
+            auto& dump = packages[i - bootstraps.size()];
+            if (read_file(dump.path, json))
+            {
+                dump.details = PackageDetails::from_json(json);
+                dump.valid = !dump.details.package.name.empty() && !dump.details.department.empty();
+            }
+        }
+    };
+    parallel_for(bootstraps.size() + packages.size(), parse);
+    stats.parse_time = elapsed_since(started);
+
+    std::list<std::pair<std::string, std::string>> mappings;
+    for (auto const& dump: bootstraps)
+    {
+        if (dump.valid)
+        {
+            ++stats.locales;
+        }
+        else
+        {
+            qWarning() << "Invalid departments file" << QString::fromStdString(dump.path);
+            ++stats.invalid_files;
+        }
+    }
+    for (auto const& dump: packages)
+    {
+        if (dump.valid)
+        {
+            mappings.push_back(std::make_pair(dump.details.package.name, dump.details.department));
+            ++stats.packages;
+        }
+        else
+        {
+            qWarning() << "Invalid package details file" << QString::fromStdString(dump.path);
+            ++stats.invalid_files;
+        }
+    }
+    mappings.insert(mappings.end(), extra_mappings.begin(), extra_mappings.end());
+
+    auto const storing = std::chrono::steady_clock::now();
+    db.begin_bulk(true);
+    try
+    {
+        // the dumps replace everything stored before, in the same
+        // transaction, so that a failed import leaves the old data
+        db.remove_all();
+        for (auto const& dump: bootstraps)
+        {
+            if (dump.valid)
+            {
+                db.store_departments(dump.departments, dump.locale);
+            }
+        }
+        db.store_package_mappings(mappings);
+        for (auto const& dump: packages)
+        {
+            if (dump.valid && !dump.details.version.empty())
+            {
+                db.store_package_version(dump.details.package.name, dump.details.version);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        try
+        {
+            db.rollback_bulk();
+        }
+        catch (const std::exception& rollback_error)
+        {
+            qWarning() << "Failed to roll back departments import:" << rollback_error.what();
+        }
+        throw;
+    }
+    db.commit_bulk();
+    stats.store_time = elapsed_since(storing);
+    return stats;
+}
+
+} // namespace click
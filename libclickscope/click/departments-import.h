@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DEPARTMENTS_IMPORT_H
+#define CLICK_DEPARTMENTS_IMPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <utility>
+
+namespace click
+{
+
+class DepartmentsDb;
+
+struct DepartmentsImportStats
+{
+    std::size_t locales = 0;
+    std::size_t packages = 0;
+    // files that couldn't be read or parsed, and were skipped
+    std::size_t invalid_files = 0;
+    std::chrono::milliseconds parse_time {0};
+    std::chrono::milliseconds store_time {0};
+};
+
+// Fills db from saved server responses instead of the network:
+// dir/departments/LOCALE.json holds the bootstrap response for a locale and
+// dir/packages/*.json one details response each. Files are parsed on a pool
+// of worker threads, and everything stored before is replaced in a single
+// bulk load, together with extra_mappings (package id, department id).
+// Invalid files are logged and skipped. Nothing is stored if there is no
+// departments file; database errors roll the load back and are rethrown.
+DepartmentsImportStats import_departments(DepartmentsDb& db, const std::string& dir,
+                                          const std::list<std::pair<std::string, std::string>>& extra_mappings);
+
+} // namespace click
+
+#endif // CLICK_DEPARTMENTS_IMPORT_H
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "departments-snapshot.h"
+
+#include <stdexcept>
+
+namespace click
+{
+
+std::shared_ptr<const DepartmentsSnapshot> DepartmentsSnapshot::build(const Rows& depts, const Rows& pkgmap)
+{
+    std::shared_ptr<DepartmentsSnapshot> snapshot(new DepartmentsSnapshot());
+
+    for (auto const& row: depts)
+    {
+        const int child = snapshot->node_for(row.first);
+        const int parent = snapshot->node_for(row.second);
+        Node& node = snapshot->nodes[child];
+        if (node.present)
+        {
+            if (snapshot->nodes[node.parent].id != row.second)
+            {
+                return nullptr; // several parents
+            }
+            continue;
+        }
+        node.present = true;
+        node.parent = parent;
+        snapshot->nodes[parent].children.push_back(child);
+    }
+
+    for (auto const& row: pkgmap)
+    {
+        snapshot->nodes[snapshot->node_for(row.second)].packages.push_back(row.first);
+        // rows are ordered, so the first department of a package is the
+        // one the database returns for it
+        snapshot->package_departments.insert(row);
+    }
+
+    if (!snapshot->number_nodes())
+    {
+        return nullptr; // a cycle
+    }
+    return snapshot;
+}
+
+int DepartmentsSnapshot::node_for(const std::string& department_id)
+{
+    auto it = index.find(department_id);
+    if (it != index.end())
+    {
+        return it->second;
+    }
+    nodes.push_back(Node());
+    nodes.back().id = department_id;
+    const int n = static_cast<int>(nodes.size()) - 1;
+    index[department_id] = n;
+    return n;
+}
+
+const DepartmentsSnapshot::Node* DepartmentsSnapshot::find(const std::string& department_id) const
+{
+    auto it = index.find(department_id);
+    return it == index.end() ? nullptr : &nodes[it->second];
+}
+
+// Assigns Euler tour intervals starting from every root; nodes on a cycle
+// are not reachable from any root and leave the tour incomplete.
+bool DepartmentsSnapshot::number_nodes()
+{
+    tour.reserve(nodes.size());
+    std::vector<std::pair<int, std::size_t>> stack;
+    for (int root = 0; root < static_cast<int>(nodes.size()); root++)
+    {
+        if (nodes[root].parent >= 0)
+        {
+            continue;
+        }
+        nodes[root].enter = static_cast<int>(tour.size());
+        tour.push_back(root);
+        stack.push_back(std::make_pair(root, 0));
+        while (!stack.empty())
+        {
+            auto& top = stack.back();
+            const Node& node = nodes[top.first];
+            if (top.second < node.children.size())
+            {
+                const int child = node.children[top.second++];
+                nodes[child].enter = static_cast<int>(tour.size());
+                tour.push_back(child);
+                stack.push_back(std::make_pair(child, 0));
+            }
+            else
+            {
+                nodes[top.first].exit = static_cast<int>(tour.size());
+                stack.pop_back();
+            }
+        }
+    }
+    return tour.size() == nodes.size();
+}
+
+std::unordered_map<std::string, std::string> DepartmentsSnapshot::top_departments_under(const std::string& department_id) const
+{
+    std::unordered_map<std::string, std::string> tops;
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return tops;
+    }
+    for (auto child: node->children)
+    {
+        const Node& top = nodes[child];
+        for (int pos = top.enter; pos < top.exit; pos++)
+        {
+            tops[nodes[tour[pos]].id] = top.id;
+        }
+    }
+    return tops;
+}
+
+template <typename F>
+void DepartmentsSnapshot::for_each_recursive_package(const Node& node, F f) const
+{
+    // like the recursive queries, a department without a row in depts
+    // only contributes the packages of its subdepartments
+    for (int pos = node.present ? node.enter : node.enter + 1; pos < node.exit; pos++)
+    {
+        for (auto const& pkg: nodes[tour[pos]].packages)
+        {
+            f(pkg);
+        }
+    }
+}
+
+std::string DepartmentsSnapshot::parent_of(const std::string& department_id) const
+{
+    auto node = find(department_id);
+    if (node == nullptr || !node->present)
+    {
+        throw std::logic_error("Unknown department '" + department_id + "'");
+    }
+    return nodes[node->parent].id;
+}
+
+std::vector<std::pair<std::string, bool>> DepartmentsSnapshot::children_of(const std::string& department_id) const
+{
+    std::vector<std::pair<std::string, bool>> children;
+    auto node = find(department_id);
+    if (node != nullptr)
+    {
+        for (auto child: node->children)
+        {
+            children.push_back(std::make_pair(nodes[child].id, !nodes[child].children.empty()));
+        }
+    }
+    return children;
+}
+
+bool DepartmentsSnapshot::is_descendant_of(const std::string& department_id, const std::string& parent_department_id) const
+{
+    auto node = find(department_id);
+    auto parent = find(parent_department_id);
+    if (node == nullptr || parent == nullptr)
+    {
+        return false;
+    }
+    return parent->enter < node->enter && node->enter < parent->exit;
+}
+
+std::unordered_set<std::string> DepartmentsSnapshot::packages_of(const std::string& department_id, bool recursive) const
+{
+    std::unordered_set<std::string> pkgs;
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return pkgs;
+    }
+    if (!recursive)
+    {
+        pkgs.insert(node->packages.begin(), node->packages.end());
+        return pkgs;
+    }
+    for_each_recursive_package(*node, [&pkgs](const std::string& pkg) {
+        pkgs.insert(pkg);
+    });
+    return pkgs;
+}
+
+bool DepartmentsSnapshot::is_empty(const std::string& department_id) const
+{
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return true;
+    }
+    bool empty = true;
+    for_each_recursive_package(*node, [&empty](const std::string&) {
+        empty = false;
+    });
+    return empty;
+}
+
+bool DepartmentsSnapshot::has_package(const std::string& package_id) const
+{
+    return package_departments.find(package_id) != package_departments.end();
+}
+
+const std::string* DepartmentsSnapshot::department_of(const std::string& package_id) const
+{
+    auto it = package_departments.find(package_id);
+    return it == package_departments.end() ? nullptr : &it->second;
+}
+
+}
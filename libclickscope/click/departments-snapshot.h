@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DEPARTMENTS_SNAPSHOT_H
+#define CLICK_DEPARTMENTS_SNAPSHOT_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace click
+{
+
+// Read-only in-memory copy of the depts and pkgmap tables of the departments
+// database, answering the hierarchy queries of DepartmentsDb without SQL.
+//
+// Every department gets a node with its parent and children; an Euler tour
+// over the hierarchy numbers the nodes so that the descendants of a node are
+// exactly the nodes numbered in [enter, exit) of it, which turns ancestor
+// tests into two comparisons and recursive package lookups into a scan of a
+// contiguous range.
+//
+// The answers match the recursive queries of DepartmentsDb: a department
+// only counts as part of the hierarchy if it has a row in depts, and the
+// root department "" has none.
+class DepartmentsSnapshot
+{
+public:
+    // (first, second) pairs of (deptid, parentid) or (pkgid, deptid) rows
+    typedef std::vector<std::pair<std::string, std::string>> Rows;
+
+    // pkgmap rows are expected to be ordered by pkgid and deptid. Returns
+    // nullptr if a department has several parents or is its own ancestor, as
+    // the snapshot can only represent a forest.
+    static std::shared_ptr<const DepartmentsSnapshot> build(const Rows& depts, const Rows& pkgmap);
+
+    // Throws std::logic_error for departments without a row in depts.
+    std::string parent_of(const std::string& department_id) const;
+    // (department id, has children) of the direct children
+    std::vector<std::pair<std::string, bool>> children_of(const std::string& department_id) const;
+    bool is_descendant_of(const std::string& department_id, const std::string& parent_department_id) const;
+    // Maps every department below department_id to the direct child of
+    // department_id it descends from; children map to themselves.
+    std::unordered_map<std::string, std::string> top_departments_under(const std::string& department_id) const;
+
+    std::unordered_set<std::string> packages_of(const std::string& department_id, bool recursive) const;
+    bool is_empty(const std::string& department_id) const;
+
+    bool has_package(const std::string& package_id) const;
+    // nullptr for unknown packages
+    const std::string* department_of(const std::string& package_id) const;
+
+private:
+    // writes snapshots to files
+    friend class MappedDepartments;
+
+    struct Node
+    {
+        std::string id;
+        int parent = -1;
+        // has a row in depts
+        bool present = false;
+        std::vector<int> children;
+        std::vector<std::string> packages;
+        int enter = 0;
+        int exit = 0;
+    };
+
+    DepartmentsSnapshot() = default;
+
+    int node_for(const std::string& department_id);
+    const Node* find(const std::string& department_id) const;
+    bool number_nodes();
+
+    // calls f for the packages of the departments within the subtree of node
+    template <typename F>
+    void for_each_recursive_package(const Node& node, F f) const;
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, int> index;
+    // node at each position of the Euler tour
+    std::vector<int> tour;
+    std::unordered_map<std::string, std::string> package_departments;
+};
+
+} // namespace click
+
+#endif // CLICK_DEPARTMENTS_SNAPSHOT_H
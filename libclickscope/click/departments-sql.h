@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DEPARTMENTS_SQL_H
+#define CLICK_DEPARTMENTS_SQL_H
+
+// Statements on the departments database, shared by the QtSql and the
+// native sqlite3 implementations of DepartmentsDb.
+
+namespace click
+{
+namespace departments_sql
+{
+
+// writes
+static const char* const DELETE_PKGMAP = "DELETE FROM pkgmap WHERE pkgid=:pkgid";
+static const char* const DELETE_DEPTS = "DELETE FROM depts";
+static const char* const DELETE_DEPTNAMES = "DELETE FROM deptnames WHERE locale=:locale";
+static const char* const INSERT_PKGMAP = "INSERT OR REPLACE INTO pkgmap (pkgid, deptid) VALUES (:pkgid, :deptid)";
+static const char* const INSERT_DEPT_ID = "INSERT OR REPLACE INTO depts (deptid, parentid) VALUES (:deptid, :parentid)";
+static const char* const INSERT_DEPT_NAME = "INSERT OR REPLACE INTO deptnames (deptid, locale, name) VALUES (:deptid, :locale, :name)";
+static const char* const UPDATE_PKGMAP_VERSION = "UPDATE pkgmap SET version=:version WHERE pkgid=:pkgid";
+static const char* const INSERT_META = "INSERT OR REPLACE INTO meta (name, value) VALUES (:name, :value)";
+static const char* const DELETE_META = "DELETE FROM meta WHERE instr(name, :prefix)=1";
+// remove_all(), together with DELETE_DEPTS
+static const char* const DELETE_ALL_PKGMAP = "DELETE FROM pkgmap";
+static const char* const DELETE_ALL_DEPTNAMES = "DELETE FROM deptnames";
+
+// lookups
+static const char* const SELECT_PKGS_BY_DEPT = "SELECT pkgid FROM pkgmap WHERE deptid=:deptid";
+static const char* const SELECT_DEPT_FOR_PKG = "SELECT deptid from pkgmap WHERE pkgid=:pkgid";
+static const char* const SELECT_PKG_BY_PKGID = "SELECT pkgid FROM pkgmap WHERE pkgid=:pkgid";
+static const char* const SELECT_CHILDREN_DEPTS = "SELECT deptid,(SELECT COUNT(1) from depts AS inner WHERE inner.parentid=outer.deptid) FROM depts AS outer WHERE parentid=:parentid";
+static const char* const SELECT_PARENT_DEPT = "SELECT parentid FROM depts WHERE deptid=:deptid";
+static const char* const SELECT_DEPT_NAMES = "SELECT deptid, name FROM deptnames WHERE locale=:locale";
+static const char* const SELECT_ALL_DEPT_NAMES = "SELECT deptid, locale, name FROM deptnames";
+static const char* const SELECT_DEPTS = "SELECT deptid, parentid FROM depts";
+static const char* const SELECT_PKGMAP = "SELECT pkgid, deptid FROM pkgmap ORDER BY pkgid, deptid";
+// the version column was added in schema version 6
+static const char* const SELECT_PKGMAP_VERSIONS = "SELECT pkgid, version FROM pkgmap";
+static const char* const SELECT_META = "SELECT name, value FROM meta WHERE instr(name, :prefix)=1";
+
+// recursive lookups on the dept_closure table of schema version 5
+static const char* const SELECT_PKGS_BY_DEPT_RECURSIVE = "SELECT pkgid FROM pkgmap JOIN dept_closure ON pkgmap.deptid=dept_closure.descendant WHERE dept_closure.ancestor=:deptid";
+static const char* const SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE = "SELECT COUNT(pkgid) FROM pkgmap JOIN dept_closure ON pkgmap.deptid=dept_closure.descendant WHERE dept_closure.ancestor=:deptid";
+static const char* const SELECT_IS_DESCENDANT_OF_DEPT = "SELECT COUNT(1) FROM dept_closure WHERE ancestor=:parentid AND descendant=:deptid AND depth>0";
+static const char* const SELECT_TOP_DEPTS_UNDER = "SELECT dept_closure.descendant, dept_closure.ancestor FROM depts JOIN dept_closure ON dept_closure.ancestor=depts.deptid WHERE depts.parentid=:parentid";
+
+// maintenance of dept_closure; depth is capped so that a cycle in depts
+// can't make the recursion endless
+static const char* const DELETE_CLOSURE = "DELETE FROM dept_closure";
+static const char* const INSERT_CLOSURE_SELF = "INSERT OR IGNORE INTO dept_closure (ancestor, descendant, depth) SELECT deptid, deptid, 0 FROM depts";
+static const char* const INSERT_CLOSURE = "WITH RECURSIVE closure(ancestor, descendant, depth) AS (SELECT parentid, deptid, 1 FROM depts UNION SELECT closure.ancestor, depts.deptid, closure.depth + 1 FROM closure, depts WHERE closure.descendant=depts.parentid AND closure.depth < 64) INSERT OR IGNORE INTO dept_closure (ancestor, descendant, depth) SELECT ancestor, descendant, MIN(depth) FROM closure GROUP BY ancestor, descendant";
+
+// recursive lookups for databases without dept_closure
+static const char* const SELECT_PKGS_BY_DEPT_RECURSIVE_CTE = "WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE deptid=:deptid OR parentid=:deptid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT pkgid FROM pkgmap NATURAL JOIN recdepts";
+static const char* const SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE_CTE = "WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE deptid=:deptid OR parentid=:deptid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT COUNT(pkgid) FROM pkgmap NATURAL JOIN recdepts";
+static const char* const SELECT_IS_DESCENDANT_OF_DEPT_CTE = "WITH RECURSIVE recdepts(deptid) AS (SELECT deptid FROM depts WHERE parentid=:parentid UNION SELECT depts.deptid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT COUNT(1) FROM recdepts WHERE deptid=:deptid";
+static const char* const SELECT_TOP_DEPTS_UNDER_CTE = "WITH RECURSIVE recdepts(deptid, topid) AS (SELECT deptid, deptid FROM depts WHERE parentid=:parentid UNION SELECT depts.deptid, recdepts.topid FROM recdepts,depts WHERE recdepts.deptid=depts.parentid) SELECT deptid, topid FROM recdepts";
+
+// reads of all indexes and of the deptnames table, so that their pages are
+// in the page cache before the first lookups; statements on indexes that an
+// older database doesn't have just fail
+static const char* const WARM_UP[] = {
+    "SELECT COUNT(deptid) FROM pkgmap INDEXED BY sqlite_autoindex_pkgmap_1",
+    "SELECT COUNT(deptid) FROM pkgmap INDEXED BY pkgmap_deptid",
+    "SELECT COUNT(parentid) FROM depts INDEXED BY sqlite_autoindex_depts_1",
+    "SELECT COUNT(locale) FROM deptnames INDEXED BY sqlite_autoindex_deptnames_1",
+    "SELECT COUNT(name) FROM deptnames NOT INDEXED",
+    "SELECT COUNT(descendant) FROM dept_closure INDEXED BY sqlite_autoindex_dept_closure_1",
+    "SELECT COUNT(descendant) FROM dept_closure INDEXED BY dept_closure_descendant"
+};
+
+} // namespace departments_sql
+} // namespace click
+
+#endif // CLICK_DEPARTMENTS_SQL_H
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "desktop-entry-parser.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace click
+{
+
+namespace
+{
+
+const char DESKTOP_ENTRY_GROUP[] = "Desktop Entry";
+
+bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+// Locale fallback list as defined by the desktop entry spec: for
+// lang_COUNTRY@MODIFIER try lang_COUNTRY@MODIFIER, lang_COUNTRY,
+// lang@MODIFIER and lang, in that order.
+std::vector<std::string> locale_variants(const std::string& language)
+{
+    std::vector<std::string> variants;
+    const auto lang_end = language.find_first_of("_.@");
+    const std::string lang = language.substr(0, lang_end);
+    if (lang.empty()) {
+        return variants;
+    }
+
+    std::string country;
+    if (lang_end != std::string::npos && language[lang_end] == '_') {
+        country = language.substr(lang_end + 1, language.find_first_of(".@", lang_end) - lang_end - 1);
+    }
+    std::string modifier;
+    const auto at = language.find('@');
+    if (at != std::string::npos) {
+        modifier = language.substr(at + 1);
+    }
+
+    if (!country.empty() && !modifier.empty()) {
+        variants.push_back(lang + "_" + country + "@" + modifier);
+    }
+    if (!country.empty()) {
+        variants.push_back(lang + "_" + country);
+    }
+    if (!modifier.empty()) {
+        variants.push_back(lang + "@" + modifier);
+    }
+    variants.push_back(lang);
+    return variants;
+}
+
+}
+
+DesktopEntryParser::DesktopEntryParser(const std::string& path, const std::string& language)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(err));
+    }
+    size = static_cast<std::size_t>(st.st_size);
+    if (size > 0) {
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(err));
+        }
+        data = static_cast<const char*>(addr);
+    }
+    ::close(fd);
+
+    parse(locale_variants(language));
+}
+
+DesktopEntryParser::~DesktopEntryParser()
+{
+    if (data != nullptr) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+}
+
+void DesktopEntryParser::parse(const std::vector<std::string>& locales)
+{
+    const char* p = data;
+    const char* const end = data + size;
+    bool in_group = false;
+
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (eol == nullptr) {
+            eol = end;
+        }
+        const char* line = p;
+        const char* line_end = eol;
+        p = eol + 1;
+
+        while (line < line_end && is_blank(*line)) {
+            line++;
+        }
+        if (line_end > line && line_end[-1] == '\r') {
+            line_end--;
+        }
+        if (line == line_end || *line == '#') {
+            continue;
+        }
+
+        if (*line == '[') {
+            if (in_group) {
+                // everything we are interested in has been seen
+                break;
+            }
+            const char* close = static_cast<const char*>(std::memchr(line, ']', line_end - line));
+            const std::size_t name_len = close ? static_cast<std::size_t>(close - line - 1) : 0;
+            in_group = close != nullptr && name_len == sizeof(DESKTOP_ENTRY_GROUP) - 1 &&
+                std::memcmp(line + 1, DESKTOP_ENTRY_GROUP, name_len) == 0;
+            group_found = group_found || in_group;
+            continue;
+        }
+        if (!in_group) {
+            continue;
+        }
+
+        const char* eq = static_cast<const char*>(std::memchr(line, '=', line_end - line));
+        if (eq == nullptr) {
+            continue;
+        }
+        const char* key_end = eq;
+        while (key_end > line && is_blank(key_end[-1])) {
+            key_end--;
+        }
+        const char* value = eq + 1;
+        while (value < line_end && is_blank(*value)) {
+            value++;
+        }
+
+        StringRef key{line, static_cast<std::size_t>(key_end - line)};
+        StringRef locale;
+        if (key.size > 0 && key_end[-1] == ']') {
+            const char* open = static_cast<const char*>(std::memchr(line, '[', key.size));
+            if (open != nullptr) {
+                locale = StringRef{open + 1, static_cast<std::size_t>(key_end - 1 - open - 1)};
+                key.size = static_cast<std::size_t>(open - line);
+            }
+        }
+        add_field(key, locale, StringRef{value, static_cast<std::size_t>(line_end - value)}, locales);
+    }
+}
+
+void DesktopEntryParser::add_field(const StringRef& key, const StringRef& locale, const StringRef& value,
+                                   const std::vector<std::string>& locales)
+{
+    int rank = 0;
+    if (!locale.empty()) {
+        std::size_t i = 0;
+        while (i < locales.size() && !(locale == locales[i])) {
+            i++;
+        }
+        if (i == locales.size()) {
+            return; // a translation we don't care about
+        }
+        rank = static_cast<int>(i) + 1;
+    }
+
+    for (auto& field: fields) {
+        if (field.locale_rank == rank && field.key.size == key.size &&
+            std::memcmp(field.key.data, key.data, key.size) == 0) {
+            // like GKeyFile, the last occurrence of a key wins
+            field.value = value;
+            return;
+        }
+    }
+    fields.push_back(Field{key, value, rank});
+}
+
+bool DesktopEntryParser::has_group() const
+{
+    return group_found;
+}
+
+bool DesktopEntryParser::has_key(const std::string& key) const
+{
+    for (auto const& field: fields) {
+        if (field.locale_rank == 0 && field.key == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DesktopEntryParser::StringRef DesktopEntryParser::get(const std::string& key) const
+{
+    for (auto const& field: fields) {
+        if (field.locale_rank == 0 && field.key == key) {
+            return field.value;
+        }
+    }
+    return StringRef();
+}
+
+DesktopEntryParser::StringRef DesktopEntryParser::get_localized(const std::string& key) const
+{
+    const Field* best = nullptr;
+    for (auto const& field: fields) {
+        if (field.key == key && (best == nullptr || best->locale_rank == 0 ||
+                                 (field.locale_rank > 0 && field.locale_rank < best->locale_rank))) {
+            best = &field;
+        }
+    }
+    return best ? best->value : StringRef();
+}
+
+std::string DesktopEntryParser::unescape(const StringRef& value)
+{
+    std::string result;
+    result.reserve(value.size);
+    for (std::size_t i = 0; i < value.size; i++) {
+        char c = value.data[i];
+        if (c == '\\' && i + 1 < value.size) {
+            switch (value.data[++i]) {
+            case 's': c = ' '; break;
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case '\\': c = '\\'; break;
+            default:
+                // unknown escapes are kept as they are
+                result.push_back('\\');
+                c = value.data[i];
+                break;
+            }
+        }
+        result.push_back(c);
+    }
+    return result;
+}
+
+std::vector<std::string> DesktopEntryParser::split_list(const StringRef& value)
+{
+    std::vector<std::string> items;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= value.size; i++) {
+        // a backslash that ends the value escapes nothing and is kept as it is
+        if (i + 1 < value.size && value.data[i] == '\\') {
+            i++; // skip whatever is escaped, including \;
+            continue;
+        }
+        if (i == value.size || value.data[i] == ';') {
+            if (i > start || i < value.size) {
+                std::string item;
+                item.reserve(i - start);
+                for (std::size_t j = start; j < i; j++) {
+                    if (value.data[j] == '\\' && j + 1 < i && value.data[j + 1] == ';') {
+                        continue; // \; is a literal semicolon
+                    }
+                    item.push_back(value.data[j]);
+                }
+                items.push_back(unescape(StringRef{item.data(), item.size()}));
+            }
+            start = i + 1;
+        }
+    }
+    return items;
+}
+
+} // namespace click
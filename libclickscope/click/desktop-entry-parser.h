@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DESKTOP_ENTRY_PARSER_H
+#define CLICK_DESKTOP_ENTRY_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// Minimal parser for the [Desktop Entry] group of a .desktop file.
+//
+// Unlike unity::util::IniParser, which loads every group and every
+// translation of the file through GKeyFile, this maps the file into memory
+// and only records where the values of the [Desktop Entry] group are. Of
+// the localized values only the variant that best matches the given
+// language is kept. Values are returned as references into the mapped
+// file, so they are only valid for the lifetime of the parser.
+class DesktopEntryParser
+{
+public:
+    // Non-owning reference to a (still escaped) value inside the mapped file.
+    struct StringRef
+    {
+        StringRef() = default;
+        StringRef(const char* data, std::size_t size)
+            : data(data), size(size)
+        {
+        }
+
+        const char* data = nullptr;
+        std::size_t size = 0;
+
+        bool empty() const
+        {
+            return size == 0;
+        }
+        bool operator==(const std::string& other) const
+        {
+            return other.size() == size && other.compare(0, size, data, size) == 0;
+        }
+        std::string str() const
+        {
+            return std::string(data, size);
+        }
+    };
+
+    // Throws std::runtime_error if the file cannot be read.
+    DesktopEntryParser(const std::string& path, const std::string& language);
+    DesktopEntryParser(const DesktopEntryParser&) = delete;
+    DesktopEntryParser& operator=(const DesktopEntryParser&) = delete;
+    ~DesktopEntryParser();
+
+    bool has_group() const;
+    bool has_key(const std::string& key) const;
+
+    // Value of the unlocalized key.
+    StringRef get(const std::string& key) const;
+    // Value of the best matching translation of the key, or of the unlocalized key.
+    StringRef get_localized(const std::string& key) const;
+
+    // Resolves \s, \n, \t, \r and \\ escapes.
+    static std::string unescape(const StringRef& value);
+    // Splits a ;-separated list, honouring \; escapes.
+    static std::vector<std::string> split_list(const StringRef& value);
+
+private:
+    struct Field
+    {
+        StringRef key;
+        StringRef value;
+        // 0 for the unlocalized key, otherwise the position of the
+        // matching locale in the fallback list plus one
+        int locale_rank;
+    };
+
+    void parse(const std::vector<std::string>& locales);
+    void add_field(const StringRef& key, const StringRef& locale, const StringRef& value,
+                   const std::vector<std::string>& locales);
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool group_found = false;
+    std::vector<Field> fields;
+};
+
+} // namespace click
+
+#endif // CLICK_DESKTOP_ENTRY_PARSER_H
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "desktop-entry.h"
+#include "desktop-entry-parser.h"
+#include "search-keys.h"
+
+#include <libintl.h>
+#include <sstream>
+#include <stdexcept>
+
+#include <unity/util/IniParser.h>
+
+namespace click
+{
+
+namespace
+{
+
+std::string translated_string(const unity::util::IniParser& keyFile,
+                              const std::string& key,
+                              const std::string& domain,
+                              const std::string& language)
+{
+    if (!domain.empty()) {
+        return dgettext(domain.c_str(),
+                        keyFile.get_string(DesktopEntry::Keys::group, key).c_str());
+    }
+    return keyFile.get_locale_string(DesktopEntry::Keys::group, key, language);
+}
+
+std::string translated_string(const DesktopEntryParser& parser,
+                              const std::string& key,
+                              const std::string& domain)
+{
+    // IniParser throws for a missing key, do the same so that both
+    // parsers reject the same files
+    if (!parser.has_key(key)) {
+        throw std::runtime_error("Missing key " + key);
+    }
+    if (!domain.empty()) {
+        return dgettext(domain.c_str(),
+                        DesktopEntryParser::unescape(parser.get(key)).c_str());
+    }
+    return DesktopEntryParser::unescape(parser.get_localized(key));
+}
+
+}
+
+DesktopEntry DesktopEntry::from_key_file(const unity::util::IniParser& keyFile,
+                                         const std::string& filename,
+                                         const std::string& language)
+{
+    const std::string group(Keys::group);
+
+    DesktopEntry entry;
+    entry.filename = filename;
+    entry.has_desktop_group = keyFile.has_group(group);
+    if (!entry.has_desktop_group) {
+        return entry;
+    }
+
+    if (keyFile.has_key(group, Keys::no_display)) {
+        entry.no_display = keyFile.get_string(group, Keys::no_display) == "true";
+    }
+    if (keyFile.has_key(group, Keys::only_show_in)) {
+        entry.has_only_show_in = true;
+        std::stringstream ss(keyFile.get_string(group, Keys::only_show_in));
+        std::string item;
+        while (std::getline(ss, item, ';')) {
+            entry.only_show_in.push_back(item);
+        }
+    }
+
+    entry.ubuntu_touch = keyFile.has_key(group, Keys::ubuntu_touch);
+    entry.has_app_id = keyFile.has_key(group, Keys::app_id);
+    if (entry.has_app_id) {
+        entry.app_id = keyFile.get_string(group, Keys::app_id);
+    }
+    if (keyFile.has_key(group, Keys::gettext_domain)) {
+        entry.gettext_domain = keyFile.get_string(group, Keys::gettext_domain);
+    }
+
+    entry.name = translated_string(keyFile, Keys::name, entry.gettext_domain, language);
+
+    entry.has_icon = keyFile.has_key(group, Keys::icon);
+    if (entry.has_icon) {
+        entry.icon = keyFile.get_string(group, Keys::icon);
+    }
+    if (keyFile.has_key(group, Keys::keywords)) {
+        entry.keywords = keyFile.get_string_array(group, Keys::keywords);
+    }
+    if (keyFile.has_key(group, Keys::default_department)) {
+        entry.default_department = keyFile.get_string(group, Keys::default_department);
+    }
+    entry.has_comment = keyFile.has_key(group, Keys::comment);
+    if (entry.has_comment) {
+        entry.comment = translated_string(keyFile, Keys::comment, entry.gettext_domain, language);
+    }
+    if (keyFile.has_key(group, Keys::screenshot)) {
+        entry.screenshot = keyFile.get_string(group, Keys::screenshot);
+    }
+    entry.search_name = search_key(entry.name);
+    entry.search_keywords = search_keys(entry.keywords);
+    return entry;
+}
+
+DesktopEntry DesktopEntry::from_parser(const DesktopEntryParser& parser,
+                                       const std::string& filename)
+{
+    DesktopEntry entry;
+    entry.filename = filename;
+    entry.has_desktop_group = parser.has_group();
+    if (!entry.has_desktop_group) {
+        return entry;
+    }
+
+    if (parser.has_key(Keys::no_display)) {
+        entry.no_display = DesktopEntryParser::unescape(parser.get(Keys::no_display)) == "true";
+    }
+    if (parser.has_key(Keys::only_show_in)) {
+        entry.has_only_show_in = true;
+        std::stringstream ss(DesktopEntryParser::unescape(parser.get(Keys::only_show_in)));
+        std::string item;
+        while (std::getline(ss, item, ';')) {
+            entry.only_show_in.push_back(item);
+        }
+    }
+
+    entry.ubuntu_touch = parser.has_key(Keys::ubuntu_touch);
+    entry.has_app_id = parser.has_key(Keys::app_id);
+    if (entry.has_app_id) {
+        entry.app_id = DesktopEntryParser::unescape(parser.get(Keys::app_id));
+    }
+    if (parser.has_key(Keys::gettext_domain)) {
+        entry.gettext_domain = DesktopEntryParser::unescape(parser.get(Keys::gettext_domain));
+    }
+
+    entry.name = translated_string(parser, Keys::name, entry.gettext_domain);
+
+    entry.has_icon = parser.has_key(Keys::icon);
+    if (entry.has_icon) {
+        entry.icon = DesktopEntryParser::unescape(parser.get(Keys::icon));
+    }
+    if (parser.has_key(Keys::keywords)) {
+        entry.keywords = DesktopEntryParser::split_list(parser.get(Keys::keywords));
+    }
+    if (parser.has_key(Keys::default_department)) {
+        entry.default_department = DesktopEntryParser::unescape(parser.get(Keys::default_department));
+    }
+    entry.has_comment = parser.has_key(Keys::comment);
+    if (entry.has_comment) {
+        entry.comment = translated_string(parser, Keys::comment, entry.gettext_domain);
+    }
+    if (parser.has_key(Keys::screenshot)) {
+        entry.screenshot = DesktopEntryParser::unescape(parser.get(Keys::screenshot));
+    }
+    entry.search_name = search_key(entry.name);
+    entry.search_keywords = search_keys(entry.keywords);
+    return entry;
+}
+
+} // namespace click
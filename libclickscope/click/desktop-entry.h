@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DESKTOP_ENTRY_H
+#define CLICK_DESKTOP_ENTRY_H
+
+#include <string>
+#include <vector>
+
+namespace unity
+{
+namespace util
+{
+class IniParser;
+}
+}
+
+namespace click
+{
+
+class DesktopEntryParser;
+
+// The subset of a .desktop file's [Desktop Entry] group that the scope
+// actually uses, with translatable strings already resolved for one language.
+struct DesktopEntry
+{
+    struct Keys
+    {
+        Keys() = delete;
+
+        constexpr static const char* group{"Desktop Entry"};
+        constexpr static const char* name{"Name"};
+        constexpr static const char* icon{"Icon"};
+        constexpr static const char* keywords{"Keywords"};
+        constexpr static const char* app_id{"X-Ubuntu-Application-ID"};
+        constexpr static const char* gettext_domain{"X-Ubuntu-Gettext-Domain"};
+        constexpr static const char* ubuntu_touch{"X-Ubuntu-Touch"};
+        constexpr static const char* default_department{"X-Ubuntu-Default-Department-ID"};
+        constexpr static const char* comment{"Comment"};
+        constexpr static const char* screenshot{"X-Screenshot"};
+        constexpr static const char* no_display{"NoDisplay"};
+        constexpr static const char* only_show_in{"OnlyShowIn"};
+    };
+
+    static DesktopEntry from_key_file(const unity::util::IniParser& keyFile,
+                                      const std::string& filename,
+                                      const std::string& language);
+    // Same as from_key_file(), for a file read with DesktopEntryParser; the
+    // language was already chosen when the parser was created.
+    static DesktopEntry from_parser(const DesktopEntryParser& parser,
+                                    const std::string& filename);
+
+    std::string filename;
+    bool has_desktop_group = false;
+    bool no_display = false;
+    bool has_only_show_in = false;
+    std::vector<std::string> only_show_in;
+    bool ubuntu_touch = false;
+    bool has_app_id = false;
+    std::string app_id;
+    std::string gettext_domain;
+    std::string name;
+    bool has_icon = false;
+    std::string icon;
+    std::vector<std::string> keywords;
+    // search_key() of name and keywords
+    std::string search_name;
+    std::vector<std::string> search_keywords;
+    // collation_key() of name, only filled in by ApplicationCatalog; not
+    // stored in the desktop file cache as it depends on the ICU version
+    std::string sort_key;
+    std::string default_department;
+    bool has_comment = false;
+    std::string comment;
+    std::string screenshot;
+};
+
+} // namespace click
+
+#endif // CLICK_DESKTOP_ENTRY_H
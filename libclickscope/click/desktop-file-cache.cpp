@@ -0,0 +1,620 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "desktop-file-cache.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <libintl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace click
+{
+
+namespace
+{
+
+// Bump whenever the layout below or the contents of DesktopEntry change.
+constexpr std::uint32_t CACHE_VERSION = 3;
+constexpr char CACHE_MAGIC[8] = {'C', 'L', 'I', 'C', 'K', 'D', 'F', 'C'};
+
+// Record::flags bits
+constexpr std::uint32_t HAS_DESKTOP_GROUP = 1 << 0;
+constexpr std::uint32_t NO_DISPLAY = 1 << 1;
+constexpr std::uint32_t HAS_ONLY_SHOW_IN = 1 << 2;
+constexpr std::uint32_t UBUNTU_TOUCH = 1 << 3;
+constexpr std::uint32_t HAS_APP_ID = 1 << 4;
+constexpr std::uint32_t HAS_ICON = 1 << 5;
+constexpr std::uint32_t HAS_COMMENT = 1 << 6;
+
+// offset and size of a string in the string pool
+struct StrRef
+{
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+// range of StrRefs in the list table
+struct ListRef
+{
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint32_t lists_offset;
+    std::uint32_t lists_count;
+    std::uint32_t strings_offset;
+    std::uint32_t strings_size;
+    StrRef language;
+};
+
+struct Record
+{
+    StrRef path;
+    std::uint64_t mtime_ns;
+    std::uint64_t size;
+    std::uint64_t inode;
+    std::uint64_t catalog_mtime_ns;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    StrRef filename;
+    StrRef app_id;
+    StrRef gettext_domain;
+    StrRef name;
+    StrRef icon;
+    StrRef default_department;
+    StrRef comment;
+    StrRef screenshot;
+    ListRef keywords;
+    ListRef only_show_in;
+    StrRef search_name;
+    ListRef search_keywords;
+};
+
+static_assert(sizeof(Header) % 8 == 0, "Header must keep records 8-byte aligned");
+static_assert(sizeof(Record) == 144, "Unexpected padding in cache record");
+
+class StringPool
+{
+public:
+    StrRef add(const std::string& s)
+    {
+        auto it = offsets.find(s);
+        if (it != offsets.end()) {
+            return StrRef{it->second, static_cast<std::uint32_t>(s.size())};
+        }
+        const auto offset = static_cast<std::uint32_t>(data.size());
+        data.append(s);
+        offsets.emplace(s, offset);
+        return StrRef{offset, static_cast<std::uint32_t>(s.size())};
+    }
+
+    ListRef add(const std::vector<std::string>& items, std::vector<StrRef>& lists)
+    {
+        ListRef ref{static_cast<std::uint32_t>(lists.size()), static_cast<std::uint32_t>(items.size())};
+        for (auto const& item: items) {
+            lists.push_back(add(item));
+        }
+        return ref;
+    }
+
+    std::string data;
+
+private:
+    std::unordered_map<std::string, std::uint32_t> offsets;
+};
+
+bool write_all(int fd, const void* data, std::size_t size)
+{
+    auto ptr = static_cast<const char*>(data);
+    while (size > 0) {
+        auto n = ::write(fd, ptr, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        ptr += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// The names gettext tries for a locale of the form
+// language[_territory][.codeset][@modifier], in its order: for de_DE.UTF-8
+// these are de_DE.UTF-8, de_DE.utf8, de_DE, de.UTF-8, de.utf8 and de. With
+// a modifier, the same names with it come first.
+std::vector<std::string> gettext_locales(const std::string& locale)
+{
+    std::string language = locale, territory, codeset, modifier;
+    auto cut = [&language](char separator, std::string& part) {
+        const auto pos = language.find(separator);
+        if (pos != std::string::npos) {
+            part = language.substr(pos);
+            language.erase(pos);
+        }
+    };
+    cut('@', modifier);
+    cut('.', codeset);
+    cut('_', territory);
+
+    // like _nl_normalize_codeset(): lower case letters and digits only, and
+    // "iso" in front of plain numbers
+    std::string normalized;
+    bool only_digits = true;
+    for (auto c: codeset) {
+        if (isalpha(static_cast<unsigned char>(c))) {
+            normalized += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            only_digits = false;
+        } else if (isdigit(static_cast<unsigned char>(c))) {
+            normalized += c;
+        }
+    }
+    if (!normalized.empty()) {
+        normalized = (only_digits ? ".iso" : ".") + normalized;
+    }
+    if (normalized == codeset) {
+        normalized.clear();
+    }
+
+    std::vector<std::string> locales;
+    for (auto const& with_modifier: {modifier, std::string()}) {
+        for (auto const& with_territory: {territory, std::string()}) {
+            for (auto const& with_codeset: {codeset, normalized, std::string()}) {
+                const std::string name = language + with_territory + with_codeset + with_modifier;
+                if (std::find(locales.begin(), locales.end(), name) == locales.end()) {
+                    locales.push_back(name);
+                }
+            }
+        }
+    }
+    return locales;
+}
+
+}
+
+class DesktopFileCache::Mapping
+{
+public:
+    Mapping(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(Header)) {
+            size = static_cast<std::size_t>(st.st_size);
+            void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                base = static_cast<const char*>(addr);
+            }
+        }
+        ::close(fd);
+
+        if (base != nullptr && !validate()) {
+            qWarning() << "Ignoring invalid desktop file cache" << path.c_str();
+            unmap();
+        }
+    }
+
+    ~Mapping()
+    {
+        unmap();
+    }
+
+    bool valid() const
+    {
+        return base != nullptr;
+    }
+
+    std::uint32_t count() const
+    {
+        return header().record_count;
+    }
+
+    std::string language() const
+    {
+        std::string s;
+        string_at(header().language, s);
+        return s;
+    }
+
+    const Record* find(const std::string& path) const
+    {
+        auto first = records();
+        auto last = first + count();
+        while (first < last) {
+            auto mid = first + (last - first) / 2;
+            const int cmp = compare(mid->path, path);
+            if (cmp == 0) {
+                return mid;
+            }
+            if (cmp < 0) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return nullptr;
+    }
+
+    bool decode(const Record& rec, Cached& cached) const
+    {
+        auto& stamp = cached.stamp;
+        auto& entry = cached.entry;
+        stamp.mtime_ns = rec.mtime_ns;
+        stamp.size = rec.size;
+        stamp.inode = rec.inode;
+        cached.catalog_mtime_ns = rec.catalog_mtime_ns;
+
+        entry.has_desktop_group = rec.flags & HAS_DESKTOP_GROUP;
+        entry.no_display = rec.flags & NO_DISPLAY;
+        entry.has_only_show_in = rec.flags & HAS_ONLY_SHOW_IN;
+        entry.ubuntu_touch = rec.flags & UBUNTU_TOUCH;
+        entry.has_app_id = rec.flags & HAS_APP_ID;
+        entry.has_icon = rec.flags & HAS_ICON;
+        entry.has_comment = rec.flags & HAS_COMMENT;
+
+        return string_at(rec.filename, entry.filename) &&
+            string_at(rec.app_id, entry.app_id) &&
+            string_at(rec.gettext_domain, entry.gettext_domain) &&
+            string_at(rec.name, entry.name) &&
+            string_at(rec.icon, entry.icon) &&
+            string_at(rec.default_department, entry.default_department) &&
+            string_at(rec.comment, entry.comment) &&
+            string_at(rec.screenshot, entry.screenshot) &&
+            list_at(rec.keywords, entry.keywords) &&
+            list_at(rec.only_show_in, entry.only_show_in) &&
+            string_at(rec.search_name, entry.search_name) &&
+            list_at(rec.search_keywords, entry.search_keywords);
+    }
+
+private:
+    const Header& header() const
+    {
+        return *reinterpret_cast<const Header*>(base);
+    }
+
+    const Record* records() const
+    {
+        return reinterpret_cast<const Record*>(base + sizeof(Header));
+    }
+
+    const StrRef* lists() const
+    {
+        return reinterpret_cast<const StrRef*>(base + header().lists_offset);
+    }
+
+    bool validate() const
+    {
+        auto const& h = header();
+        if (std::memcmp(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || h.version != CACHE_VERSION) {
+            return false;
+        }
+        const std::uint64_t records_end = sizeof(Header) + std::uint64_t(h.record_count) * sizeof(Record);
+        const std::uint64_t lists_end = std::uint64_t(h.lists_offset) + std::uint64_t(h.lists_count) * sizeof(StrRef);
+        const std::uint64_t strings_end = std::uint64_t(h.strings_offset) + h.strings_size;
+        return records_end <= h.lists_offset && h.lists_offset % alignof(StrRef) == 0 &&
+            lists_end <= h.strings_offset && strings_end <= size;
+    }
+
+    bool string_at(const StrRef& ref, std::string& out) const
+    {
+        if (std::uint64_t(ref.offset) + ref.size > header().strings_size) {
+            return false;
+        }
+        out.assign(base + header().strings_offset + ref.offset, ref.size);
+        return true;
+    }
+
+    bool list_at(const ListRef& ref, std::vector<std::string>& out) const
+    {
+        if (std::uint64_t(ref.first) + ref.count > header().lists_count) {
+            return false;
+        }
+        out.resize(ref.count);
+        for (std::uint32_t i = 0; i < ref.count; i++) {
+            if (!string_at(lists()[ref.first + i], out[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int compare(const StrRef& ref, const std::string& s) const
+    {
+        // out of bounds refs compare as empty strings, decode() rejects them later
+        const char* data = "";
+        std::size_t len = 0;
+        if (std::uint64_t(ref.offset) + ref.size <= header().strings_size) {
+            data = base + header().strings_offset + ref.offset;
+            len = ref.size;
+        }
+        const int cmp = std::memcmp(data, s.data(), std::min(len, s.size()));
+        if (cmp != 0) {
+            return cmp;
+        }
+        return len < s.size() ? -1 : (len > s.size() ? 1 : 0);
+    }
+
+    void unmap()
+    {
+        if (base != nullptr) {
+            ::munmap(const_cast<char*>(base), size);
+            base = nullptr;
+        }
+    }
+
+    const char* base = nullptr;
+    std::size_t size = 0;
+};
+
+bool DesktopFileCache::stamp_for(const std::string& path, Stamp& stamp)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    stamp.mtime_ns = std::uint64_t(st.st_mtim.tv_sec) * 1000000000ULL + std::uint64_t(st.st_mtim.tv_nsec);
+    stamp.size = std::uint64_t(st.st_size);
+    stamp.inode = std::uint64_t(st.st_ino);
+    return true;
+}
+
+std::uint64_t DesktopFileCache::catalog_mtime_for(const std::string& domain, const std::string& language)
+{
+    if (domain.empty()) {
+        return 0;
+    }
+    const char* dir = bindtextdomain(domain.c_str(), nullptr);
+    const std::string locale_dir = dir != nullptr ? dir : "/usr/share/locale";
+
+    std::istringstream languages(language);
+    std::string locale;
+    while (std::getline(languages, locale, ':')) {
+        if (locale.empty()) {
+            continue;
+        }
+        for (auto const& candidate: gettext_locales(locale)) {
+            Stamp stamp;
+            if (stamp_for(locale_dir + "/" + candidate + "/LC_MESSAGES/" + domain + ".mo", stamp)) {
+                return stamp.mtime_ns;
+            }
+        }
+    }
+    return 0;
+}
+
+void DesktopFileCache::begin_scan()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    catalog_mtimes_.clear();
+}
+
+std::uint64_t DesktopFileCache::catalog_mtime(const std::string& domain) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = catalog_mtimes_.find(domain);
+    if (it == catalog_mtimes_.end()) {
+        it = catalog_mtimes_.insert(std::make_pair(domain, catalog_mtime_for(domain, language_))).first;
+    }
+    return it->second;
+}
+
+DesktopFileCache::DesktopFileCache(const std::string& cache_path, const std::string& language)
+    : cache_path_(cache_path),
+      language_(language),
+      mapping_(new Mapping(cache_path))
+{
+    if (mapping_->valid() && mapping_->language() != language_) {
+        mapping_.reset(new Mapping(""));
+    }
+}
+
+DesktopFileCache::~DesktopFileCache()
+{
+}
+
+const std::string& DesktopFileCache::cache_path() const
+{
+    return cache_path_;
+}
+
+const std::string& DesktopFileCache::language() const
+{
+    return language_;
+}
+
+bool DesktopFileCache::lookup_locked(const std::string& path, Cached& cached) const
+{
+    auto it = updates_.find(path);
+    if (it != updates_.end()) {
+        cached = it->second;
+        return true;
+    }
+    if (mapping_->valid()) {
+        auto rec = mapping_->find(path);
+        if (rec != nullptr) {
+            return mapping_->decode(*rec, cached);
+        }
+    }
+    return false;
+}
+
+bool DesktopFileCache::lookup(const std::string& path, const Stamp& stamp, DesktopEntry& entry) const
+{
+    Cached cached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!lookup_locked(path, cached) || !(cached.stamp == stamp)) {
+            return false;
+        }
+    }
+    // an updated message catalog changes the translated name and comment
+    if (cached.catalog_mtime_ns != catalog_mtime(cached.entry.gettext_domain)) {
+        return false;
+    }
+    entry = std::move(cached.entry);
+    return true;
+}
+
+void DesktopFileCache::store(const std::string& path, const Stamp& stamp, const DesktopEntry& entry)
+{
+    Cached cached;
+    cached.stamp = stamp;
+    cached.catalog_mtime_ns = catalog_mtime(entry.gettext_domain);
+    cached.entry = entry;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    updates_[path] = std::move(cached);
+}
+
+void DesktopFileCache::save(const std::vector<std::string>& live_paths)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const bool up_to_date = updates_.empty() && mapping_->valid() &&
+        mapping_->count() == live_paths.size() &&
+        std::all_of(live_paths.begin(), live_paths.end(), [this](const std::string& p) {
+            return mapping_->find(p) != nullptr;
+        });
+    if (up_to_date) {
+        return;
+    }
+
+    std::map<std::string, Cached> entries;
+    for (auto const& path: live_paths) {
+        Cached cached;
+        if (lookup_locked(path, cached)) {
+            entries[path] = std::move(cached);
+        }
+    }
+
+    try {
+        write_file(entries);
+    } catch (const std::exception& e) {
+        qWarning() << "Failed to write desktop file cache:" << e.what();
+        return;
+    }
+    mapping_.reset(new Mapping(cache_path_));
+    updates_.clear();
+}
+
+void DesktopFileCache::write_file(const std::map<std::string, Cached>& entries) const
+{
+    StringPool pool;
+    std::vector<StrRef> lists;
+    std::vector<Record> records;
+    records.reserve(entries.size());
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.language = pool.add(language_);
+
+    // std::map iterates in path order, which is what lookups bisect on
+    for (auto const& kv: entries) {
+        auto const& stamp = kv.second.stamp;
+        auto const& entry = kv.second.entry;
+
+        Record rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.path = pool.add(kv.first);
+        rec.mtime_ns = stamp.mtime_ns;
+        rec.size = stamp.size;
+        rec.inode = stamp.inode;
+        rec.catalog_mtime_ns = kv.second.catalog_mtime_ns;
+        rec.flags = (entry.has_desktop_group ? HAS_DESKTOP_GROUP : 0u) |
+            (entry.no_display ? NO_DISPLAY : 0u) |
+            (entry.has_only_show_in ? HAS_ONLY_SHOW_IN : 0u) |
+            (entry.ubuntu_touch ? UBUNTU_TOUCH : 0u) |
+            (entry.has_app_id ? HAS_APP_ID : 0u) |
+            (entry.has_icon ? HAS_ICON : 0u) |
+            (entry.has_comment ? HAS_COMMENT : 0u);
+        rec.filename = pool.add(entry.filename);
+        rec.app_id = pool.add(entry.app_id);
+        rec.gettext_domain = pool.add(entry.gettext_domain);
+        rec.name = pool.add(entry.name);
+        rec.icon = pool.add(entry.icon);
+        rec.default_department = pool.add(entry.default_department);
+        rec.comment = pool.add(entry.comment);
+        rec.screenshot = pool.add(entry.screenshot);
+        rec.keywords = pool.add(entry.keywords, lists);
+        rec.only_show_in = pool.add(entry.only_show_in, lists);
+        rec.search_name = pool.add(entry.search_name);
+        rec.search_keywords = pool.add(entry.search_keywords, lists);
+        records.push_back(rec);
+    }
+
+    header.record_count = static_cast<std::uint32_t>(records.size());
+    header.lists_offset = static_cast<std::uint32_t>(sizeof(Header) + records.size() * sizeof(Record));
+    header.lists_count = static_cast<std::uint32_t>(lists.size());
+    header.strings_offset = static_cast<std::uint32_t>(header.lists_offset + lists.size() * sizeof(StrRef));
+    header.strings_size = static_cast<std::uint32_t>(pool.data.size());
+
+    // write to a temporary file and rename it over the old one, so that a
+    // concurrent reader never maps a half-written cache
+    std::string tmp_path = cache_path_ + ".XXXXXX";
+    int fd = ::mkstemp(&tmp_path[0]);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create " + tmp_path + ": " + std::strerror(errno));
+    }
+    const bool ok = write_all(fd, &header, sizeof(header)) &&
+        write_all(fd, records.data(), records.size() * sizeof(Record)) &&
+        write_all(fd, lists.data(), lists.size() * sizeof(StrRef)) &&
+        write_all(fd, pool.data.data(), pool.data.size());
+    ::close(fd);
+    if (!ok || ::rename(tmp_path.c_str(), cache_path_.c_str()) != 0) {
+        const int err = errno;
+        ::unlink(tmp_path.c_str());
+        throw std::runtime_error("Cannot write " + cache_path_ + ": " + std::strerror(err));
+    }
+}
+
+} // namespace click
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_DESKTOP_FILE_CACHE_H
+#define CLICK_DESKTOP_FILE_CACHE_H
+
+#include <click/desktop-entry.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// On-disk cache of parsed .desktop files.
+//
+// Entries are keyed by the full path of the desktop file and are only
+// considered valid as long as the file's mtime, size and inode match the
+// ones recorded when it was parsed, and for entries translated through
+// gettext, as long as the mtime of the message catalog does. The cache
+// file is a flat, memory-mapped table of fixed size records sorted by
+// path, followed by a pool of deduplicated strings, so looking up an entry
+// requires no parsing at all.
+class DesktopFileCache
+{
+public:
+    struct Stamp
+    {
+        std::uint64_t mtime_ns = 0;
+        std::uint64_t size = 0;
+        std::uint64_t inode = 0;
+
+        bool operator==(const Stamp& other) const
+        {
+            return mtime_ns == other.mtime_ns && size == other.size && inode == other.inode;
+        }
+    };
+
+    // Fills in the stamp of the given file, returns false if it can't be stat'ed.
+    static bool stamp_for(const std::string& path, Stamp& stamp);
+
+    // mtime of the message catalog gettext uses for the domain in the given
+    // language, or 0 if there is none.
+    static std::uint64_t catalog_mtime_for(const std::string& domain, const std::string& language);
+
+    // Translated strings depend on the language, so the cache is discarded
+    // if it was written for a language other than the given one.
+    DesktopFileCache(const std::string& cache_path, const std::string& language);
+    DesktopFileCache(const DesktopFileCache&) = delete;
+    DesktopFileCache& operator=(const DesktopFileCache&) = delete;
+    virtual ~DesktopFileCache();
+
+    const std::string& cache_path() const;
+    const std::string& language() const;
+
+    // Message catalogs are only looked up once per domain between calls,
+    // so scans call this first to notice catalogs updated since the last.
+    virtual void begin_scan();
+
+    virtual bool lookup(const std::string& path, const Stamp& stamp, DesktopEntry& entry) const;
+    virtual void store(const std::string& path, const Stamp& stamp, const DesktopEntry& entry);
+
+    // Rewrites the cache file with the entries of the given paths, dropping
+    // all others (i.e. desktop files that have been removed). Nothing gets
+    // written if the cache file is already up to date.
+    virtual void save(const std::vector<std::string>& live_paths);
+
+private:
+    class Mapping;
+
+    struct Cached
+    {
+        Stamp stamp;
+        std::uint64_t catalog_mtime_ns = 0;
+        DesktopEntry entry;
+    };
+
+    bool lookup_locked(const std::string& path, Cached& cached) const;
+    // catalog_mtime_for() the language of the cache, once per scan
+    std::uint64_t catalog_mtime(const std::string& domain) const;
+    void write_file(const std::map<std::string, Cached>& entries) const;
+
+    const std::string cache_path_;
+    const std::string language_;
+    mutable std::mutex mutex_;
+    std::unique_ptr<Mapping> mapping_;
+    std::map<std::string, Cached> updates_;
+    mutable std::map<std::string, std::uint64_t> catalog_mtimes_;
+};
+
+} // namespace click
+
+#endif // CLICK_DESKTOP_FILE_CACHE_H
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_FILE_STAMP_H
+#define CLICK_FILE_STAMP_H
+
+#include <cstdint>
+#include <string>
+
+#include <sys/stat.h>
+
+namespace click
+{
+
+// What stat() says about a file, to tell whether it changed since.
+struct FileStamp
+{
+    std::int64_t mtime_ns;
+    // -1 if the file doesn't exist
+    std::int64_t size;
+    std::uint64_t inode;
+
+    static FileStamp of(const std::string& path)
+    {
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0)
+        {
+            return FileStamp{0, -1, 0};
+        }
+        return FileStamp{static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+                         static_cast<std::int64_t>(st.st_size),
+                         static_cast<std::uint64_t>(st.st_ino)};
+    }
+
+    bool operator==(const FileStamp& other) const
+    {
+        return mtime_ns == other.mtime_ns && size == other.size && inode == other.inode;
+    }
+
+    bool operator!=(const FileStamp& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+} // namespace click
+
+#endif // CLICK_FILE_STAMP_H
@@ -35,14 +35,12 @@
 #include <QTimer>
 
 #include <cstdio>
+#include <cstring>
 #include <list>
 #include <sys/stat.h>
 #include <map>
 #include <sstream>
 
-#include <boost/locale/collator.hpp>
-#include <boost/locale/generator.hpp>
-
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/exceptions.hpp>
@@ -52,39 +50,15 @@
 #include <unity/util/IniParser.h>
 
 #include "interface.h"
+#include <click/click-database.h>
+#include <click/collation.h>
+#include <click/desktop-entry.h>
 #include <click/key_file_locator.h>
+#include <click/search-keys.h>
 #include <click/departments-db.h>
 
 #include <click/click-i18n.h>
 
-namespace {
-
-/* Thanks to
- *   - http://stackoverflow.com/a/14031349
- *   - http://stackoverflow.com/questions/12278448/removing-accents-from-a-qstring
- */
-QString unaccent(const QString &str)
-{
-    QString tmp = str.normalized(QString::NormalizationForm_KD,
-                                 QChar::currentUnicodeVersion());
-    QString ret;
-    for (int i = 0, j = tmp.length();
-         i < j;
-         i++) {
-
-        // strip diacritic marks
-        if (tmp.at(i).category() != QChar::Mark_NonSpacing       &&
-            tmp.at(i).category() != QChar::Mark_SpacingCombining &&
-            tmp.at(i).category() != QChar::Mark_Enclosing) {
-            ret.append(tmp.at(i));
-        }
-    }
-
-    return ret;
-}
-
-}
-
 namespace click {
 
 const std::unordered_set<std::string>& nonClickDesktopFiles()
@@ -108,19 +82,12 @@ const std::unordered_set<std::string>& nonClickDesktopFiles()
     return set;
 }
 
-static const std::string DESKTOP_FILE_GROUP("Desktop Entry");
-static const std::string DESKTOP_FILE_KEY_NAME("Name");
-static const std::string DESKTOP_FILE_KEY_ICON("Icon");
-static const std::string DESKTOP_FILE_KEY_KEYWORDS("Keywords");
-static const std::string DESKTOP_FILE_KEY_APP_ID("X-Ubuntu-Application-ID");
-static const std::string DESKTOP_FILE_KEY_DOMAIN("X-Ubuntu-Gettext-Domain");
-static const std::string DESKTOP_FILE_UBUNTU_TOUCH("X-Ubuntu-Touch");
-static const std::string DESKTOP_FILE_UBUNTU_DEFAULT_DEPARTMENT("X-Ubuntu-Default-Department-ID");
-static const std::string DESKTOP_FILE_COMMENT("Comment");
-static const std::string DESKTOP_FILE_SCREENSHOT("X-Screenshot");
-static const std::string DESKTOP_FILE_NODISPLAY("NoDisplay");
-static const std::string DESKTOP_FILE_ONLYSHOWIN("OnlyShowIn");
+static const std::string DESKTOP_FILE_GROUP(DesktopEntry::Keys::group);
+static const std::string DESKTOP_FILE_NODISPLAY(DesktopEntry::Keys::no_display);
+static const std::string DESKTOP_FILE_ONLYSHOWIN(DesktopEntry::Keys::only_show_in);
 static const std::string ONLYSHOWIN_UNITY("Unity");
+// apps whose departments are looked up together while enumerating
+static const std::size_t DEPARTMENT_BATCH_SIZE = 32;
 
 Interface::Interface(const QSharedPointer<click::KeyFileLocator>& keyFileLocator)
     : keyFileLocator(keyFileLocator)
@@ -161,6 +128,20 @@ bool Interface::is_visible_app(const unity::util::IniParser &keyFile)
     return true;
 }
 
+bool Interface::is_visible_app(const DesktopEntry& entry)
+{
+    if (entry.no_display) {
+        return false;
+    }
+
+    if (entry.has_only_show_in) {
+        return std::find(entry.only_show_in.begin(), entry.only_show_in.end(),
+                         ONLYSHOWIN_UNITY) != entry.only_show_in.end();
+    }
+
+    return true;
+}
+
 std::string Interface::get_translated_string(const unity::util::IniParser& keyFile,
                                              const std::string& group,
                                              const std::string& key,
@@ -177,37 +158,29 @@ std::string Interface::get_translated_string(const unity::util::IniParser& keyFi
 
 click::Application Interface::load_app_from_desktop(const unity::util::IniParser& keyFile,
                                                     const std::string& filename)
+{
+    return load_app_from_desktop(DesktopEntry::from_key_file(keyFile, filename,
+                                                             Configuration().get_language()));
+}
+
+click::Application Interface::load_app_from_desktop(const DesktopEntry& entry)
 {
     Application app;
-    std::string domain;
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_KEY_DOMAIN)) {
-        domain = keyFile.get_string(DESKTOP_FILE_GROUP,
-                                    DESKTOP_FILE_KEY_DOMAIN);
-    }
-    app.title = get_translated_string(keyFile,
-                                      DESKTOP_FILE_GROUP,
-                                      DESKTOP_FILE_KEY_NAME,
-                                      domain);
-
-    app.url = "application:///" + filename;
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_KEY_ICON)) {
-        app.icon_url = add_theme_scheme(keyFile.get_string(DESKTOP_FILE_GROUP,
-                                                           DESKTOP_FILE_KEY_ICON));
-    }
+    app.title = entry.name;
 
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_KEY_KEYWORDS)) {
-        app.keywords = keyFile.get_string_array(DESKTOP_FILE_GROUP,
-                                                DESKTOP_FILE_KEY_KEYWORDS);
+    app.url = "application:///" + entry.filename;
+    if (entry.has_icon) {
+        app.icon_url = add_theme_scheme(entry.icon);
     }
 
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_UBUNTU_DEFAULT_DEPARTMENT)) {
-        app.default_department = keyFile.get_string(DESKTOP_FILE_GROUP, DESKTOP_FILE_UBUNTU_DEFAULT_DEPARTMENT);
-    }
+    app.keywords = entry.keywords;
+    app.search_title = entry.search_name;
+    app.search_keywords = entry.search_keywords;
+    app.sort_key = entry.sort_key;
+    app.default_department = entry.default_department;
 
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_KEY_APP_ID)) {
-        QString app_id = QString::fromStdString(keyFile.get_string(
-                DESKTOP_FILE_GROUP,
-                DESKTOP_FILE_KEY_APP_ID));
+    if (entry.has_app_id) {
+        QString app_id = QString::fromStdString(entry.app_id);
         QStringList id = app_id.split("_", QString::SkipEmptyParts);
         if (id.length() == 3) {
             app.name = id[0].toUtf8().data();
@@ -218,60 +191,59 @@ click::Application Interface::load_app_from_desktop(const unity::util::IniParser
             app.version = "unknown";
         }
     }
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_COMMENT)) {
-        app.description = get_translated_string(keyFile,
-                                                DESKTOP_FILE_GROUP,
-                                                DESKTOP_FILE_COMMENT,
-                                                domain);
-    }
-    if (keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_SCREENSHOT)) {
-        app.main_screenshot = keyFile.get_string(DESKTOP_FILE_GROUP,
-                                                 DESKTOP_FILE_SCREENSHOT);
-    }
+    app.description = entry.comment;
+    app.main_screenshot = entry.screenshot;
     return app;
 }
 
 std::vector<click::Application> Interface::sort_apps(const std::vector<click::Application>& apps)
 {
-    std::vector<click::Application> result = apps;
-    boost::locale::generator gen;
-    const char* lang = getenv(click::Configuration::LANGUAGE_ENVVAR);
-    if (lang == NULL) {
-        lang = "C.UTF-8";
+    return sort_apps(std::vector<click::Application>(apps));
+}
+
+std::vector<click::Application> Interface::sort_apps(std::vector<click::Application>&& apps)
+{
+    std::vector<click::Application> result(std::move(apps));
+
+    // apps from the catalog come with their collation key
+    const std::string language = click::collation_language();
+    for (auto& app: result) {
+        if (app.sort_key.empty()) {
+            app.sort_key = click::collation_key(app.title, language);
+        }
     }
-    std::locale loc = gen(lang);
-    std::locale::global(loc);
-    typedef boost::locale::collator<char> coll_type;
-
-    // Sort applications alphabetically.
-    std::sort(result.begin(), result.end(), [&loc](const Application& a,
-                                                   const Application& b) {
-                  bool lesser = false;
-                  int order = std::use_facet<coll_type>(loc)
-                      .compare(boost::locale::collator_base::quaternary,
-                               a.title, b.title);
+
+    // Sort applications alphabetically; comparing the collation keys
+    // bytewise is equivalent to comparing the titles with the collator.
+    std::sort(result.begin(), result.end(), [](const Application& a,
+                                               const Application& b) {
+                  int order = a.sort_key.compare(b.sort_key);
                   if (order == 0) {
-                      lesser = a.name < b.name;
-                  } else {
-                      // Because compare returns int, not bool, we have to check
-                      // that 0 is greater than the result, which tells us the
-                      // first element should be sorted priori
-                      lesser = order < 0;
+                      return a.name < b.name;
                   }
-                  return lesser;
+                  return order < 0;
               });
 
     return result;
 }
 
-/* find_installed_apps()
+/* enumerate_installed_apps()
  *
- * Find all of the installed apps matching @search_query in a timeout.
+ * Passes all of the installed apps matching @search_query to @accept, in
+ * the order in which the key file locator enumerates them. Once @cancellation
+ * is set, the remaining entries are skipped.
+ *
+ * With a departments db, apps are filtered by text first, and the departments
+ * of every DEPARTMENT_BATCH_SIZE remaining apps are then looked up with a
+ * single call before they are filtered by department, so that the first
+ * apps are passed on before the enumeration finishes.
  */
-std::vector<click::Application> Interface::find_installed_apps(const std::string& search_query,
+void Interface::enumerate_installed_apps(const std::string& search_query,
         const std::vector<std::string>& ignored_apps,
         const std::string& current_department,
-        const std::shared_ptr<click::DepartmentsDb>& depts_db)
+        const std::shared_ptr<click::DepartmentsDb>& depts_db,
+        const CancellationToken& cancellation,
+        const AppSink& accept)
 {
     //
     // only apply department filtering if not in root of all departments.
@@ -292,35 +264,33 @@ std::vector<click::Application> Interface::find_installed_apps(const std::string
         }
     }
 
-    std::vector<Application> result;
-
     bool include_desktop_results = show_desktop_apps();
-    auto enumerator = [&result, this, search_query, ignored_apps, current_department, packages_in_department, apply_department_filter, include_desktop_results, depts_db]
-            (const unity::util::IniParser& keyFile, const std::string& filename)
+    const std::string normalized_query = search_query.empty() ? std::string() : search_key(search_query);
+
+    // matching apps that are still subject to department filtering, with the
+    // id they are stored under in the departments db
+    std::vector<std::pair<Application, std::string>> pending;
+
+    // looks up the departments of the pending apps at once, and passes on
+    // the ones in the current department
+    auto resolve_pending = [&accept, &cancellation, &pending, &depts_db, &current_department,
+                            &packages_in_department, apply_department_filter]()
     {
-        if (keyFile.has_group(DESKTOP_FILE_GROUP) == false) {
-            qWarning() << "Broken desktop file:" << QString::fromStdString(filename);
-            return;
-        }
-        if (is_visible_app(keyFile) == false) {
-            return; // from the enumerator lambda
+        std::vector<std::string> department_keys;
+        department_keys.reserve(pending.size());
+        for (auto const& p: pending) {
+            department_keys.push_back(p.second);
         }
+        const auto departments = depts_db->get_departments_for_packages(department_keys);
 
-        if (include_desktop_results || keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_UBUNTU_TOUCH)
-            || keyFile.has_key(DESKTOP_FILE_GROUP, DESKTOP_FILE_KEY_APP_ID)
-            || Interface::is_non_click_app(QString::fromStdString(filename))) {
-            auto app = load_app_from_desktop(keyFile, filename);
-            auto app_id = app.name.empty() ? filename : app.name;
-            if (!ignored_apps.empty() &&
-                std::find(ignored_apps.begin(), ignored_apps.end(),
-                          app_id) != ignored_apps.end())
-            {
-                // The app is ignored. Get out of here.
-                return;
+        for (auto& p: pending) {
+            if (cancellation.is_cancelled()) {
+                break;
             }
-
-            // app from click package has non-empty name; for non-click apps use desktop filename
-            const std::string department_key = app.name.empty() ? filename : app.name;
+            Application& app = p.first;
+            const std::string& department_key = p.second;
+            auto const dept = departments.find(department_key);
+            const bool in_db = dept != departments.end();
 
             // check if apps is present in current department
             if (apply_department_filter)
@@ -330,21 +300,21 @@ std::vector<click::Application> Interface::find_installed_apps(const std::string
                     if (app.default_department.empty())
                     {
                         // default department not present in the keyfile, skip this app
-                        return;
+                        continue;
                     }
                     else
                     {
                         // default department not empty: check if this app is in a different
                         // department in the db (i.e. got moved from the default department);
-                        if (depts_db->has_package(department_key))
+                        if (in_db)
                         {
                             // app is now in a different department
-                            return;
+                            continue;
                         }
 
                         if (app.default_department != current_department)
                         {
-                            return;
+                            continue;
                         }
                         // else - this package is in current department
                     }
@@ -355,56 +325,159 @@ std::vector<click::Application> Interface::find_installed_apps(const std::string
             // the packages_in_department set contains packages from
             // all its subdepartments; we need to find actual department now
             // to update app.real_department.
-            if (depts_db)
+            if (in_db)
             {
-                if (depts_db->has_package(department_key))
-                {
-                    try
-                    {
-                        app.real_department = depts_db->get_department_for_package(department_key);
-                    }
-                    catch (const std::exception &e)
-                    {
-                        qWarning() << "Failed to get department of package:" << QString::fromStdString(department_key);
-                    }
-                }
-                else
+                app.real_department = dept->second;
+            }
+            else
+            {
+                app.real_department = app.default_department;
+                if (app.real_department.empty())
                 {
-                    app.real_department = app.default_department;
-                    if (app.real_department.empty())
-                    {
-                        qWarning() << "No default department set in the .desktop file and no entry in the database for" << QString::fromStdString(department_key);
-                    }
+                    qWarning() << "No default department set in the .desktop file and no entry in the database for" << QString::fromStdString(department_key);
                 }
             }
 
-            if (search_query.empty()) {
-                result.push_back(app);
-            } else {
-                QString lquery = ::unaccent(QString::fromStdString(search_query));
-
-                // Check keywords for the search query as well.
-                for (auto kwd: app.keywords) {
-                    QString keyword = ::unaccent(QString::fromStdString(kwd));
-                    if (!keyword.isEmpty()
-                        && keyword.contains(lquery, Qt::CaseInsensitive)) {
-                        result.push_back(app);
-                        return;
-                    }
-                }
+            accept(app);
+        }
+        pending.clear();
+    };
 
-                QString search_title = ::unaccent(QString::fromStdString(app.title));
-                // check the app title for the search query.
-                if (!search_title.isEmpty()
-                    && search_title.contains(lquery, Qt::CaseInsensitive)) {
-                    result.push_back(app);
-                }
+    auto enumerator = [&accept, &cancellation, &pending, &resolve_pending, this, &search_query, &normalized_query, &ignored_apps, include_desktop_results, &depts_db]
+            (const DesktopEntry& entry)
+    {
+        if (cancellation.is_cancelled()) {
+            return;
+        }
+        const std::string& filename = entry.filename;
+        if (entry.has_desktop_group == false) {
+            qWarning() << "Broken desktop file:" << QString::fromStdString(filename);
+            return;
+        }
+        if (is_visible_app(entry) == false) {
+            return; // from the enumerator lambda
+        }
+
+        if (include_desktop_results || entry.ubuntu_touch || entry.has_app_id
+            || Interface::is_non_click_app(QString::fromStdString(filename))) {
+            auto app = load_app_from_desktop(entry);
+            auto app_id = app.name.empty() ? filename : app.name;
+            if (!ignored_apps.empty() &&
+                std::find(ignored_apps.begin(), ignored_apps.end(),
+                          app_id) != ignored_apps.end())
+            {
+                // The app is ignored. Get out of here.
+                return;
+            }
+
+            if (!search_query.empty() && !matches_search_key(app, normalized_query)) {
+                return;
+            }
+
+            if (!depts_db) {
+                accept(app);
+                return;
+            }
+
+            // app from click package has non-empty name; for non-click apps use desktop filename
+            std::string department_key = app.name.empty() ? filename : app.name;
+            pending.push_back(std::make_pair(std::move(app), std::move(department_key)));
+            if (pending.size() >= DEPARTMENT_BATCH_SIZE) {
+                resolve_pending();
             }
         }
     };
 
-    keyFileLocator->enumerateKeyFilesForInstalledApplications(enumerator);
-    return sort_apps(result);
+    if (normalized_query.empty()) {
+        keyFileLocator->enumerateDesktopEntriesForInstalledApplications(enumerator);
+    } else {
+        keyFileLocator->enumerateDesktopEntriesMatching(normalized_query, enumerator);
+    }
+
+    if (depts_db && !pending.empty() && !cancellation.is_cancelled()) {
+        resolve_pending();
+    }
+}
+
+/* matches_search_key()
+ *
+ * Checks if the title or one of the keywords of @app contains
+ * @normalized_query, a search_key() of the query.
+ */
+bool Interface::matches_search_key(const Application& app, const std::string& normalized_query)
+{
+    // Check keywords for the search query as well.
+    for (auto const& keyword: app.search_keywords) {
+        if (search_key_contains(keyword, normalized_query)) {
+            return true;
+        }
+    }
+
+    // check the app title for the search query.
+    return search_key_contains(app.search_title, normalized_query);
+}
+
+/* find_installed_apps()
+ *
+ * Find all of the installed apps matching @search_query in a timeout.
+ */
+std::vector<click::Application> Interface::find_installed_apps(const std::string& search_query,
+        const std::vector<std::string>& ignored_apps,
+        const std::string& current_department,
+        const std::shared_ptr<click::DepartmentsDb>& depts_db,
+        const CancellationToken& cancellation)
+{
+    std::vector<Application> result;
+    enumerate_installed_apps(search_query, ignored_apps, current_department, depts_db, cancellation,
+                             [&result](const Application& app) {
+        result.push_back(app);
+    });
+    if (cancellation.is_cancelled()) {
+        return std::vector<Application>();
+    }
+    return sort_apps(std::move(result));
+}
+
+/* stream_installed_apps()
+ *
+ * Like find_installed_apps(), but passes the apps to @sink in sorted order.
+ * If the key file locator enumerates entries in collation order, every app
+ * is passed on as soon as no app that sorts before it can follow, so the
+ * first results are available before the enumeration finishes.
+ */
+void Interface::stream_installed_apps(const std::string& search_query,
+        const std::vector<std::string>& ignored_apps,
+        const std::string& current_department,
+        const std::shared_ptr<click::DepartmentsDb>& depts_db,
+        const AppSink& sink,
+        const CancellationToken& cancellation)
+{
+    if (!keyFileLocator || !keyFileLocator->enumeratesInCollationOrder()) {
+        for (auto const& app: find_installed_apps(search_query, ignored_apps, current_department, depts_db, cancellation)) {
+            sink(app);
+        }
+        return;
+    }
+
+    // apps with the same collation key are ordered by name, so hold back
+    // each run of equal keys until the next key shows up
+    std::vector<Application> run;
+    auto flush = [&run, &sink]() {
+        for (auto const& app: sort_apps(std::move(run))) {
+            sink(app);
+        }
+        run.clear();
+    };
+    enumerate_installed_apps(search_query, ignored_apps, current_department, depts_db, cancellation,
+                             [&run, &flush](const Application& app) {
+        if (!run.empty() && run.front().sort_key != app.sort_key) {
+            flush();
+        }
+        run.push_back(app);
+    });
+    if (!cancellation.is_cancelled()) {
+        flush();
+    }
 }
 
 /* is_non_click_app()
@@ -440,58 +513,49 @@ std::string Interface::add_theme_scheme(const std::string& icon_id)
     return icon_id;
 }
 
-ManifestList manifest_list_from_json(const std::string& json)
+/*
+ * manifest_from_list_entry()
+ *
+ * Manifest of an entry of 'click list --manifest' output
+ */
+static Manifest manifest_from_list_entry(const boost::property_tree::ptree& node)
 {
     using namespace boost::property_tree;
 
-    std::istringstream is(json);
+    Manifest manifest;
 
-    ptree pt;
-    read_json(is, pt);
+    manifest.name = node.get<std::string>("name");
+    manifest.version = node.get<std::string>("version");
+    manifest.removable = node.get<bool>("_removable");
 
-    ManifestList manifests;
-
-    BOOST_FOREACH(ptree::value_type &v, pt)
+    BOOST_FOREACH(const ptree::value_type &sv, node.get_child("hooks"))
     {
-        assert(v.first.empty()); // array elements have no names
-        auto node = v.second;
-        Manifest manifest;
-
-        manifest.name = node.get<std::string>("name");
-        manifest.version = node.get<std::string>("version");
-        manifest.removable = node.get<bool>("_removable");
-
-        BOOST_FOREACH(ptree::value_type &sv, node.get_child("hooks"))
-        {
-            // FIXME: "primary app" for a package is not defined, we just
-            // use first one here:
-            manifest.first_app_name = sv.first;
-            break;
-        }
-        qDebug() << "adding manifest: " << manifest.name.c_str() << manifest.version.c_str() << manifest.first_app_name.c_str();
-
-        manifests.push_back(manifest);
+        // FIXME: "primary app" for a package is not defined, we just
+        // use first one here:
+        manifest.first_app_name = sv.first;
+        break;
     }
+    qDebug() << "adding manifest: " << manifest.name.c_str() << manifest.version.c_str() << manifest.first_app_name.c_str();
 
-    return manifests;
+    return manifest;
 }
 
-Manifest manifest_from_json(const std::string& json)
+/*
+ * manifest_from_info()
+ *
+ * Manifest of 'click info' output
+ */
+static Manifest manifest_from_info(const boost::property_tree::ptree& pt)
 {
     using namespace boost::property_tree;
 
-    std::istringstream is(json);
-
-    ptree pt;
-    read_json(is, pt);
-
     Manifest manifest;
 
     manifest.name = pt.get<std::string>("name");
     manifest.version = pt.get<std::string>("version");
     manifest.removable = pt.get<bool>("_removable");
 
-    BOOST_FOREACH(ptree::value_type &sv, pt.get_child("hooks"))
+    BOOST_FOREACH(const ptree::value_type &sv, pt.get_child("hooks"))
     {
         // FIXME: "primary app or scope" for a package is not defined,
         // we just use the first one in the manifest:
@@ -509,8 +573,87 @@ Manifest manifest_from_json(const std::string& json)
     return manifest;
 }
 
+ManifestList manifest_list_from_json(const std::string& json)
+{
+    using namespace boost::property_tree;
+
+    std::istringstream is(json);
+
+    ptree pt;
+    read_json(is, pt);
+
+    ManifestList manifests;
+
+    BOOST_FOREACH(ptree::value_type &v, pt)
+    {
+        assert(v.first.empty()); // array elements have no names
+        manifests.push_back(manifest_from_list_entry(v.second));
+    }
+
+    return manifests;
+}
+
+Manifest manifest_from_json(const std::string& json)
+{
+    using namespace boost::property_tree;
+
+    std::istringstream is(json);
+
+    ptree pt;
+    read_json(is, pt);
+
+    return manifest_from_info(pt);
+}
+
+/*
+ * click_database()
+ *
+ * Database of the user, or an invalid one if the click tool has to be
+ * run instead of reading it
+ */
+static ClickDatabase click_database()
+{
+    const char* backend = getenv(Interface::ENV_CLICK_BACKEND);
+    if (backend != nullptr && strcmp(backend, "process") == 0) {
+        return ClickDatabase({}, "");
+    }
+    return ClickDatabase();
+}
+
+/*
+ * read_manifest()
+ *
+ * Manifest of a registered package, with the _removable key that the
+ * click tool adds to it
+ */
+static boost::property_tree::ptree read_manifest(const ClickDatabase::Registration& registration)
+{
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json(registration.manifest_path(), pt);
+    pt.put("_removable", registration.removable);
+    return pt;
+}
+
 void Interface::get_manifests(std::function<void(ManifestList, InterfaceError)> callback)
 {
+    const ClickDatabase db = click_database();
+    if (db.is_valid()) {
+        ManifestList manifests;
+        bool read = false;
+        try {
+            for (auto const& registration: db.registrations()) {
+                manifests.push_back(manifest_from_list_entry(read_manifest(registration)));
+            }
+            read = true;
+        } catch (const std::exception& e) {
+            qWarning() << "Can't read click database, running click instead:" << e.what();
+        }
+        if (read) {
+            callback(manifests, InterfaceError::NoError);
+            return;
+        }
+    }
+
     std::string command = "click list --manifest";
     qDebug() << "Running command:" << command.c_str();
     run_process(command, [callback](int code, const std::string& stdout_data, const std::string& stderr_data) {
@@ -559,6 +702,19 @@ PackageSet package_names_from_stdout(const std::string& stdout_data)
 
 void Interface::get_installed_packages(std::function<void(PackageSet, InterfaceError)> callback)
 {
+    const ClickDatabase db = click_database();
+    if (db.is_valid()) {
+        PackageSet installed_packages;
+        for (auto const& registration: db.registrations()) {
+            Package p;
+            p.name = registration.name;
+            p.version = registration.version;
+            installed_packages.insert(p);
+        }
+        callback(installed_packages, InterfaceError::NoError);
+        return;
+    }
+
     std::string command = "click list";
     qDebug() << "Running command:" << command.c_str();
     run_process(command, [callback](int code, const std::string& stdout_data, const std::string& stderr_data) {
@@ -580,6 +736,26 @@ void Interface::get_installed_packages(std::function<void(PackageSet, InterfaceE
 void Interface::get_manifest_for_app(const std::string &app_id,
                                      std::function<void(Manifest, InterfaceError)> callback)
 {
+    // anything the database can't answer, such as paths to .click files,
+    // is left to the click tool
+    const ClickDatabase db = click_database();
+    ClickDatabase::Registration registration;
+    if (db.is_valid() && db.find(app_id, registration)) {
+        Manifest manifest;
+        bool read = false;
+        try {
+            manifest = manifest_from_info(read_manifest(registration));
+            read = true;
+        } catch (const std::exception& e) {
+            qWarning() << "Can't read manifest of" << QString::fromStdString(app_id)
+                       << ", running click instead:" << e.what();
+        }
+        if (read) {
+            callback(manifest, InterfaceError::NoError);
+            return;
+        }
+    }
+
     std::string command = "click info " + app_id;
     qDebug() << "Running command:" << command.c_str();
     run_process(command, [callback, app_id](int code, const std::string& stdout_data, const std::string& stderr_data) {
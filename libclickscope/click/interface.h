@@ -38,6 +38,7 @@
 #include <unordered_set>
 
 #include "application.h"
+#include "cancellation.h"
 #include "package.h"
 
 // The dbus-send command to refresh the search results in the dash.
@@ -49,6 +50,7 @@ namespace click
 
 class KeyFileLocator;
 class DepartmentsDb;
+struct DesktopEntry;
 
 // Hash map of desktop files that are not yet click packages
 const std::unordered_set<std::string>& nonClickDesktopFiles();
@@ -95,21 +97,38 @@ public:
                                               const std::string& domain);
     virtual Application load_app_from_desktop(const unity::util::IniParser& keyFile,
                                               const std::string& filename);
+    virtual Application load_app_from_desktop(const DesktopEntry& entry);
     static std::vector<Application> sort_apps(const std::vector<Application>& apps);
+    static std::vector<Application> sort_apps(std::vector<Application>&& apps);
     virtual std::vector<Application> find_installed_apps(const std::string& search_query,
             const std::vector<std::string>& ignored_apps = std::vector<std::string>{},
             const std::string& current_department = "",
-            const std::shared_ptr<click::DepartmentsDb>& depts_db = nullptr);
+            const std::shared_ptr<click::DepartmentsDb>& depts_db = nullptr,
+            const CancellationToken& cancellation = CancellationToken());
+
+    typedef std::function<void(const Application&)> AppSink;
+    virtual void stream_installed_apps(const std::string& search_query,
+            const std::vector<std::string>& ignored_apps,
+            const std::string& current_department,
+            const std::shared_ptr<click::DepartmentsDb>& depts_db,
+            const AppSink& sink,
+            const CancellationToken& cancellation = CancellationToken());
 
     static bool is_non_click_app(const QString& filename);
+    static bool matches_search_key(const Application& app, const std::string& normalized_query);
 
     static bool is_icon_identifier(const std::string &icon_id);
     static std::string add_theme_scheme(const std::string &filename);
+    // These read the click database directly (see click-database.h) and
+    // call back right away; they run the click tool instead if the database
+    // can't be read, or if CLICK_SCOPE_CLICK_BACKEND is set to "process".
     virtual void get_manifests(std::function<void(ManifestList, InterfaceError)> callback);
     virtual void get_installed_packages(std::function<void(PackageSet, InterfaceError)> callback);
     virtual void get_manifest_for_app(const std::string &app_id, std::function<void(Manifest, InterfaceError)> callback);
     constexpr static const char* ENV_SHOW_DESKTOP_APPS {"CLICK_SCOPE_SHOW_DESKTOP_APPS"};
+    constexpr static const char* ENV_CLICK_BACKEND {"CLICK_SCOPE_CLICK_BACKEND"};
     virtual bool is_visible_app(const unity::util::IniParser& keyFile);
+    virtual bool is_visible_app(const DesktopEntry& entry);
     virtual bool show_desktop_apps();
 
     virtual void run_process(const std::string& command,
@@ -117,6 +136,13 @@ public:
                                                 const std::string& stdout_data,
                                                 const std::string& stderr_data)> callback);
 private:
+    void enumerate_installed_apps(const std::string& search_query,
+            const std::vector<std::string>& ignored_apps,
+            const std::string& current_department,
+            const std::shared_ptr<click::DepartmentsDb>& depts_db,
+            const CancellationToken& cancellation,
+            const AppSink& accept);
+
     QSharedPointer<KeyFileLocator> keyFileLocator;
 };
 
@@ -29,15 +29,26 @@
 
 #include "key_file_locator.h"
 
+#include <click/configuration.h>
+#include <click/desktop-entry.h>
+#include <click/desktop-entry-parser.h>
+#include <click/desktop-file-cache.h>
+#include <click/worker-pool.h>
+
 #include <unity/Exception.h>
 #include <unity/UnityExceptions.h>
 #include <unity/util/IniParser.h>
 
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QStandardPaths>
 #include <QString>
 
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
 namespace
 {
 static const QString NON_CLICK_PATH("/usr/share/applications");
@@ -61,6 +72,62 @@ void find_apps_in_dir(const QString& dir_path,
         }
     }
 }
+
+// A desktop file found while scanning the application directories.
+struct ScannedFile
+{
+    std::string filename;
+    std::string path;
+    click::DesktopFileCache::Stamp stamp;
+    bool cacheable = false;
+    bool cached = false;
+    bool valid = false;
+    click::DesktopEntry entry;
+};
+
+void list_desktop_files(const QString& dir_path, std::vector<ScannedFile>& files)
+{
+    QDir dir(dir_path, "*.desktop",
+             QDir::Unsorted, QDir::Readable | QDir::Files);
+    QStringList entries = dir.entryList();
+    for (int i = 0; i < entries.size(); ++i) {
+        ScannedFile file;
+        file.filename = entries.at(i).toStdString();
+        file.path = dir.absoluteFilePath(entries.at(i)).toStdString();
+        files.push_back(file);
+    }
+}
+
+bool parse_desktop_file(ScannedFile& file, const std::string& language,
+                        click::KeyFileLocator::DesktopParser parser)
+{
+    try {
+        if (parser == click::KeyFileLocator::DesktopParser::Mapped) {
+            file.entry = click::DesktopEntry::from_parser(click::DesktopEntryParser(file.path, language),
+                                                          file.filename);
+        } else {
+            file.entry = click::DesktopEntry::from_key_file(unity::util::IniParser(file.path.c_str()),
+                                                            file.filename, language);
+        }
+        return true;
+    } catch (const unity::FileException& file_exp) {
+        qWarning() << "Error reading file:" << file_exp.to_string().c_str();
+    } catch (const unity::LogicException& logic_exp) {
+        qCritical() << "Error reading file:" << logic_exp.to_string().c_str();
+    } catch (const std::runtime_error& exp) {
+        qWarning() << "Error reading file:" << file.path.c_str() << exp.what();
+    }
+    return false;
+}
+
+click::KeyFileLocator::DesktopParser desktop_parser_from_env()
+{
+    const char* parser = getenv(click::KeyFileLocator::ENV_DESKTOP_PARSER);
+    if (parser != nullptr && strcmp(parser, "mapped") == 0) {
+        return click::KeyFileLocator::DesktopParser::Mapped;
+    }
+    return click::KeyFileLocator::DesktopParser::KeyFile;
+}
 }
 
 const std::string& click::KeyFileLocator::systemApplicationsDirectory()
@@ -78,12 +145,48 @@ const std::string& click::KeyFileLocator::userApplicationsDirectory()
     return s;
 }
 
+const std::string& click::KeyFileLocator::desktopFileCachePath()
+{
+    static const std::string s
+    {
+        qPrintable(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/click-desktop-files.cache")
+    };
+    return s;
+}
+
 click::KeyFileLocator::KeyFileLocator(
         const std::string& systemApplicationsDir,
-        const std::string& userApplicationsDir)
+        const std::string& userApplicationsDir,
+        const std::string& desktopFileCache)
     : systemApplicationsDir(systemApplicationsDir),
-      userApplicationsDir(userApplicationsDir)
+      userApplicationsDir(userApplicationsDir),
+      desktopFileCache(desktopFileCache),
+      parallelParsing(getenv(ENV_SERIAL_SCAN) == nullptr),
+      desktopParser(desktop_parser_from_env())
+{
+}
+
+void click::KeyFileLocator::setParallelParsing(bool enabled)
 {
+    parallelParsing = enabled;
+}
+
+void click::KeyFileLocator::setDesktopParser(DesktopParser parser)
+{
+    desktopParser = parser;
+}
+
+std::shared_ptr<click::DesktopFileCache> click::KeyFileLocator::cacheForLanguage(const std::string& language)
+{
+    if (desktopFileCache.empty()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!cache || cache->language() != language) {
+        QDir("/").mkpath(QFileInfo(QString::fromStdString(desktopFileCache)).absolutePath());
+        cache.reset(new click::DesktopFileCache(desktopFileCache, language));
+    }
+    return cache;
 }
 
 void click::KeyFileLocator::enumerateKeyFilesForInstalledApplications(
@@ -92,3 +195,68 @@ void click::KeyFileLocator::enumerateKeyFilesForInstalledApplications(
     find_apps_in_dir(QString::fromStdString(systemApplicationsDir), enumerator);
     find_apps_in_dir(QString::fromStdString(userApplicationsDir), enumerator);
 }
+
+void click::KeyFileLocator::enumerateDesktopEntriesForInstalledApplications(
+        const click::KeyFileLocator::EntryEnumerator& enumerator)
+{
+    const std::string language = click::Configuration().get_language();
+    auto cache = cacheForLanguage(language);
+
+    std::vector<ScannedFile> files;
+    list_desktop_files(QString::fromStdString(systemApplicationsDir), files);
+    list_desktop_files(QString::fromStdString(userApplicationsDir), files);
+
+    if (cache) {
+        cache->begin_scan();
+    }
+
+    std::vector<std::size_t> stale;
+    for (std::size_t i = 0; i < files.size(); i++) {
+        auto& file = files[i];
+        file.cacheable = cache && click::DesktopFileCache::stamp_for(file.path, file.stamp);
+        file.cached = file.cacheable && cache->lookup(file.path, file.stamp, file.entry);
+        file.valid = file.cached;
+        if (!file.cached) {
+            stale.push_back(i);
+        }
+    }
+
+    // parsing is what makes cold scans slow; results land in their own slot
+    // so that entries are reported in the same order as in serial mode
+    const auto parser = desktopParser;
+    auto parse = [&files, &stale, &language, parser](std::size_t i) {
+        auto& file = files[stale[i]];
+        file.valid = parse_desktop_file(file, language, parser);
+    };
+    click::parallel_for(stale.size(), parse, parallelParsing ? click::default_worker_count() : 1);
+
+    std::vector<std::string> cached_paths;
+    for (auto const& file: files) {
+        if (!file.valid) {
+            continue;
+        }
+        if (file.cacheable) {
+            if (!file.cached) {
+                cache->store(file.path, file.stamp, file.entry);
+            }
+            cached_paths.push_back(file.path);
+        }
+        enumerator(file.entry);
+    }
+
+    if (cache) {
+        cache->save(cached_paths);
+    }
+}
+
+void click::KeyFileLocator::enumerateDesktopEntriesMatching(
+        const std::string&,
+        const click::KeyFileLocator::EntryEnumerator& enumerator)
+{
+    enumerateDesktopEntriesForInstalledApplications(enumerator);
+}
+
+bool click::KeyFileLocator::enumeratesInCollationOrder() const
+{
+    return false;
+}
@@ -31,6 +31,8 @@
 #define CLICK_KEY_FILE_LOCATOR_H
 
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace unity
@@ -43,16 +45,32 @@ class IniParser;
 
 namespace click
 {
+struct DesktopEntry;
+class DesktopFileCache;
+
 class KeyFileLocator
 {
 public:
     static const std::string& systemApplicationsDirectory();
     static const std::string& userApplicationsDirectory();
+    static const std::string& desktopFileCachePath();
 
     typedef std::function<void(const unity::util::IniParser&, const std::string&)> Enumerator;
+    typedef std::function<void(const DesktopEntry&)> EntryEnumerator;
+
+    constexpr static const char* ENV_SERIAL_SCAN {"CLICK_SCOPE_SERIAL_SCAN"};
+    constexpr static const char* ENV_DESKTOP_PARSER {"CLICK_SCOPE_DESKTOP_PARSER"};
+
+    enum class DesktopParser
+    {
+        KeyFile, // unity::util::IniParser
+        Mapped   // click::DesktopEntryParser
+    };
 
+    // An empty desktopFileCache path disables the on-disk cache of parsed desktop files.
     KeyFileLocator(const std::string& systemApplicationsDir = systemApplicationsDirectory(),
-                   const std::string& userApplicationsDir = userApplicationsDirectory());
+                   const std::string& userApplicationsDir = userApplicationsDirectory(),
+                   const std::string& desktopFileCache = desktopFileCachePath());
     KeyFileLocator(const KeyFileLocator&) = delete;
     virtual ~KeyFileLocator() = default;
 
@@ -61,9 +79,39 @@ public:
 
     virtual void enumerateKeyFilesForInstalledApplications(const Enumerator& enumerator);
 
-private:
+    // Like enumerateKeyFilesForInstalledApplications(), but only re-parses
+    // desktop files that changed since they were last seen.
+    virtual void enumerateDesktopEntriesForInstalledApplications(const EntryEnumerator& enumerator);
+
+    // Enumerates at least the entries whose search keys contain the
+    // normalized query (see search-keys.h); callers still have to check
+    // each entry. The default implementation enumerates all entries.
+    virtual void enumerateDesktopEntriesMatching(const std::string& normalizedQuery,
+                                                 const EntryEnumerator& enumerator);
+
+    // True if entries are enumerated ordered by their DesktopEntry::sort_key.
+    virtual bool enumeratesInCollationOrder() const;
+
+    // Desktop files that aren't cached are parsed on a pool of worker threads
+    // unless this is disabled, or CLICK_SCOPE_SERIAL_SCAN is set.
+    void setParallelParsing(bool enabled);
+
+    // Parser used for desktop files that aren't cached. Defaults to
+    // IniParser; CLICK_SCOPE_DESKTOP_PARSER=mapped selects DesktopEntryParser.
+    void setDesktopParser(DesktopParser parser);
+
+protected:
     std::string systemApplicationsDir;
     std::string userApplicationsDir;
+    std::string desktopFileCache;
+
+private:
+    std::shared_ptr<DesktopFileCache> cacheForLanguage(const std::string& language);
+
+    std::mutex cacheMutex;
+    std::shared_ptr<DesktopFileCache> cache;
+    bool parallelParsing;
+    DesktopParser desktopParser;
 };
 }
 
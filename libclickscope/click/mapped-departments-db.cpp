@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "mapped-departments-db.h"
+#include "mapped-departments.h"
+
+#include <QDebug>
+#include <QString>
+
+#include <stdexcept>
+
+namespace click
+{
+
+namespace
+{
+// The -wal file is removed when the last connection to the database is
+// closed, once its changes were moved into the database file, and the next
+// connection creates it again, empty. An empty -wal file therefore matches
+// a missing one; any change to the data shows in the stamp of one of the
+// files.
+bool same_wal(const FileStamp& a, const FileStamp& b)
+{
+    return a == b || (a.size <= 0 && b.size <= 0);
+}
+}
+
+std::unique_ptr<DepartmentsDb> MappedDepartmentsDb::open(const std::string& db_path, const std::string& mapped_path)
+{
+    if (FileStamp::of(mapped_path).size < 0)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedDepartmentsDb> db(new MappedDepartmentsDb(db_path, mapped_path));
+    db->stamp_db_files(db->stamps_);
+    if (db->stamps_[0].size < 0)
+    {
+        return nullptr;
+    }
+
+    db->mapped_ = MappedDepartments::open(mapped_path);
+    if (!db->mapped_)
+    {
+        qWarning() << "Invalid departments file" << QString::fromStdString(mapped_path);
+        return nullptr;
+    }
+    if (db->mapped_->source(0) != db->stamps_[0] || !same_wal(db->mapped_->source(1), db->stamps_[1]))
+    {
+        qDebug() << "Departments database changed since" << QString::fromStdString(mapped_path) << "was written, not using it";
+        return nullptr;
+    }
+    return std::unique_ptr<DepartmentsDb>(db.release());
+}
+
+MappedDepartmentsDb::MappedDepartmentsDb(const std::string& db_path, const std::string& mapped_path)
+    : DepartmentsDb(db_path, Deferred()),
+      mapped_path_(mapped_path)
+{
+}
+
+MappedDepartmentsDb::~MappedDepartmentsDb()
+{
+    join_warm_up();
+}
+
+std::shared_ptr<const MappedDepartments> MappedDepartmentsDb::mapped()
+{
+    std::lock_guard<std::mutex> lock(mapped_mutex_);
+    if (mapped_)
+    {
+        FileStamp stamps[2];
+        stamp_db_files(stamps);
+        if (stamps[0] != stamps_[0] || !same_wal(stamps[1], stamps_[1]))
+        {
+            qDebug() << "Departments database changed, not using" << QString::fromStdString(mapped_path_) << "anymore";
+            mapped_.reset();
+        }
+    }
+    return mapped_;
+}
+
+void MappedDepartmentsDb::set_up_database() const
+{
+    std::call_once(set_up_flag_, [this]() {
+        const_cast<MappedDepartmentsDb*>(this)->set_up(false);
+    });
+}
+
+void MappedDepartmentsDb::stop_mapping()
+{
+    set_up_database();
+    std::lock_guard<std::mutex> lock(mapped_mutex_);
+    mapped_.reset();
+}
+
+std::string MappedDepartmentsDb::get_department_name(const std::string& department_id, const std::list<std::string>& locales)
+{
+    if (auto departments = mapped())
+    {
+        std::string name;
+        for (auto const& locale: locales)
+        {
+            if (departments->name_of(department_id, locale, name))
+            {
+                return name;
+            }
+        }
+        throw std::logic_error("No name for department " + department_id);
+    }
+    set_up_database();
+    return DepartmentsDb::get_department_name(department_id, locales);
+}
+
+std::unordered_set<std::string> MappedDepartmentsDb::get_packages_for_department(const std::string& department_id, bool recursive)
+{
+    if (auto departments = mapped())
+    {
+        return departments->packages_of(department_id, recursive);
+    }
+    set_up_database();
+    return DepartmentsDb::get_packages_for_department(department_id, recursive);
+}
+
+std::string MappedDepartmentsDb::get_department_for_package(const std::string& package_id)
+{
+    if (auto departments = mapped())
+    {
+        std::string department_id;
+        if (!departments->department_of(package_id, department_id))
+        {
+            throw std::logic_error("Unknown package '" + package_id + "'");
+        }
+        return department_id;
+    }
+    set_up_database();
+    return DepartmentsDb::get_department_for_package(package_id);
+}
+
+std::unordered_map<std::string, std::string> MappedDepartmentsDb::get_departments_for_packages(const std::vector<std::string>& package_ids)
+{
+    if (auto departments = mapped())
+    {
+        std::unordered_map<std::string, std::string> depts;
+        std::string department_id;
+        for (auto const& pkg: package_ids)
+        {
+            if (departments->department_of(pkg, department_id))
+            {
+                depts[pkg] = department_id;
+            }
+        }
+        return depts;
+    }
+    set_up_database();
+    return DepartmentsDb::get_departments_for_packages(package_ids);
+}
+
+bool MappedDepartmentsDb::is_empty(const std::string& department_id)
+{
+    if (auto departments = mapped())
+    {
+        return departments->is_empty(department_id);
+    }
+    set_up_database();
+    return DepartmentsDb::is_empty(department_id);
+}
+
+bool MappedDepartmentsDb::has_package(const std::string& package_id)
+{
+    if (auto departments = mapped())
+    {
+        return departments->has_package(package_id);
+    }
+    set_up_database();
+    return DepartmentsDb::has_package(package_id);
+}
+
+std::string MappedDepartmentsDb::get_parent_department_id(const std::string& department_id)
+{
+    if (auto departments = mapped())
+    {
+        return departments->parent_of(department_id);
+    }
+    set_up_database();
+    return DepartmentsDb::get_parent_department_id(department_id);
+}
+
+std::list<DepartmentsDb::DepartmentInfo> MappedDepartmentsDb::get_children_departments(const std::string& department_id)
+{
+    if (auto departments = mapped())
+    {
+        std::list<DepartmentInfo> depts;
+        for (auto const& child: departments->children_of(department_id))
+        {
+            depts.push_back(DepartmentInfo(child.first, child.second));
+        }
+        return depts;
+    }
+    set_up_database();
+    return DepartmentsDb::get_children_departments(department_id);
+}
+
+bool MappedDepartmentsDb::is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id)
+{
+    if (auto departments = mapped())
+    {
+        return departments->is_descendant_of(department_id, parent_department_id);
+    }
+    set_up_database();
+    return DepartmentsDb::is_descendant_of_department(department_id, parent_department_id);
+}
+
+std::unordered_map<std::string, std::string> MappedDepartmentsDb::get_top_departments_under(const std::string& department_id)
+{
+    if (auto departments = mapped())
+    {
+        return departments->top_departments_under(department_id);
+    }
+    set_up_database();
+    return DepartmentsDb::get_top_departments_under(department_id);
+}
+
+void MappedDepartmentsDb::store_package_mapping(const std::string& package_id, const std::string& department_id)
+{
+    stop_mapping();
+    DepartmentsDb::store_package_mapping(package_id, department_id);
+}
+
+void MappedDepartmentsDb::store_package_mapping_(const std::string& package_id, const std::string& department_id)
+{
+    stop_mapping();
+    DepartmentsDb::store_package_mapping_(package_id, department_id);
+}
+
+std::unordered_map<std::string, std::string> MappedDepartmentsDb::get_package_versions()
+{
+    // versions aren't part of the mapped file
+    set_up_database();
+    return DepartmentsDb::get_package_versions();
+}
+
+void MappedDepartmentsDb::store_package_version(const std::string& package_id, const std::string& version)
+{
+    stop_mapping();
+    DepartmentsDb::store_package_version(package_id, version);
+}
+
+void MappedDepartmentsDb::remove_all()
+{
+    stop_mapping();
+    DepartmentsDb::remove_all();
+}
+
+std::unordered_map<std::string, std::string> MappedDepartmentsDb::get_meta(const std::string& prefix)
+{
+    set_up_database();
+    return DepartmentsDb::get_meta(prefix);
+}
+
+void MappedDepartmentsDb::store_meta(const std::string& name, const std::string& value)
+{
+    stop_mapping();
+    DepartmentsDb::store_meta(name, value);
+}
+
+void MappedDepartmentsDb::remove_meta(const std::string& prefix)
+{
+    stop_mapping();
+    DepartmentsDb::remove_meta(prefix);
+}
+
+void MappedDepartmentsDb::store_department_mapping(const std::string& department_id, const std::string& parent_department_id)
+{
+    stop_mapping();
+    DepartmentsDb::store_department_mapping(department_id, parent_department_id);
+}
+
+void MappedDepartmentsDb::store_department_name(const std::string& department_id, const std::string& locale, const std::string& name)
+{
+    stop_mapping();
+    DepartmentsDb::store_department_name(department_id, locale, name);
+}
+
+int MappedDepartmentsDb::department_mapping_count() const
+{
+    set_up_database();
+    return DepartmentsDb::department_mapping_count();
+}
+
+int MappedDepartmentsDb::package_count() const
+{
+    set_up_database();
+    return DepartmentsDb::package_count();
+}
+
+int MappedDepartmentsDb::department_name_count() const
+{
+    set_up_database();
+    return DepartmentsDb::department_name_count();
+}
+
+void MappedDepartmentsDb::store_departments(const click::DepartmentList& depts, const std::string& locale)
+{
+    stop_mapping();
+    DepartmentsDb::store_departments(depts, locale);
+}
+
+void MappedDepartmentsDb::begin_bulk(bool relax_sync)
+{
+    stop_mapping();
+    DepartmentsDb::begin_bulk(relax_sync);
+}
+
+void MappedDepartmentsDb::commit_bulk()
+{
+    stop_mapping();
+    DepartmentsDb::commit_bulk();
+}
+
+void MappedDepartmentsDb::rollback_bulk()
+{
+    stop_mapping();
+    DepartmentsDb::rollback_bulk();
+}
+
+void MappedDepartmentsDb::warm_up(bool write_mapped)
+{
+    // lookups in the mapped file don't touch the database
+    if (!mapped())
+    {
+        set_up_database();
+        DepartmentsDb::warm_up(write_mapped);
+    }
+}
+
+bool MappedDepartmentsDb::warmed_up()
+{
+    // the mapped file needs no warm-up while it is used
+    return mapped() != nullptr || DepartmentsDb::warmed_up();
+}
+
+void MappedDepartmentsDb::export_mapped(const std::string& path)
+{
+    set_up_database();
+    DepartmentsDb::export_mapped(path);
+}
+
+} // namespace click
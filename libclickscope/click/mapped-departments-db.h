@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_MAPPED_DEPARTMENTS_DB_H
+#define CLICK_MAPPED_DEPARTMENTS_DB_H
+
+#include <click/departments-db.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace click
+{
+
+class MappedDepartments;
+
+// DepartmentsDb that answers reads from a MappedDepartments file.
+//
+// The file is only used while the database hasn't changed since it was
+// written: the stamps of the database files have to match the ones
+// recorded in it when it is opened, and it is dropped as soon as they
+// change. Until then the database
+// isn't touched at all, so no connection is opened and no statements are
+// prepared. Afterwards, and for all writes, the methods of DepartmentsDb
+// are used.
+class MappedDepartmentsDb : public DepartmentsDb
+{
+public:
+    // Returns nullptr if mapped_path doesn't exist, is invalid or was
+    // written from a different state of the database.
+    static std::unique_ptr<DepartmentsDb> open(const std::string& db_path, const std::string& mapped_path);
+    virtual ~MappedDepartmentsDb();
+
+    std::string get_department_name(const std::string& department_id, const std::list<std::string>& locales) override;
+    std::unordered_set<std::string> get_packages_for_department(const std::string& department_id, bool recursive = true) override;
+    std::string get_department_for_package(const std::string& package_id) override;
+    std::unordered_map<std::string, std::string> get_departments_for_packages(const std::vector<std::string>& package_ids) override;
+    bool is_empty(const std::string& department_id) override;
+    bool has_package(const std::string& package_id) override;
+    std::string get_parent_department_id(const std::string& department_id) override;
+    std::list<DepartmentInfo> get_children_departments(const std::string& department_id) override;
+    bool is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id) override;
+    std::unordered_map<std::string, std::string> get_top_departments_under(const std::string& department_id) override;
+
+    void store_package_mapping(const std::string& package_id, const std::string& department_id) override;
+    std::unordered_map<std::string, std::string> get_package_versions() override;
+    void store_package_version(const std::string& package_id, const std::string& version) override;
+    void remove_all() override;
+    std::unordered_map<std::string, std::string> get_meta(const std::string& prefix) override;
+    void store_meta(const std::string& name, const std::string& value) override;
+    void remove_meta(const std::string& prefix) override;
+    void store_department_mapping(const std::string& department_id, const std::string& parent_department_id) override;
+    void store_department_name(const std::string& department_id, const std::string& locale, const std::string& name) override;
+
+    int department_mapping_count() const override;
+    int package_count() const override;
+    int department_name_count() const override;
+
+    void store_departments(const click::DepartmentList& depts, const std::string& locale) override;
+
+    void begin_bulk(bool relax_sync = false) override;
+    void commit_bulk() override;
+    void rollback_bulk() override;
+
+    void warm_up(bool write_mapped = false) override;
+    bool warmed_up() override;
+    void export_mapped(const std::string& path) override;
+
+protected:
+    void store_package_mapping_(const std::string& package_id, const std::string& department_id) override;
+
+private:
+    MappedDepartmentsDb(const std::string& db_path, const std::string& mapped_path);
+
+    // The mapped file, or nullptr once the database changed.
+    std::shared_ptr<const MappedDepartments> mapped();
+    // Sets up the database on first use.
+    void set_up_database() const;
+    // Sets up the database and stops using the mapped file, before writes.
+    void stop_mapping();
+
+    std::string mapped_path_;
+    mutable std::once_flag set_up_flag_;
+
+    std::mutex mapped_mutex_;
+    std::shared_ptr<const MappedDepartments> mapped_;
+    // stamps of the database files when the mapped file was opened
+    FileStamp stamps_[2];
+};
+
+} // namespace click
+
+#endif // CLICK_MAPPED_DEPARTMENTS_DB_H
@@ -0,0 +1,627 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "mapped-departments.h"
+#include "departments-snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace click
+{
+
+namespace
+{
+const char MAGIC[8] = {'C', 'L', 'K', 'D', 'E', 'P', 'T', 'S'};
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+const std::uint32_t FORMAT_VERSION = 2;
+}
+
+struct MappedDepartments::Header
+{
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+
+    // FileStamps of the database file and its -wal file
+    std::int64_t source_mtime_ns[2];
+    std::int64_t source_size[2];
+    std::uint64_t source_inode[2];
+
+    std::uint32_t node_count;
+    std::uint32_t nodes_offset;
+    std::uint32_t child_count;
+    std::uint32_t children_offset;
+    std::uint32_t tour_offset; // node_count entries
+    std::uint32_t node_package_count;
+    std::uint32_t node_packages_offset;
+    std::uint32_t package_count;
+    std::uint32_t packages_offset;
+    std::uint32_t name_count;
+    std::uint32_t names_offset;
+    std::uint32_t strings_size;
+    std::uint32_t strings_offset;
+};
+
+// string in the string pool
+struct MappedDepartments::Str
+{
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+// department, sorted by id
+struct MappedDepartments::Node
+{
+    Str id;
+    // index of the parent node, or -1 for roots
+    std::int32_t parent;
+    // has a row in depts
+    std::uint32_t present;
+    std::uint32_t children_begin;
+    std::uint32_t children_count;
+    std::uint32_t packages_begin;
+    std::uint32_t packages_count;
+    // the subtree of the node is at [enter, exit) of the tour
+    std::uint32_t enter;
+    std::uint32_t exit;
+};
+
+// package and its first department, sorted by package id
+struct MappedDepartments::Package
+{
+    Str id;
+    std::uint32_t node;
+};
+
+// department name, sorted by locale and department id
+struct MappedDepartments::NameEntry
+{
+    Str locale;
+    Str department_id;
+    Str name;
+};
+
+namespace
+{
+
+class StringPool
+{
+public:
+    template <typename S>
+    S add(const std::string& s)
+    {
+        auto it = offsets.find(s);
+        if (it == offsets.end())
+        {
+            it = offsets.insert(std::make_pair(s, static_cast<std::uint32_t>(pool.size()))).first;
+            pool += s;
+        }
+        S str;
+        str.offset = it->second;
+        str.size = static_cast<std::uint32_t>(s.size());
+        return str;
+    }
+
+    const std::string& data() const
+    {
+        return pool;
+    }
+
+private:
+    std::string pool;
+    std::map<std::string, std::uint32_t> offsets;
+};
+
+template <typename T>
+void append(std::string& out, const T* items, std::size_t count)
+{
+    out.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+}
+
+// pads the output so that the next section starts at a multiple of 4
+std::uint32_t section_offset(std::string& out)
+{
+    out.append((4 - out.size() % 4) % 4, '\0');
+    return static_cast<std::uint32_t>(out.size());
+}
+
+}
+
+void MappedDepartments::write(const std::string& path, const FileStamp sources[2],
+                              const Rows& depts, const Rows& pkgmap, const std::vector<Name>& names)
+{
+    auto const snapshot = DepartmentsSnapshot::build(depts, pkgmap);
+    if (!snapshot)
+    {
+        throw std::runtime_error("Departments don't form a tree");
+    }
+    auto const& snapshot_nodes = snapshot->nodes;
+
+    // nodes are stored sorted by id, so they get new indexes
+    std::vector<int> order(snapshot_nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&snapshot_nodes](int a, int b) {
+        return snapshot_nodes[a].id < snapshot_nodes[b].id;
+    });
+    std::vector<std::uint32_t> index_of(snapshot_nodes.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        index_of[order[i]] = static_cast<std::uint32_t>(i);
+    }
+
+    StringPool pool;
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> children;
+    std::vector<Str> node_packages;
+    for (auto n: order)
+    {
+        auto const& from = snapshot_nodes[n];
+        Node node;
+        node.id = pool.add<Str>(from.id);
+        node.parent = from.parent < 0 ? -1 : static_cast<std::int32_t>(index_of[from.parent]);
+        node.present = from.present ? 1 : 0;
+        node.children_begin = static_cast<std::uint32_t>(children.size());
+        node.children_count = static_cast<std::uint32_t>(from.children.size());
+        for (auto child: from.children)
+        {
+            children.push_back(index_of[child]);
+        }
+        node.packages_begin = static_cast<std::uint32_t>(node_packages.size());
+        node.packages_count = static_cast<std::uint32_t>(from.packages.size());
+        for (auto const& pkg: from.packages)
+        {
+            node_packages.push_back(pool.add<Str>(pkg));
+        }
+        node.enter = static_cast<std::uint32_t>(from.enter);
+        node.exit = static_cast<std::uint32_t>(from.exit);
+        nodes.push_back(node);
+    }
+
+    std::vector<std::uint32_t> tour;
+    for (auto n: snapshot->tour)
+    {
+        tour.push_back(index_of[n]);
+    }
+
+    // std::map keeps packages sorted by id
+    std::map<std::string, std::uint32_t> sorted_packages;
+    for (auto const& pkg: snapshot->package_departments)
+    {
+        sorted_packages[pkg.first] = index_of[snapshot->index.at(pkg.second)];
+    }
+    std::vector<Package> packages;
+    for (auto const& pkg: sorted_packages)
+    {
+        Package package;
+        package.id = pool.add<Str>(pkg.first);
+        package.node = pkg.second;
+        packages.push_back(package);
+    }
+
+    std::vector<Name> sorted_names(names);
+    std::sort(sorted_names.begin(), sorted_names.end(), [](const Name& a, const Name& b) {
+        return a.locale != b.locale ? a.locale < b.locale : a.department_id < b.department_id;
+    });
+    std::vector<NameEntry> name_entries;
+    const Name* previous = nullptr;
+    for (auto const& name: sorted_names)
+    {
+        // like deptnames, only one name per department and locale
+        if (previous != nullptr && previous->locale == name.locale && previous->department_id == name.department_id)
+        {
+            continue;
+        }
+        previous = &name;
+        NameEntry entry;
+        entry.locale = pool.add<Str>(name.locale);
+        entry.department_id = pool.add<Str>(name.department_id);
+        entry.name = pool.add<Str>(name.name);
+        name_entries.push_back(entry);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.version = FORMAT_VERSION;
+    for (int i = 0; i < 2; i++)
+    {
+        header.source_mtime_ns[i] = sources[i].mtime_ns;
+        header.source_size[i] = sources[i].size;
+        header.source_inode[i] = sources[i].inode;
+    }
+
+    std::string out(sizeof(Header), '\0');
+    header.node_count = static_cast<std::uint32_t>(nodes.size());
+    header.nodes_offset = section_offset(out);
+    append(out, nodes.data(), nodes.size());
+    header.child_count = static_cast<std::uint32_t>(children.size());
+    header.children_offset = section_offset(out);
+    append(out, children.data(), children.size());
+    header.tour_offset = section_offset(out);
+    append(out, tour.data(), tour.size());
+    header.node_package_count = static_cast<std::uint32_t>(node_packages.size());
+    header.node_packages_offset = section_offset(out);
+    append(out, node_packages.data(), node_packages.size());
+    header.package_count = static_cast<std::uint32_t>(packages.size());
+    header.packages_offset = section_offset(out);
+    append(out, packages.data(), packages.size());
+    header.name_count = static_cast<std::uint32_t>(name_entries.size());
+    header.names_offset = section_offset(out);
+    append(out, name_entries.data(), name_entries.size());
+    header.strings_size = static_cast<std::uint32_t>(pool.data().size());
+    header.strings_offset = section_offset(out);
+    out += pool.data();
+    memcpy(&out[0], &header, sizeof(header));
+
+    // a name of its own, so that concurrent writers don't write into the
+    // same file
+    std::string tmp_path = path + ".XXXXXX";
+    const int fd = mkstemp(&tmp_path[0]);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot create a temporary file for " + path);
+    }
+    FILE* file = fdopen(fd, "wb");
+    if (file == nullptr)
+    {
+        ::close(fd);
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Cannot create " + tmp_path);
+    }
+    const bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    if (fclose(file) != 0 || !written || rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+std::shared_ptr<const MappedDepartments> MappedDepartments::open(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header)))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedDepartments> mapped(new MappedDepartments());
+    mapped->size = static_cast<std::size_t>(st.st_size);
+    mapped->data = mmap(nullptr, mapped->size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped->data == MAP_FAILED)
+    {
+        mapped->data = nullptr;
+        return nullptr;
+    }
+
+    const char* base = static_cast<const char*>(mapped->data);
+    mapped->header = reinterpret_cast<const Header*>(base);
+    if (!mapped->validate())
+    {
+        return nullptr;
+    }
+    auto const& header = *mapped->header;
+    mapped->nodes = reinterpret_cast<const Node*>(base + header.nodes_offset);
+    mapped->children = reinterpret_cast<const std::uint32_t*>(base + header.children_offset);
+    mapped->tour = reinterpret_cast<const std::uint32_t*>(base + header.tour_offset);
+    mapped->node_packages = reinterpret_cast<const Str*>(base + header.node_packages_offset);
+    mapped->packages = reinterpret_cast<const Package*>(base + header.packages_offset);
+    mapped->names = reinterpret_cast<const NameEntry*>(base + header.names_offset);
+    mapped->strings = base + header.strings_offset;
+    return mapped;
+}
+
+MappedDepartments::~MappedDepartments()
+{
+    if (data != nullptr)
+    {
+        munmap(data, size);
+    }
+}
+
+FileStamp MappedDepartments::source(int i) const
+{
+    return FileStamp{header->source_mtime_ns[i], header->source_size[i], header->source_inode[i]};
+}
+
+// Checks that all sections, strings and node indexes are within the file,
+// so that lookups don't need to.
+bool MappedDepartments::validate() const
+{
+    auto const& h = *header;
+    if (memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.byte_order != BYTE_ORDER_MARK || h.version != FORMAT_VERSION)
+    {
+        return false;
+    }
+
+    auto section_fits = [this](std::uint32_t offset, std::uint64_t count, std::size_t item_size) {
+        return offset % 4 == 0 && offset <= size && count * item_size <= size - offset;
+    };
+    if (!section_fits(h.nodes_offset, h.node_count, sizeof(Node))
+        || !section_fits(h.children_offset, h.child_count, sizeof(std::uint32_t))
+        || !section_fits(h.tour_offset, h.node_count, sizeof(std::uint32_t))
+        || !section_fits(h.node_packages_offset, h.node_package_count, sizeof(Str))
+        || !section_fits(h.packages_offset, h.package_count, sizeof(Package))
+        || !section_fits(h.names_offset, h.name_count, sizeof(NameEntry))
+        || h.strings_offset > size || h.strings_size > size - h.strings_offset)
+    {
+        return false;
+    }
+
+    const char* base = static_cast<const char*>(data);
+    auto str_fits = [&h](const Str& s) {
+        return s.offset <= h.strings_size && s.size <= h.strings_size - s.offset;
+    };
+    auto const node_list = reinterpret_cast<const Node*>(base + h.nodes_offset);
+    for (std::uint32_t i = 0; i < h.node_count; i++)
+    {
+        auto const& node = node_list[i];
+        if (!str_fits(node.id)
+            || (node.parent >= 0 && static_cast<std::uint32_t>(node.parent) >= h.node_count)
+            || (node.present && node.parent < 0)
+            || node.children_begin > h.child_count || node.children_count > h.child_count - node.children_begin
+            || node.packages_begin > h.node_package_count || node.packages_count > h.node_package_count - node.packages_begin
+            || node.enter > node.exit || node.exit > h.node_count)
+        {
+            return false;
+        }
+    }
+    auto const child_list = reinterpret_cast<const std::uint32_t*>(base + h.children_offset);
+    for (std::uint32_t i = 0; i < h.child_count; i++)
+    {
+        if (child_list[i] >= h.node_count)
+        {
+            return false;
+        }
+    }
+    auto const tour_list = reinterpret_cast<const std::uint32_t*>(base + h.tour_offset);
+    for (std::uint32_t i = 0; i < h.node_count; i++)
+    {
+        if (tour_list[i] >= h.node_count)
+        {
+            return false;
+        }
+    }
+    auto const node_package_list = reinterpret_cast<const Str*>(base + h.node_packages_offset);
+    for (std::uint32_t i = 0; i < h.node_package_count; i++)
+    {
+        if (!str_fits(node_package_list[i]))
+        {
+            return false;
+        }
+    }
+    auto const package_list = reinterpret_cast<const Package*>(base + h.packages_offset);
+    for (std::uint32_t i = 0; i < h.package_count; i++)
+    {
+        if (!str_fits(package_list[i].id) || package_list[i].node >= h.node_count)
+        {
+            return false;
+        }
+    }
+    auto const name_list = reinterpret_cast<const NameEntry*>(base + h.names_offset);
+    for (std::uint32_t i = 0; i < h.name_count; i++)
+    {
+        if (!str_fits(name_list[i].locale) || !str_fits(name_list[i].department_id) || !str_fits(name_list[i].name))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string MappedDepartments::str(const Str& s) const
+{
+    return std::string(strings + s.offset, s.size);
+}
+
+int MappedDepartments::compare(const Str& s, const std::string& other) const
+{
+    const int res = memcmp(strings + s.offset, other.data(), std::min<std::size_t>(s.size, other.size()));
+    if (res != 0)
+    {
+        return res;
+    }
+    return s.size < other.size() ? -1 : (s.size > other.size() ? 1 : 0);
+}
+
+const MappedDepartments::Node* MappedDepartments::find(const std::string& department_id) const
+{
+    auto const end = nodes + header->node_count;
+    auto it = std::lower_bound(nodes, end, department_id, [this](const Node& node, const std::string& id) {
+        return compare(node.id, id) < 0;
+    });
+    return it != end && compare(it->id, department_id) == 0 ? it : nullptr;
+}
+
+const MappedDepartments::Package* MappedDepartments::find_package(const std::string& package_id) const
+{
+    auto const end = packages + header->package_count;
+    auto it = std::lower_bound(packages, end, package_id, [this](const Package& package, const std::string& id) {
+        return compare(package.id, id) < 0;
+    });
+    return it != end && compare(it->id, package_id) == 0 ? it : nullptr;
+}
+
+std::string MappedDepartments::parent_of(const std::string& department_id) const
+{
+    auto node = find(department_id);
+    if (node == nullptr || !node->present)
+    {
+        throw std::logic_error("Unknown department '" + department_id + "'");
+    }
+    return str(nodes[node->parent].id);
+}
+
+std::vector<std::pair<std::string, bool>> MappedDepartments::children_of(const std::string& department_id) const
+{
+    std::vector<std::pair<std::string, bool>> result;
+    auto node = find(department_id);
+    if (node != nullptr)
+    {
+        for (std::uint32_t i = 0; i < node->children_count; i++)
+        {
+            auto const& child = nodes[children[node->children_begin + i]];
+            result.push_back(std::make_pair(str(child.id), child.children_count > 0));
+        }
+    }
+    return result;
+}
+
+bool MappedDepartments::is_descendant_of(const std::string& department_id, const std::string& parent_department_id) const
+{
+    auto node = find(department_id);
+    auto parent = find(parent_department_id);
+    if (node == nullptr || parent == nullptr)
+    {
+        return false;
+    }
+    return parent->enter < node->enter && node->enter < parent->exit;
+}
+
+std::unordered_map<std::string, std::string> MappedDepartments::top_departments_under(const std::string& department_id) const
+{
+    std::unordered_map<std::string, std::string> tops;
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return tops;
+    }
+    for (std::uint32_t i = 0; i < node->children_count; i++)
+    {
+        auto const& top = nodes[children[node->children_begin + i]];
+        const std::string top_id = str(top.id);
+        for (auto pos = top.enter; pos < top.exit; pos++)
+        {
+            tops[str(nodes[tour[pos]].id)] = top_id;
+        }
+    }
+    return tops;
+}
+
+template <typename F>
+void MappedDepartments::for_each_recursive_package(const Node& node, F f) const
+{
+    // like the recursive queries, a department without a row in depts
+    // only contributes the packages of its subdepartments
+    for (auto pos = node.present ? node.enter : node.enter + 1; pos < node.exit; pos++)
+    {
+        auto const& descendant = nodes[tour[pos]];
+        for (std::uint32_t i = 0; i < descendant.packages_count; i++)
+        {
+            f(node_packages[descendant.packages_begin + i]);
+        }
+    }
+}
+
+std::unordered_set<std::string> MappedDepartments::packages_of(const std::string& department_id, bool recursive) const
+{
+    std::unordered_set<std::string> pkgs;
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return pkgs;
+    }
+    if (!recursive)
+    {
+        for (std::uint32_t i = 0; i < node->packages_count; i++)
+        {
+            pkgs.insert(str(node_packages[node->packages_begin + i]));
+        }
+        return pkgs;
+    }
+    for_each_recursive_package(*node, [this, &pkgs](const Str& pkg) {
+        pkgs.insert(str(pkg));
+    });
+    return pkgs;
+}
+
+bool MappedDepartments::is_empty(const std::string& department_id) const
+{
+    auto node = find(department_id);
+    if (node == nullptr)
+    {
+        return true;
+    }
+    bool empty = true;
+    for_each_recursive_package(*node, [&empty](const Str&) {
+        empty = false;
+    });
+    return empty;
+}
+
+bool MappedDepartments::has_package(const std::string& package_id) const
+{
+    return find_package(package_id) != nullptr;
+}
+
+bool MappedDepartments::department_of(const std::string& package_id, std::string& department_id) const
+{
+    auto package = find_package(package_id);
+    if (package == nullptr)
+    {
+        return false;
+    }
+    department_id = str(nodes[package->node].id);
+    return true;
+}
+
+bool MappedDepartments::name_of(const std::string& department_id, const std::string& locale, std::string& name) const
+{
+    auto const end = names + header->name_count;
+    auto it = std::lower_bound(names, end, std::make_pair(&locale, &department_id),
+                               [this](const NameEntry& entry, const std::pair<const std::string*, const std::string*>& key) {
+        const int res = compare(entry.locale, *key.first);
+        return res != 0 ? res < 0 : compare(entry.department_id, *key.second) < 0;
+    });
+    if (it == end || compare(it->locale, locale) != 0 || compare(it->department_id, department_id) != 0)
+    {
+        return false;
+    }
+    name = str(it->name);
+    return true;
+}
+
+} // namespace click
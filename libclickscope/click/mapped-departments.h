@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_MAPPED_DEPARTMENTS_H
+#define CLICK_MAPPED_DEPARTMENTS_H
+
+#include <click/file-stamp.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace click
+{
+
+// Read-only departments data in a binary file that is used through mmap.
+//
+// The file holds the same data as DepartmentsSnapshot, plus the names of
+// the departments in all locales, as fixed-size records that refer to a
+// shared string pool. Departments, packages and names are sorted by their
+// keys so that they can be looked up with a binary search, and the
+// hierarchy is laid out as an Euler tour like in DepartmentsSnapshot.
+// Opening a file only maps it and checks that all offsets are in bounds,
+// nothing is copied or parsed.
+//
+// Files are written next to the departments database by the scope, once
+// it warmed up a database without an up-to-date file, and by
+// init-departments; they are only valid for the machine they were written
+// on. Each file records the stamps of the database files it was exported
+// from, which tell readers whether the database changed since.
+class MappedDepartments
+{
+public:
+    // (first, second) pairs of (deptid, parentid) or (pkgid, deptid) rows
+    typedef std::vector<std::pair<std::string, std::string>> Rows;
+
+    struct Name
+    {
+        std::string department_id;
+        std::string locale;
+        std::string name;
+    };
+
+    // pkgmap rows are expected to be ordered by pkgid and deptid, and
+    // sources are the stamps of the database file and its -wal file, taken
+    // before the rows were read. Throws std::runtime_error if the
+    // departments don't form a forest (see DepartmentsSnapshot::build) or
+    // the file can't be written; the file is replaced atomically, so
+    // several processes may write it at once.
+    static void write(const std::string& path, const FileStamp sources[2],
+                      const Rows& depts, const Rows& pkgmap, const std::vector<Name>& names);
+
+    // Returns nullptr if the file doesn't exist or is invalid.
+    static std::shared_ptr<const MappedDepartments> open(const std::string& path);
+
+    MappedDepartments(const MappedDepartments&) = delete;
+    MappedDepartments& operator=(const MappedDepartments&) = delete;
+    ~MappedDepartments();
+
+    // Stamps of the database file and its -wal file passed to write().
+    FileStamp source(int i) const;
+
+    // The same queries as DepartmentsSnapshot.
+    std::string parent_of(const std::string& department_id) const;
+    std::vector<std::pair<std::string, bool>> children_of(const std::string& department_id) const;
+    bool is_descendant_of(const std::string& department_id, const std::string& parent_department_id) const;
+    std::unordered_map<std::string, std::string> top_departments_under(const std::string& department_id) const;
+    std::unordered_set<std::string> packages_of(const std::string& department_id, bool recursive) const;
+    bool is_empty(const std::string& department_id) const;
+    bool has_package(const std::string& package_id) const;
+    bool department_of(const std::string& package_id, std::string& department_id) const;
+
+    bool name_of(const std::string& department_id, const std::string& locale, std::string& name) const;
+
+private:
+    struct Header;
+    struct Str;
+    struct Node;
+    struct Package;
+    struct NameEntry;
+
+    MappedDepartments() = default;
+    bool validate() const;
+
+    std::string str(const Str& s) const;
+    int compare(const Str& s, const std::string& other) const;
+    const Node* find(const std::string& department_id) const;
+    const Package* find_package(const std::string& package_id) const;
+
+    template <typename F>
+    void for_each_recursive_package(const Node& node, F f) const;
+
+    void* data = nullptr;
+    std::size_t size = 0;
+
+    const Header* header = nullptr;
+    const Node* nodes = nullptr;
+    const std::uint32_t* children = nullptr;
+    const std::uint32_t* tour = nullptr;
+    const Str* node_packages = nullptr;
+    const Package* packages = nullptr;
+    const NameEntry* names = nullptr;
+    const char* strings = nullptr;
+};
+
+} // namespace click
+
+#endif // CLICK_MAPPED_DEPARTMENTS_H
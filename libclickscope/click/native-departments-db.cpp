@@ -0,0 +1,866 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "native-departments-db.h"
+#include "departments-snapshot.h"
+#include "departments-sql.h"
+
+#include <sqlite3.h>
+
+#include <QDebug>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace click
+{
+
+namespace
+{
+
+enum StatementId
+{
+    DeletePkgmap,
+    DeleteDepts,
+    DeleteDeptnames,
+    InsertPkgmap,
+    InsertDeptId,
+    InsertDeptName,
+    SelectPkgsByDept,
+    SelectDeptForPkg,
+    SelectPkgByPkgid,
+    SelectChildrenDepts,
+    SelectParentDept,
+    SelectDeptNames,
+    SelectDepts,
+    SelectPkgmap,
+    SelectPkgsByDeptRecursive,
+    SelectPkgsCountInDeptRecursive,
+    SelectIsDescendantOfDept,
+    SelectTopDeptsUnder,
+    DeleteClosure,
+    InsertClosureSelf,
+    InsertClosure,
+    StatementCount
+};
+
+void report_error(sqlite3* db, const std::string& message)
+{
+    throw std::runtime_error(message + ": " + sqlite3_errmsg(db));
+}
+
+sqlite3_stmt* prepare(sqlite3* db, const char* sql, bool persistent)
+{
+    sqlite3_stmt* stmt = nullptr;
+#if SQLITE_VERSION_NUMBER >= 3020000
+    const int rc = sqlite3_prepare_v3(db, sql, -1, persistent ? SQLITE_PREPARE_PERSISTENT : 0, &stmt, nullptr);
+#else
+    (void)persistent;
+    const int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+#endif
+    if (rc != SQLITE_OK)
+    {
+        report_error(db, std::string("Failed to prepare '") + sql + "'");
+    }
+    return stmt;
+}
+
+void exec(sqlite3* db, const char* sql, const std::string& message)
+{
+    if (sqlite3_exec(db, sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        report_error(db, message);
+    }
+}
+
+// One use of a prepared statement; resets it when done so that it can be
+// used again.
+class Statement
+{
+public:
+    explicit Statement(sqlite3_stmt* stmt)
+        : stmt(stmt)
+    {
+    }
+    Statement(Statement&& other)
+        : stmt(other.stmt)
+    {
+        other.stmt = nullptr;
+    }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+    ~Statement()
+    {
+        if (stmt != nullptr)
+        {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+    }
+
+    // the value is bound without a copy, so it has to outlive this object
+    Statement& bind(const char* parameter, const std::string& value)
+    {
+        sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, parameter),
+                          value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+        return *this;
+    }
+    Statement& bind(int index, const std::string& value)
+    {
+        sqlite3_bind_text(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+        return *this;
+    }
+
+    // true if a row is available, false when done
+    bool step()
+    {
+        const int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW)
+        {
+            return true;
+        }
+        if (rc != SQLITE_DONE)
+        {
+            report_error(sqlite3_db_handle(stmt), std::string("Failed to execute '") + sqlite3_sql(stmt) + "'");
+        }
+        return false;
+    }
+    void run()
+    {
+        while (step())
+        {
+        }
+    }
+
+    std::string text(int column) const
+    {
+        auto const data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return data == nullptr ? std::string() : std::string(data, sqlite3_column_bytes(stmt, column));
+    }
+    int integer(int column) const
+    {
+        return sqlite3_column_int(stmt, column);
+    }
+
+private:
+    sqlite3_stmt* stmt;
+};
+
+// Statement that is only used once.
+struct TransientStatement
+{
+    explicit TransientStatement(sqlite3_stmt* stmt)
+        : stmt(stmt)
+    {
+    }
+    TransientStatement(const TransientStatement&) = delete;
+    TransientStatement& operator=(const TransientStatement&) = delete;
+    ~TransientStatement()
+    {
+        sqlite3_finalize(stmt);
+    }
+
+    sqlite3_stmt* stmt;
+};
+
+}
+
+struct NativeDepartmentsDb::NativeConnection
+{
+    NativeConnection() = default;
+    NativeConnection(const NativeConnection&) = delete;
+    NativeConnection& operator=(const NativeConnection&) = delete;
+    ~NativeConnection()
+    {
+        for (auto stmt: statements)
+        {
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+    }
+
+    Statement use(StatementId id)
+    {
+        return Statement(statements[id]);
+    }
+
+    sqlite3* db = nullptr;
+    sqlite3_stmt* statements[StatementCount] = {};
+    bool storing_departments = false;
+    bool in_bulk = false;
+    // value of PRAGMA synchronous to restore after a relaxed bulk load, or -1
+    int bulk_synchronous = -1;
+};
+
+NativeDepartmentsDb::NativeDepartmentsDb(const std::string& name, bool create)
+    : DepartmentsDb(name, create),
+      path_(name)
+{
+}
+
+NativeDepartmentsDb::~NativeDepartmentsDb()
+{
+    // the warm-up loads the snapshot through load_hierarchy()
+    join_warm_up();
+    native_connections_.release();
+}
+
+NativeDepartmentsDb::NativeConnection& NativeDepartmentsDb::native_connection() const
+{
+    if (auto conn = native_connections_.find())
+    {
+        return *conn;
+    }
+
+    std::shared_ptr<NativeConnection> opened(new NativeConnection());
+    // every thread has a connection of its own, so sqlite doesn't need to lock it
+    if (sqlite3_open_v2(path_.c_str(), &opened->db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK)
+    {
+        throw std::runtime_error("Cannot open departments database");
+    }
+    // wait for writers on other connections instead of failing right away
+    sqlite3_busy_timeout(opened->db, 5000);
+    for (auto const& pragma: profile().pragmas())
+    {
+        if (sqlite3_exec(opened->db, pragma.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            qWarning() << "Failed to set" << QString::fromStdString(pragma) << ":" << sqlite3_errmsg(opened->db);
+        }
+    }
+
+    namespace sql = departments_sql;
+    const char* const sources[StatementCount] = {
+        sql::DELETE_PKGMAP,
+        sql::DELETE_DEPTS,
+        sql::DELETE_DEPTNAMES,
+        sql::INSERT_PKGMAP,
+        sql::INSERT_DEPT_ID,
+        sql::INSERT_DEPT_NAME,
+        sql::SELECT_PKGS_BY_DEPT,
+        sql::SELECT_DEPT_FOR_PKG,
+        sql::SELECT_PKG_BY_PKGID,
+        sql::SELECT_CHILDREN_DEPTS,
+        sql::SELECT_PARENT_DEPT,
+        sql::SELECT_DEPT_NAMES,
+        sql::SELECT_DEPTS,
+        sql::SELECT_PKGMAP,
+        has_closure_ ? sql::SELECT_PKGS_BY_DEPT_RECURSIVE : sql::SELECT_PKGS_BY_DEPT_RECURSIVE_CTE,
+        has_closure_ ? sql::SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE : sql::SELECT_PKGS_COUNT_IN_DEPT_RECURSIVE_CTE,
+        has_closure_ ? sql::SELECT_IS_DESCENDANT_OF_DEPT : sql::SELECT_IS_DESCENDANT_OF_DEPT_CTE,
+        has_closure_ ? sql::SELECT_TOP_DEPTS_UNDER : sql::SELECT_TOP_DEPTS_UNDER_CTE,
+        // there's no closure to maintain in databases without dept_closure
+        has_closure_ ? sql::DELETE_CLOSURE : nullptr,
+        has_closure_ ? sql::INSERT_CLOSURE_SELF : nullptr,
+        has_closure_ ? sql::INSERT_CLOSURE : nullptr
+    };
+    for (int i = 0; i < StatementCount; i++)
+    {
+        if (sources[i] != nullptr)
+        {
+            opened->statements[i] = prepare(opened->db, sources[i], true);
+        }
+    }
+
+    return native_connections_.add(opened);
+}
+
+bool NativeDepartmentsDb::load_hierarchy(Rows& depts, Rows& pkgmap)
+{
+    auto& conn = native_connection();
+    try
+    {
+        auto query = conn.use(SelectDepts);
+        while (query.step())
+        {
+            depts.push_back(std::make_pair(query.text(0), query.text(1)));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "Failed to load departments:" << e.what();
+        return false;
+    }
+    try
+    {
+        auto query = conn.use(SelectPkgmap);
+        while (query.step())
+        {
+            pkgmap.push_back(std::make_pair(query.text(0), query.text(1)));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        qWarning() << "Failed to load package mappings:" << e.what();
+        return false;
+    }
+    return true;
+}
+
+std::unordered_map<std::string, std::string> NativeDepartmentsDb::load_department_names(const std::string& locale)
+{
+    std::unordered_map<std::string, std::string> names;
+    auto query = native_connection().use(SelectDeptNames);
+    query.bind(":locale", locale);
+    while (query.step())
+    {
+        names[query.text(0)] = query.text(1);
+    }
+    return names;
+}
+
+std::string NativeDepartmentsDb::get_parent_department_id(const std::string& department_id)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->parent_of(department_id);
+    }
+
+    auto query = native_connection().use(SelectParentDept);
+    query.bind(":deptid", department_id);
+    if (!query.step())
+    {
+        throw std::logic_error("Unknown department '" + department_id + "'");
+    }
+    return query.text(0);
+}
+
+std::list<DepartmentsDb::DepartmentInfo> NativeDepartmentsDb::get_children_departments(const std::string& department_id)
+{
+    std::list<DepartmentInfo> depts;
+    if (auto snap = snapshot())
+    {
+        for (auto const& child: snap->children_of(department_id))
+        {
+            depts.push_back(DepartmentInfo(child.first, child.second));
+        }
+        return depts;
+    }
+
+    auto query = native_connection().use(SelectChildrenDepts);
+    query.bind(":parentid", department_id);
+    while (query.step())
+    {
+        depts.push_back(DepartmentInfo(query.text(0), query.integer(1) > 0));
+    }
+    return depts;
+}
+
+bool NativeDepartmentsDb::is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->is_descendant_of(department_id, parent_department_id);
+    }
+
+    auto query = native_connection().use(SelectIsDescendantOfDept);
+    query.bind(":deptid", department_id).bind(":parentid", parent_department_id);
+    return query.step() && query.integer(0) > 0;
+}
+
+std::unordered_map<std::string, std::string> NativeDepartmentsDb::get_top_departments_under(const std::string& department_id)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->top_departments_under(department_id);
+    }
+
+    std::unordered_map<std::string, std::string> tops;
+    auto query = native_connection().use(SelectTopDeptsUnder);
+    query.bind(":parentid", department_id);
+    while (query.step())
+    {
+        tops.insert(std::make_pair(query.text(0), query.text(1)));
+    }
+    return tops;
+}
+
+bool NativeDepartmentsDb::is_empty(const std::string& department_id)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->is_empty(department_id);
+    }
+
+    auto query = native_connection().use(SelectPkgsCountInDeptRecursive);
+    query.bind(":deptid", department_id);
+    return !query.step() || query.integer(0) == 0;
+}
+
+std::unordered_set<std::string> NativeDepartmentsDb::get_packages_for_department(const std::string& department_id, bool recursive)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->packages_of(department_id, recursive);
+    }
+
+    std::unordered_set<std::string> pkgs;
+    auto query = native_connection().use(recursive ? SelectPkgsByDeptRecursive : SelectPkgsByDept);
+    query.bind(":deptid", department_id);
+    while (query.step())
+    {
+        pkgs.insert(query.text(0));
+    }
+    return pkgs;
+}
+
+std::string NativeDepartmentsDb::get_department_for_package(const std::string& package_id)
+{
+    if (auto snap = snapshot())
+    {
+        auto dept = snap->department_of(package_id);
+        if (dept == nullptr)
+        {
+            throw std::logic_error("Unknown package '" + package_id + "'");
+        }
+        return *dept;
+    }
+
+    auto query = native_connection().use(SelectDeptForPkg);
+    query.bind(":pkgid", package_id);
+    if (!query.step())
+    {
+        throw std::logic_error("Unknown package '" + package_id + "'");
+    }
+    return query.text(0);
+}
+
+std::unordered_map<std::string, std::string> NativeDepartmentsDb::get_departments_for_packages(const std::vector<std::string>& package_ids)
+{
+    std::unordered_map<std::string, std::string> depts;
+    if (auto snap = snapshot())
+    {
+        for (auto const& pkg: package_ids)
+        {
+            if (auto dept = snap->department_of(pkg))
+            {
+                depts[pkg] = *dept;
+            }
+        }
+        return depts;
+    }
+
+    // stay well below SQLITE_MAX_VARIABLE_NUMBER, which defaults to 999
+    static const std::size_t max_chunk = 500;
+
+    auto& conn = native_connection();
+    for (std::size_t first = 0; first < package_ids.size(); first += max_chunk)
+    {
+        const std::size_t count = std::min(max_chunk, package_ids.size() - first);
+        std::string sql("SELECT pkgid, deptid FROM pkgmap WHERE pkgid IN (");
+        for (std::size_t i = 0; i < count; i++)
+        {
+            sql += i == 0 ? "?" : ",?";
+        }
+        sql += ") ORDER BY pkgid, deptid";
+
+        TransientStatement stmt(prepare(conn.db, sql.c_str(), false));
+        Statement query(stmt.stmt);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            query.bind(static_cast<int>(i) + 1, package_ids[first + i]);
+        }
+        while (query.step())
+        {
+            // like get_department_for_package(), keep the first department of a package
+            depts.insert(std::make_pair(query.text(0), query.text(1)));
+        }
+    }
+    return depts;
+}
+
+bool NativeDepartmentsDb::has_package(const std::string& package_id)
+{
+    if (auto snap = snapshot())
+    {
+        return snap->has_package(package_id);
+    }
+
+    auto query = native_connection().use(SelectPkgByPkgid);
+    query.bind(":pkgid", package_id);
+    return query.step();
+}
+
+void NativeDepartmentsDb::store_package_mapping_(const std::string& package_id, const std::string& department_id)
+{
+    if (package_id.empty())
+    {
+        throw std::logic_error("Invalid empty package_id");
+    }
+
+    if (department_id.empty())
+    {
+        throw std::logic_error("Invalid empty department id");
+    }
+
+    invalidate_snapshot();
+
+    auto& conn = native_connection();
+    // delete package mapping first from any departments
+    conn.use(DeletePkgmap).bind(":pkgid", package_id).run();
+    conn.use(InsertPkgmap).bind(":pkgid", package_id).bind(":deptid", department_id).run();
+}
+
+void NativeDepartmentsDb::store_package_mapping(const std::string& package_id, const std::string& department_id)
+{
+    auto& conn = native_connection();
+    if (conn.in_bulk)
+    {
+        store_package_mapping_(package_id, department_id);
+        return;
+    }
+
+    exec(conn.db, "BEGIN", "Failed to start transaction");
+    try
+    {
+        store_package_mapping_(package_id, department_id);
+    }
+    catch (...)
+    {
+        sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw;
+    }
+    if (sqlite3_exec(conn.db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        const std::string error = sqlite3_errmsg(conn.db);
+        sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw std::runtime_error("Failed to commit transaction in store_package_mapping: " + error);
+    }
+}
+
+std::unordered_map<std::string, std::string> NativeDepartmentsDb::get_package_versions()
+{
+    auto& conn = native_connection();
+    TransientStatement stmt(prepare(conn.db, departments_sql::SELECT_PKGMAP_VERSIONS, false));
+    Statement query(stmt.stmt);
+    std::unordered_map<std::string, std::string> versions;
+    while (query.step())
+    {
+        versions[query.text(0)] = query.text(1);
+    }
+    return versions;
+}
+
+void NativeDepartmentsDb::store_package_version(const std::string& package_id, const std::string& version)
+{
+    auto& conn = native_connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("Package versions can only be stored in a bulk load");
+    }
+
+    TransientStatement stmt(prepare(conn.db, departments_sql::UPDATE_PKGMAP_VERSION, false));
+    Statement(stmt.stmt).bind(":pkgid", package_id).bind(":version", version).run();
+}
+
+void NativeDepartmentsDb::remove_all()
+{
+    auto& conn = native_connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("Departments can only be removed in a bulk load");
+    }
+
+    invalidate_snapshot();
+    invalidate_department_names();
+    for (auto const sql: {departments_sql::DELETE_ALL_PKGMAP, departments_sql::DELETE_DEPTS, departments_sql::DELETE_ALL_DEPTNAMES})
+    {
+        TransientStatement stmt(prepare(conn.db, sql, false));
+        Statement(stmt.stmt).run();
+    }
+    rebuild_native_closure(conn);
+}
+
+std::unordered_map<std::string, std::string> NativeDepartmentsDb::get_meta(const std::string& prefix)
+{
+    auto& conn = native_connection();
+    TransientStatement stmt(prepare(conn.db, departments_sql::SELECT_META, false));
+    Statement query(stmt.stmt);
+    query.bind(":prefix", prefix);
+    std::unordered_map<std::string, std::string> values;
+    while (query.step())
+    {
+        values[query.text(0)] = query.text(1);
+    }
+    return values;
+}
+
+void NativeDepartmentsDb::store_meta(const std::string& name, const std::string& value)
+{
+    auto& conn = native_connection();
+    TransientStatement stmt(prepare(conn.db, departments_sql::INSERT_META, false));
+    Statement(stmt.stmt).bind(":name", name).bind(":value", value).run();
+}
+
+void NativeDepartmentsDb::remove_meta(const std::string& prefix)
+{
+    if (prefix.empty())
+    {
+        throw std::logic_error("Refusing to remove all meta values");
+    }
+
+    auto& conn = native_connection();
+    TransientStatement stmt(prepare(conn.db, departments_sql::DELETE_META, false));
+    Statement(stmt.stmt).bind(":prefix", prefix).run();
+}
+
+bool NativeDepartmentsDb::in_bulk() const
+{
+    return native_connection().in_bulk;
+}
+
+void NativeDepartmentsDb::begin_bulk(bool relax_sync)
+{
+    auto& conn = native_connection();
+    if (conn.in_bulk)
+    {
+        throw std::logic_error("Bulk load already in progress");
+    }
+
+    if (relax_sync)
+    {
+        // synchronous can't be changed within a transaction
+        TransientStatement stmt(prepare(conn.db, "PRAGMA synchronous", false));
+        if (sqlite3_step(stmt.stmt) == SQLITE_ROW)
+        {
+            conn.bulk_synchronous = sqlite3_column_int(stmt.stmt, 0);
+            if (sqlite3_exec(conn.db, "PRAGMA synchronous=OFF", nullptr, nullptr, nullptr) != SQLITE_OK)
+            {
+                conn.bulk_synchronous = -1;
+                qWarning() << "Failed to relax synchronous writes:" << sqlite3_errmsg(conn.db);
+            }
+        }
+    }
+
+    if (sqlite3_exec(conn.db, "BEGIN", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        const std::string error = sqlite3_errmsg(conn.db);
+        restore_native_synchronous(conn);
+        throw std::runtime_error("Failed to start bulk transaction: " + error);
+    }
+    conn.in_bulk = true;
+}
+
+void NativeDepartmentsDb::commit_bulk()
+{
+    auto& conn = native_connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("No bulk load in progress");
+    }
+    conn.in_bulk = false;
+
+    if (sqlite3_exec(conn.db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        const std::string error = sqlite3_errmsg(conn.db);
+        sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        restore_native_synchronous(conn);
+        throw std::runtime_error("Failed to commit bulk transaction: " + error);
+    }
+    restore_native_synchronous(conn);
+}
+
+void NativeDepartmentsDb::rollback_bulk()
+{
+    auto& conn = native_connection();
+    if (!conn.in_bulk)
+    {
+        throw std::logic_error("No bulk load in progress");
+    }
+    conn.in_bulk = false;
+
+    invalidate_snapshot();
+    if (sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        qWarning() << "Failed to rollback transaction";
+    }
+    restore_native_synchronous(conn);
+}
+
+void NativeDepartmentsDb::restore_native_synchronous(NativeConnection& conn)
+{
+    if (conn.bulk_synchronous < 0)
+    {
+        return;
+    }
+    const std::string pragma = "PRAGMA synchronous=" + std::to_string(conn.bulk_synchronous);
+    if (sqlite3_exec(conn.db, pragma.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        qWarning() << "Failed to restore synchronous writes:" << sqlite3_errmsg(conn.db);
+    }
+    conn.bulk_synchronous = -1;
+}
+
+void NativeDepartmentsDb::store_department_mapping(const std::string& department_id, const std::string& parent_department_id)
+{
+    if (department_id.empty())
+    {
+        throw std::logic_error("Invalid empty department id");
+    }
+
+    invalidate_snapshot();
+
+    auto& conn = native_connection();
+    // within store_departments() and bulk loads the mapping becomes part of
+    // their transaction; otherwise readers must not see the closure while
+    // it is rebuilt
+    const bool own_transaction = !conn.in_bulk && !conn.storing_departments;
+    if (own_transaction)
+    {
+        exec(conn.db, "BEGIN", "Failed to start transaction");
+    }
+    try
+    {
+        conn.use(InsertDeptId).bind(":deptid", department_id).bind(":parentid", parent_department_id).run();
+
+        // store_departments() rebuilds the closure once all mappings are stored
+        if (!conn.storing_departments)
+        {
+            rebuild_native_closure(conn);
+        }
+    }
+    catch (...)
+    {
+        if (own_transaction)
+        {
+            sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
+        throw;
+    }
+    if (own_transaction && sqlite3_exec(conn.db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        const std::string error = sqlite3_errmsg(conn.db);
+        sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw std::runtime_error("Failed to commit transaction in store_department_mapping: " + error);
+    }
+}
+
+void NativeDepartmentsDb::rebuild_native_closure(NativeConnection& conn)
+{
+    if (!has_closure_)
+    {
+        return;
+    }
+    conn.use(DeleteClosure).run();
+    conn.use(InsertClosureSelf).run();
+    conn.use(InsertClosure).run();
+}
+
+void NativeDepartmentsDb::store_department_name(const std::string& department_id, const std::string& locale, const std::string& name)
+{
+    if (department_id.empty())
+    {
+        throw std::logic_error("Invalid empty department id");
+    }
+
+    if (name.empty())
+    {
+        throw std::logic_error("Invalid empty department name");
+    }
+
+    native_connection().use(InsertDeptName).bind(":deptid", department_id).bind(":locale", locale).bind(":name", name).run();
+    invalidate_department_names(locale);
+}
+
+int NativeDepartmentsDb::count_rows(const char* sql) const
+{
+    auto& conn = native_connection();
+    TransientStatement stmt(prepare(conn.db, sql, false));
+    Statement query(stmt.stmt);
+    if (!query.step())
+    {
+        report_error(conn.db, std::string("Failed to execute '") + sql + "'");
+    }
+    return query.integer(0);
+}
+
+int NativeDepartmentsDb::department_mapping_count() const
+{
+    return count_rows("SELECT COUNT(*) FROM depts");
+}
+
+int NativeDepartmentsDb::package_count() const
+{
+    return count_rows("SELECT COUNT(*) FROM pkgmap");
+}
+
+int NativeDepartmentsDb::department_name_count() const
+{
+    return count_rows("SELECT COUNT(*) FROM deptnames");
+}
+
+void NativeDepartmentsDb::store_departments(const click::DepartmentList& depts, const std::string& locale)
+{
+    invalidate_snapshot();
+
+    auto& conn = native_connection();
+    // within a bulk load the departments become part of it
+    const bool own_transaction = !conn.in_bulk;
+    if (own_transaction)
+    {
+        exec(conn.db, "BEGIN", "Failed to start transaction");
+    }
+
+    conn.storing_departments = true;
+    try
+    {
+        //
+        // delete existing departments for given locale first
+        conn.use(DeleteDeptnames).bind(":locale", locale).run();
+        conn.use(DeleteDepts).run();
+        invalidate_department_names(locale);
+
+        // store mapping of top level departments to root ""
+        for (auto const& dept: depts)
+        {
+            store_department_mapping(dept->id(), "");
+        }
+
+        store_departments_(depts, locale);
+        conn.storing_departments = false;
+        rebuild_native_closure(conn);
+    }
+    catch (...)
+    {
+        conn.storing_departments = false;
+        if (own_transaction)
+        {
+            sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
+        throw;
+    }
+
+    if (own_transaction && sqlite3_exec(conn.db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        const std::string error = sqlite3_errmsg(conn.db);
+        sqlite3_exec(conn.db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw std::runtime_error("Failed to commit transaction in store_departments: " + error);
+    }
+}
+
+} // namespace click
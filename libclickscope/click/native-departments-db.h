@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_NATIVE_DEPARTMENTS_DB_H
+#define CLICK_NATIVE_DEPARTMENTS_DB_H
+
+#include <click/departments-db.h>
+
+#include <memory>
+#include <string>
+
+namespace click
+{
+
+// DepartmentsDb on the sqlite3 C API.
+//
+// Statements are prepared once per thread as persistent statements, and
+// strings are bound and read without going through QString and QVariant.
+// The schema is still set up by DepartmentsDb, and the hierarchy snapshot
+// and name cache of DepartmentsDb are filled through this class.
+class NativeDepartmentsDb : public DepartmentsDb
+{
+public:
+    NativeDepartmentsDb(const std::string& name, bool create = true);
+    virtual ~NativeDepartmentsDb();
+
+    std::unordered_set<std::string> get_packages_for_department(const std::string& department_id, bool recursive = true) override;
+    std::string get_department_for_package(const std::string& package_id) override;
+    std::unordered_map<std::string, std::string> get_departments_for_packages(const std::vector<std::string>& package_ids) override;
+    bool is_empty(const std::string& department_id) override;
+    bool has_package(const std::string& package_id) override;
+    std::string get_parent_department_id(const std::string& department_id) override;
+    std::list<DepartmentInfo> get_children_departments(const std::string& department_id) override;
+    bool is_descendant_of_department(const std::string& department_id, const std::string& parent_department_id) override;
+    std::unordered_map<std::string, std::string> get_top_departments_under(const std::string& department_id) override;
+
+    void store_package_mapping(const std::string& package_id, const std::string& department_id) override;
+    std::unordered_map<std::string, std::string> get_package_versions() override;
+    void store_package_version(const std::string& package_id, const std::string& version) override;
+    void remove_all() override;
+    std::unordered_map<std::string, std::string> get_meta(const std::string& prefix) override;
+    void store_meta(const std::string& name, const std::string& value) override;
+    void remove_meta(const std::string& prefix) override;
+    void store_department_mapping(const std::string& department_id, const std::string& parent_department_id) override;
+    void store_department_name(const std::string& department_id, const std::string& locale, const std::string& name) override;
+
+    int department_mapping_count() const override;
+    int package_count() const override;
+    int department_name_count() const override;
+
+    void store_departments(const click::DepartmentList& depts, const std::string& locale) override;
+
+    void begin_bulk(bool relax_sync = false) override;
+    void commit_bulk() override;
+    void rollback_bulk() override;
+
+protected:
+    bool load_hierarchy(Rows& depts, Rows& pkgmap) override;
+    std::unordered_map<std::string, std::string> load_department_names(const std::string& locale) override;
+    bool in_bulk() const override;
+    void store_package_mapping_(const std::string& package_id, const std::string& department_id) override;
+
+private:
+    struct NativeConnection;
+
+    NativeConnection& native_connection() const;
+    void rebuild_native_closure(NativeConnection& conn);
+    void restore_native_synchronous(NativeConnection& conn);
+    int count_rows(const char* sql) const;
+
+    std::string path_;
+    ThreadConnections<NativeConnection> native_connections_;
+};
+
+} // namespace click
+
+#endif // CLICK_NATIVE_DEPARTMENTS_DB_H
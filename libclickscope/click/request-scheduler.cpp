@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "request-scheduler.h"
+
+#include <QDebug>
+#include <QString>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+// a positive number from the environment, or 0
+unsigned long number_from_env(const char* name)
+{
+    const char* value = getenv(name);
+    if (value == nullptr)
+    {
+        return 0;
+    }
+    char* end = nullptr;
+    const unsigned long number = strtoul(value, &end, 10);
+    return *end == '\0' ? number : 0;
+}
+}
+
+namespace click
+{
+
+RequestScheduler::Options RequestScheduler::Options::from_env()
+{
+    Options options;
+    if (auto max_in_flight = number_from_env("INIT_DEPARTMENTS_MAX_REQUESTS"))
+    {
+        options.max_in_flight = static_cast<unsigned>(max_in_flight);
+    }
+    if (auto timeout = number_from_env("INIT_DEPARTMENTS_TIMEOUT"))
+    {
+        options.timeout = std::chrono::seconds(timeout);
+    }
+    if (auto max_attempts = number_from_env("INIT_DEPARTMENTS_ATTEMPTS"))
+    {
+        options.max_attempts = static_cast<unsigned>(max_attempts);
+    }
+    return options;
+}
+
+RequestScheduler::RequestScheduler(const Options& options, const std::function<void()>& finished)
+    : options(options),
+      finished(finished)
+{
+}
+
+void RequestScheduler::add(const std::string& name, const Request& request)
+{
+    Entry entry;
+    entry.name = name;
+    entry.request = request;
+    entries.push_back(entry);
+    queue.push_back(entries.size() - 1);
+}
+
+void RequestScheduler::start()
+{
+    if (entries.empty())
+    {
+        finished();
+        return;
+    }
+    start_next();
+}
+
+void RequestScheduler::set_progress_callback(const ProgressCallback& progress)
+{
+    this->progress = progress;
+}
+
+std::size_t RequestScheduler::failed_count() const
+{
+    return failed;
+}
+
+std::chrono::milliseconds RequestScheduler::latency_percentile(unsigned p) const
+{
+    if (latencies.empty())
+    {
+        return std::chrono::milliseconds(0);
+    }
+    std::vector<std::chrono::milliseconds> sorted(latencies);
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t rank = (p * sorted.size() + 99) / 100;
+    return sorted[std::min(std::max<std::size_t>(rank, 1), sorted.size()) - 1];
+}
+
+void RequestScheduler::start_next()
+{
+    while (in_flight < options.max_in_flight && !queue.empty())
+    {
+        const std::size_t index = queue.front();
+        queue.pop_front();
+        run(index);
+    }
+}
+
+void RequestScheduler::run(std::size_t index)
+{
+    auto& entry = entries[index];
+    entry.attempts++;
+    entry.attempt_id = ++next_attempt_id;
+    entry.in_flight = true;
+    entry.started = std::chrono::steady_clock::now();
+    in_flight++;
+
+    const unsigned attempt_id = entry.attempt_id;
+    QTimer::singleShot(static_cast<int>(options.timeout.count()), &timers, [this, index, attempt_id]() {
+        attempt_done(index, attempt_id, false, true);
+    });
+    auto cancel = entry.request([this, index, attempt_id](bool succeeded) {
+        attempt_done(index, attempt_id, succeeded, false);
+    });
+    // the request may have finished already, and its entry moved on
+    if (entries[index].in_flight && entries[index].attempt_id == attempt_id)
+    {
+        entries[index].cancel = cancel;
+    }
+}
+
+void RequestScheduler::attempt_done(std::size_t index, unsigned attempt_id, bool succeeded, bool timed_out)
+{
+    auto& entry = entries[index];
+    if (!entry.in_flight || entry.attempt_id != attempt_id)
+    {
+        // a timeout of an attempt that finished, or a reply to one that timed out
+        return;
+    }
+    entry.in_flight = false;
+    in_flight--;
+
+    if (timed_out)
+    {
+        qWarning() << "Request for" << QString::fromStdString(entry.name) << "timed out";
+        if (entry.cancel)
+        {
+            entry.cancel();
+        }
+    }
+    else if (succeeded)
+    {
+        latencies.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - entry.started));
+    }
+    entry.cancel = Cancel();
+
+    if (succeeded)
+    {
+        request_done();
+    }
+    else if (entry.attempts < options.max_attempts)
+    {
+        const auto delay = options.backoff * (1 << std::min(entry.attempts - 1, 10u));
+        qWarning() << "Retrying request for" << QString::fromStdString(entry.name) << "in" << delay.count() << "ms";
+        QTimer::singleShot(static_cast<int>(delay.count()), &timers, [this, index]() {
+            queue.push_back(index);
+            start_next();
+        });
+    }
+    else
+    {
+        qWarning() << "Request for" << QString::fromStdString(entry.name) << "failed" << entry.attempts << "times, giving up";
+        failed++;
+        request_done();
+    }
+
+    start_next();
+}
+
+void RequestScheduler::request_done()
+{
+    done_count++;
+    const std::size_t total = entries.size();
+    // report progress in steps of 10%
+    if (progress && done_count * 10 / total != (done_count - 1) * 10 / total)
+    {
+        progress(Progress{done_count, total, failed, in_flight});
+    }
+    if (done_count == total)
+    {
+        finished();
+    }
+}
+
+} // namespace click
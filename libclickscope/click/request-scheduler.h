@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_REQUEST_SCHEDULER_H
+#define CLICK_REQUEST_SCHEDULER_H
+
+#include <QObject>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// Runs web requests with at most a given number of them in flight, giving
+// each attempt a timeout and retrying failed ones after an exponentially
+// growing delay. All methods, and the callbacks, run on the Qt thread.
+class RequestScheduler
+{
+public:
+    struct Options
+    {
+        // requests in flight at once
+        unsigned max_in_flight = 8;
+        // an attempt that takes longer is cancelled and counts as failed
+        std::chrono::milliseconds timeout = std::chrono::seconds(30);
+        // including the first one
+        unsigned max_attempts = 3;
+        // delay before the first retry, doubled for every further one
+        std::chrono::milliseconds backoff = std::chrono::milliseconds(500);
+
+        // The defaults above, overridden by INIT_DEPARTMENTS_MAX_REQUESTS,
+        // INIT_DEPARTMENTS_TIMEOUT (in seconds) and INIT_DEPARTMENTS_ATTEMPTS.
+        static Options from_env();
+    };
+
+    // Reports the outcome of an attempt; false retries the request.
+    typedef std::function<void(bool succeeded)> Done;
+    // Cancels an attempt that timed out.
+    typedef std::function<void()> Cancel;
+    // Starts an attempt of a request, which has to call done once it
+    // finished, unless it gets cancelled.
+    typedef std::function<Cancel(const Done& done)> Request;
+
+    struct Progress
+    {
+        std::size_t done;
+        std::size_t total;
+        std::size_t failed;
+        unsigned in_flight;
+    };
+    typedef std::function<void(const Progress& progress)> ProgressCallback;
+
+    // finished is called once all requests succeeded or ran out of attempts.
+    RequestScheduler(const Options& options, const std::function<void()>& finished);
+    RequestScheduler(const RequestScheduler&) = delete;
+    RequestScheduler& operator=(const RequestScheduler&) = delete;
+
+    void add(const std::string& name, const Request& request);
+    // Starts the requests added so far; calls finished right away if there are none.
+    void start();
+
+    // Called whenever another tenth of the requests is done.
+    void set_progress_callback(const ProgressCallback& progress);
+
+    std::size_t failed_count() const;
+    // Nearest-rank percentile of the durations of the attempts that
+    // succeeded, or 0 if none did.
+    std::chrono::milliseconds latency_percentile(unsigned p) const;
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Request request;
+        unsigned attempts = 0;
+        // identifies the current attempt, so that late callbacks of
+        // attempts that timed out are ignored
+        unsigned attempt_id = 0;
+        bool in_flight = false;
+        Cancel cancel;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    void start_next();
+    void run(std::size_t index);
+    void attempt_done(std::size_t index, unsigned attempt_id, bool succeeded, bool timed_out);
+    void request_done();
+
+    Options options;
+    std::function<void()> finished;
+    ProgressCallback progress;
+
+    std::vector<Entry> entries;
+    // requests waiting for a free slot, including retries whose delay passed
+    std::deque<std::size_t> queue;
+    unsigned in_flight = 0;
+    unsigned next_attempt_id = 0;
+    std::size_t done_count = 0;
+    std::size_t failed = 0;
+    // durations of the attempts that succeeded
+    std::vector<std::chrono::milliseconds> latencies;
+    // timeouts and retries still pending are dropped along with it
+    QObject timers;
+};
+
+} // namespace click
+
+#endif // CLICK_REQUEST_SCHEDULER_H
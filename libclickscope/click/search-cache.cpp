@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "search-cache.h"
+
+#include <click/interface.h>
+#include <click/search-keys.h>
+
+#include <QDebug>
+#include <QString>
+
+constexpr std::size_t click::SearchCache::DEFAULT_CAPACITY;
+
+click::SearchCache::SearchCache(std::size_t capacity)
+    : capacity(capacity)
+{
+}
+
+std::shared_ptr<const click::SearchCache::Apps> click::SearchCache::find(
+        std::uint64_t generation,
+        std::uint64_t departments_generation,
+        const std::vector<std::string>& ignored_apps,
+        const std::string& department,
+        const std::string& query)
+{
+    const std::string normalized_query = search_key(query);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!invalidate(generation, departments_generation, ignored_apps)) {
+        return nullptr; // a newer catalog or database was seen already
+    }
+
+    auto superset = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->department != department) {
+            continue;
+        }
+        if (it->query == query) {
+            entries.splice(entries.begin(), entries, it);
+            return it->apps;
+        }
+        // an empty query matches apps that no non-empty query does, so only
+        // non-empty queries can be refined
+        if (!query.empty() && normalized_query.find(it->normalized_query) != std::string::npos &&
+            (superset == entries.end() || it->apps->size() < superset->apps->size())) {
+            superset = it;
+        }
+    }
+    if (superset == entries.end()) {
+        return nullptr;
+    }
+
+    // results stay sorted, as filtering keeps their order
+    std::shared_ptr<Apps> apps(new Apps());
+    for (auto const& app: *superset->apps) {
+        if (Interface::matches_search_key(app, normalized_query)) {
+            apps->push_back(app);
+        }
+    }
+    qDebug() << "Refined search" << QString::fromStdString(superset->query) << "to"
+             << QString::fromStdString(query) << ":" << superset->apps->size() << "->" << apps->size();
+
+    insert(Entry{department, query, normalized_query, apps});
+    return apps;
+}
+
+void click::SearchCache::store(std::uint64_t generation,
+                               std::uint64_t departments_generation,
+                               const std::vector<std::string>& ignored_apps,
+                               const std::string& department,
+                               const std::string& query,
+                               const std::shared_ptr<const Apps>& apps)
+{
+    const std::string normalized_query = search_key(query);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!invalidate(generation, departments_generation, ignored_apps)) {
+        return; // the catalog or database changed while these results were computed
+    }
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->department == department && it->query == query) {
+            entries.erase(it);
+            break;
+        }
+    }
+    insert(Entry{department, query, normalized_query, apps});
+}
+
+void click::SearchCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+bool click::SearchCache::invalidate(std::uint64_t generation,
+                                    std::uint64_t departments_generation,
+                                    const std::vector<std::string>& ignored_apps)
+{
+    if (generation < this->generation || departments_generation < this->departments_generation) {
+        return false;
+    }
+    if (generation != this->generation || departments_generation != this->departments_generation ||
+        ignored_apps != this->ignored_apps) {
+        entries.clear();
+        this->generation = generation;
+        this->departments_generation = departments_generation;
+        this->ignored_apps = ignored_apps;
+    }
+    return true;
+}
+
+void click::SearchCache::insert(Entry entry)
+{
+    entries.push_front(std::move(entry));
+    while (entries.size() > capacity) {
+        entries.pop_back();
+    }
+}
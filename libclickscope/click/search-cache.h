@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_SEARCH_CACHE_H
+#define CLICK_SEARCH_CACHE_H
+
+#include <click/application.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// Results of the most recent installed-app searches.
+//
+// The dash sends a new query for every keystroke. When a query only extends
+// an earlier one, its results are a subset of the earlier results, so they
+// are filtered from those instead of searching all installed apps again.
+// Entries are only valid for the catalog generation, the departments
+// database generation and the ignored apps they were computed with, and are
+// dropped as soon as any of them changes. Results computed from generations
+// older than the ones seen last are neither returned nor stored.
+class SearchCache
+{
+public:
+    typedef std::vector<Application> Apps;
+
+    constexpr static std::size_t DEFAULT_CAPACITY = 16;
+
+    explicit SearchCache(std::size_t capacity = DEFAULT_CAPACITY);
+    SearchCache(const SearchCache&) = delete;
+    SearchCache& operator=(const SearchCache&) = delete;
+
+    // Returns the sorted results of the query, either cached or filtered
+    // from the results of a query it refines, or nullptr.
+    std::shared_ptr<const Apps> find(std::uint64_t generation,
+                                     std::uint64_t departments_generation,
+                                     const std::vector<std::string>& ignored_apps,
+                                     const std::string& department,
+                                     const std::string& query);
+
+    void store(std::uint64_t generation,
+               std::uint64_t departments_generation,
+               const std::vector<std::string>& ignored_apps,
+               const std::string& department,
+               const std::string& query,
+               const std::shared_ptr<const Apps>& apps);
+
+    void clear();
+
+private:
+    struct Entry
+    {
+        std::string department;
+        std::string query;
+        std::string normalized_query;
+        std::shared_ptr<const Apps> apps;
+    };
+
+    // False if either generation is older than the current one; otherwise
+    // makes them current, dropping the entries if anything changed.
+    bool invalidate(std::uint64_t generation,
+                    std::uint64_t departments_generation,
+                    const std::vector<std::string>& ignored_apps);
+    void insert(Entry entry);
+
+    const std::size_t capacity;
+    std::mutex mutex;
+    std::uint64_t generation = 0;
+    std::uint64_t departments_generation = 0;
+    std::vector<std::string> ignored_apps;
+    // most recently used first
+    std::list<Entry> entries;
+};
+
+} // namespace click
+
+#endif // CLICK_SEARCH_CACHE_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "search-index.h"
+
+#include <click/desktop-entry.h>
+
+#include <algorithm>
+
+constexpr std::size_t click::SearchIndex::GRAM_SIZE;
+
+click::SearchIndex::SearchIndex(const std::vector<DesktopEntry>& entries)
+    : entry_count(entries.size())
+{
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const auto position = static_cast<Position>(i);
+        add(entries[i].search_name, position);
+        for (auto const& keyword: entries[i].search_keywords) {
+            add(keyword, position);
+        }
+    }
+}
+
+// Packs up to GRAM_SIZE bytes together with their count, so that grams of
+// different lengths never collide.
+click::SearchIndex::Gram click::SearchIndex::gram(const char* data, std::size_t size)
+{
+    Gram g = static_cast<Gram>(size);
+    for (std::size_t i = 0; i < size; i++) {
+        g = (g << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return g;
+}
+
+void click::SearchIndex::add(const std::string& key, Position position)
+{
+    // entries are added in order, so a posting list is sorted and only
+    // needs to be checked against its last element to stay unique
+    auto post = [position](Postings& postings) {
+        if (postings.empty() || postings.back() != position) {
+            postings.push_back(position);
+        }
+    };
+
+    for (std::size_t i = 0; i < key.size(); i++) {
+        for (std::size_t n = 1; n < GRAM_SIZE && i + n <= key.size(); n++) {
+            post(prefixes[gram(key.data() + i, n)]);
+        }
+        if (i + GRAM_SIZE <= key.size()) {
+            post(trigrams[gram(key.data() + i, GRAM_SIZE)]);
+        }
+    }
+}
+
+std::vector<click::SearchIndex::Position> click::SearchIndex::candidates(const std::string& normalized_query) const
+{
+    std::vector<Position> result;
+
+    if (normalized_query.empty()) {
+        result.resize(entry_count);
+        for (std::size_t i = 0; i < entry_count; i++) {
+            result[i] = static_cast<Position>(i);
+        }
+        return result;
+    }
+
+    if (normalized_query.size() < GRAM_SIZE) {
+        auto it = prefixes.find(gram(normalized_query.data(), normalized_query.size()));
+        if (it != prefixes.end()) {
+            result = it->second;
+        }
+        return result;
+    }
+
+    std::vector<const Postings*> lists;
+    for (std::size_t i = 0; i + GRAM_SIZE <= normalized_query.size(); i++) {
+        auto it = trigrams.find(gram(normalized_query.data() + i, GRAM_SIZE));
+        if (it == trigrams.end()) {
+            return result; // some trigram occurs nowhere, nothing can match
+        }
+        lists.push_back(&it->second);
+    }
+
+    // intersect starting with the rarest gram so the work is bounded by
+    // the size of the shortest posting list
+    std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) {
+        return a->size() < b->size();
+    });
+    result = *lists.front();
+    for (std::size_t i = 1; i < lists.size() && !result.empty(); i++) {
+        const Postings& postings = *lists[i];
+        result.erase(std::remove_if(result.begin(), result.end(), [&postings](Position position) {
+                         return !std::binary_search(postings.begin(), postings.end(), position);
+                     }), result.end());
+    }
+    return result;
+}
+
+std::size_t click::SearchIndex::size() const
+{
+    return entry_count;
+}
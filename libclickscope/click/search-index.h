@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_SEARCH_INDEX_H
+#define CLICK_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace click
+{
+
+struct DesktopEntry;
+
+// Inverted index over the search keys (see search-keys.h) of a list of
+// desktop entries, used to avoid scanning every installed application for
+// each search query.
+//
+// Every search key is split into byte trigrams; a query of three bytes or
+// more can only match entries that contain all of its trigrams, so the
+// candidates are the intersection of their posting lists. Shorter queries
+// are looked up in a table of all one and two byte substrings instead.
+// Candidates still have to be checked with search_key_contains(), the index
+// only guarantees that no match is left out.
+class SearchIndex
+{
+public:
+    typedef std::uint32_t Position;
+
+    SearchIndex() = default;
+    explicit SearchIndex(const std::vector<DesktopEntry>& entries);
+
+    // Positions in the indexed vector of the entries that may match the
+    // normalized query, in ascending order.
+    std::vector<Position> candidates(const std::string& normalized_query) const;
+
+    std::size_t size() const;
+
+private:
+    static constexpr std::size_t GRAM_SIZE = 3;
+
+    typedef std::uint32_t Gram;
+    typedef std::vector<Position> Postings;
+
+    static Gram gram(const char* data, std::size_t size);
+    void add(const std::string& key, Position position);
+
+    std::size_t entry_count = 0;
+    // grams of GRAM_SIZE bytes
+    std::unordered_map<Gram, Postings> trigrams;
+    // substrings shorter than GRAM_SIZE, for short queries
+    std::unordered_map<Gram, Postings> prefixes;
+};
+
+} // namespace click
+
+#endif // CLICK_SEARCH_INDEX_H
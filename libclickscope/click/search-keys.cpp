@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include "search-keys.h"
+
+#include <QString>
+
+namespace
+{
+
+/* Thanks to
+ *   - http://stackoverflow.com/a/14031349
+ *   - http://stackoverflow.com/questions/12278448/removing-accents-from-a-qstring
+ */
+QString unaccent(const QString &str)
+{
+    QString tmp = str.normalized(QString::NormalizationForm_KD,
+                                 QChar::currentUnicodeVersion());
+    QString ret;
+    for (int i = 0, j = tmp.length();
+         i < j;
+         i++) {
+
+        // strip diacritic marks
+        if (tmp.at(i).category() != QChar::Mark_NonSpacing       &&
+            tmp.at(i).category() != QChar::Mark_SpacingCombining &&
+            tmp.at(i).category() != QChar::Mark_Enclosing) {
+            ret.append(tmp.at(i));
+        }
+    }
+
+    return ret;
+}
+
+}
+
+namespace click
+{
+
+std::string search_key(const std::string& text)
+{
+    // case folding is what QString::contains(..., Qt::CaseInsensitive)
+    // applies to both sides; UTF-8 keeps substring matches byte-exact
+    return unaccent(QString::fromStdString(text)).toCaseFolded().toStdString();
+}
+
+std::vector<std::string> search_keys(const std::vector<std::string>& texts)
+{
+    std::vector<std::string> keys;
+    keys.reserve(texts.size());
+    for (auto const& text: texts) {
+        keys.push_back(search_key(text));
+    }
+    return keys;
+}
+
+} // namespace click
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_SEARCH_KEYS_H
+#define CLICK_SEARCH_KEYS_H
+
+#include <string>
+#include <vector>
+
+namespace click
+{
+
+// Normalized form of a string used for matching search queries: diacritic
+// marks are stripped and the text is case folded, so that a query matches
+// when its search key is a substring of the search key of the text.
+std::string search_key(const std::string& text);
+std::vector<std::string> search_keys(const std::vector<std::string>& texts);
+
+// True if normalized_query (a search_key()) occurs in the search key.
+inline bool search_key_contains(const std::string& key, const std::string& normalized_query)
+{
+    return !key.empty() && key.find(normalized_query) != std::string::npos;
+}
+
+} // namespace click
+
+#endif // CLICK_SEARCH_KEYS_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_THREAD_CONNECTIONS_H
+#define CLICK_THREAD_CONNECTIONS_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace click
+{
+
+// Database connections that may only be used, and closed, by the thread
+// that opened them, such as QSqlDatabase connections or sqlite handles
+// opened without a mutex of their own.
+//
+// Every thread keeps its connections in thread local storage, so they are
+// closed by that thread when it exits. Connections whose owner was destroyed
+// before are closed the next time the thread looks up a connection of any
+// owner; the owner itself can only close the connection of its own thread.
+template <typename Connection>
+class ThreadConnections
+{
+public:
+    ThreadConnections()
+        : owner_(std::make_shared<char>())
+    {
+    }
+    ThreadConnections(const ThreadConnections&) = delete;
+    ThreadConnections& operator=(const ThreadConnections&) = delete;
+
+    // Connection of the calling thread, or nullptr.
+    Connection* find() const
+    {
+        auto& entries = thread_entries();
+        prune(entries);
+        for (auto const& entry: entries)
+        {
+            if (entry.key == owner_.get())
+            {
+                return entry.connection.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Makes conn the connection of the calling thread; its deleter runs on
+    // that thread.
+    Connection& add(const std::shared_ptr<Connection>& conn) const
+    {
+        thread_entries().push_back(Entry{owner_.get(), owner_, conn});
+        return *conn;
+    }
+
+    // Closes the connection of the calling thread, if it has one.
+    void release() const
+    {
+        auto& entries = thread_entries();
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const Entry& entry) {
+            return entry.key == owner_.get();
+        }), entries.end());
+    }
+
+private:
+    struct Entry
+    {
+        // only compared while owner is alive, so it can't belong to another owner
+        const void* key;
+        std::weak_ptr<char> owner;
+        std::shared_ptr<Connection> connection;
+    };
+
+    static std::vector<Entry>& thread_entries()
+    {
+        thread_local std::vector<Entry> entries;
+        return entries;
+    }
+
+    static void prune(std::vector<Entry>& entries)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) {
+            return entry.owner.expired();
+        }), entries.end());
+    }
+
+    std::shared_ptr<char> owner_;
+};
+
+} // namespace click
+
+#endif // CLICK_THREAD_CONNECTIONS_H
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#ifndef CLICK_WORKER_POOL_H
+#define CLICK_WORKER_POOL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace click
+{
+
+// Number of workers used by parallel_for() when no limit is given.
+unsigned default_worker_count();
+
+// Calls task(i) for every i in [0, count) on a bounded pool of worker
+// threads and returns once all of them are done. The calling thread takes
+// part in the work. If a task throws, the remaining indices are skipped and
+// the first exception is rethrown in the calling thread.
+void parallel_for(std::size_t count,
+                  const std::function<void(std::size_t)>& task,
+                  unsigned max_workers = default_worker_count());
+
+} // namespace click
+
+#endif // CLICK_WORKER_POOL_H
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/click-database.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <unistd.h>
+
+using namespace click;
+
+namespace
+{
+
+const int PACKAGES = 500;
+const int RUNS = 10;
+
+template <typename F>
+double time_ms(F f)
+{
+    auto const started = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+// Lines printed by command, or -1 if it failed.
+int run_lines(const std::string& command)
+{
+    FILE* out = popen(command.c_str(), "r");
+    if (out == nullptr)
+    {
+        return -1;
+    }
+    int lines = 0;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), out) != nullptr)
+    {
+        ++lines;
+    }
+    return pclose(out) == 0 ? lines : -1;
+}
+
+}
+
+// Reads a database of PACKAGES packages registered for a user.
+TEST(ClickDatabaseBenchmark, generatedDatabase)
+{
+    char dir_template[] = "/tmp/click-database-benchmark.XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir_template));
+    const std::string root = dir_template;
+    const std::string users_dir = root + "/.click/users/user";
+    ASSERT_EQ(0, std::system(("mkdir -p " + users_dir).c_str()));
+    for (int i = 0; i < PACKAGES; i++)
+    {
+        const std::string package = "com.example.app" + std::to_string(i);
+        const std::string directory = root + "/" + package + "/1.0";
+        ASSERT_EQ(0, std::system(("mkdir -p " + directory + "/.click/info").c_str()));
+        ASSERT_EQ(0, symlink(directory.c_str(), (users_dir + "/" + package).c_str()));
+    }
+
+    const ClickDatabase db({root}, "user");
+    std::size_t found = 0;
+    const double list_ms = time_ms([&db, &found]() {
+        for (int i = 0; i < RUNS; i++)
+        {
+            found = db.registrations().size();
+        }
+    });
+    const double find_ms = time_ms([&db]() {
+        ClickDatabase::Registration registration;
+        for (int i = 0; i < PACKAGES; i++)
+        {
+            db.find("com.example.app" + std::to_string(i), registration);
+        }
+    });
+    EXPECT_EQ(static_cast<std::size_t>(PACKAGES), found);
+    std::cout << "Listing " << PACKAGES << " packages: " << list_ms / RUNS << " ms; "
+              << PACKAGES << " single lookups: " << find_ms << " ms" << std::endl;
+
+    ASSERT_EQ(0, std::system(("rm -rf " + root).c_str()));
+}
+
+// Compares reading the database of the user with running `click list`,
+// which is what Interface::get_installed_packages() did before; only where
+// click is installed.
+TEST(ClickDatabaseBenchmark, clickListProcess)
+{
+    const ClickDatabase db;
+    if (!db.is_valid() || std::system("command -v click > /dev/null 2>&1") != 0)
+    {
+        std::cout << "click isn't installed, not comparing with it" << std::endl;
+        return;
+    }
+
+    std::size_t registrations = 0;
+    const double direct_ms = time_ms([&db, &registrations]() {
+        for (int i = 0; i < RUNS; i++)
+        {
+            registrations = db.registrations().size();
+        }
+    });
+    int lines = 0;
+    const double process_ms = time_ms([&lines]() {
+        for (int i = 0; i < RUNS; i++)
+        {
+            lines = run_lines("click list");
+        }
+    });
+    ASSERT_GE(lines, 0);
+    EXPECT_EQ(static_cast<std::size_t>(lines), registrations);
+    std::cout << "Listing " << registrations << " installed packages: database " << direct_ms / RUNS
+              << " ms, click list " << process_ms / RUNS << " ms" << std::endl;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-db.h>
+#include <click/native-departments-db.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace click;
+
+namespace
+{
+
+const int TOP_DEPARTMENTS = 20;
+const int SUBDEPARTMENTS = 10;
+const int PACKAGES = 5000;
+const int LOOKUPS = 20000;
+const int OPENS = 20;
+
+std::string department(int top, int sub)
+{
+    return "dept-" + std::to_string(top) + "-" + std::to_string(sub);
+}
+
+std::string package(int i)
+{
+    return "com.example.app" + std::to_string(i);
+}
+
+template <typename F>
+double time_ms(F f)
+{
+    auto const started = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
+
+void report(const std::string& what, int count, double qt_ms, double native_ms)
+{
+    std::cout << what << " (" << count << "x): QtSql " << qt_ms << " ms, sqlite3 " << native_ms
+              << " ms, " << (native_ms > 0 ? qt_ms / native_ms : 0) << "x" << std::endl;
+}
+
+// Times lookups through DepartmentsDb and NativeDepartmentsDb on the same
+// database, with TOP_DEPARTMENTS departments of SUBDEPARTMENTS each and
+// PACKAGES packages spread over them.
+class DepartmentsDbBenchmark : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/departments-db-benchmark.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        path = dir + "/departments.db";
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    // With shared, one subdepartment gets a second parent, so that the
+    // hierarchy isn't a forest and both backends answer with SQL instead
+    // of from the in-memory snapshot.
+    void fill(bool shared)
+    {
+        DepartmentsDb db(path);
+        db.begin_bulk(true);
+        for (int top = 0; top < TOP_DEPARTMENTS; top++)
+        {
+            const std::string parent = "dept-" + std::to_string(top);
+            db.store_department_mapping(parent, "");
+            db.store_department_name(parent, "en_US", "Department " + std::to_string(top));
+            for (int sub = 0; sub < SUBDEPARTMENTS; sub++)
+            {
+                db.store_department_mapping(department(top, sub), parent);
+            }
+        }
+        if (shared)
+        {
+            db.store_department_mapping(department(0, 0), "dept-1");
+        }
+        std::vector<std::pair<std::string, std::string>> mappings;
+        for (int i = 0; i < PACKAGES; i++)
+        {
+            mappings.push_back(std::make_pair(package(i), department(i % TOP_DEPARTMENTS, i / TOP_DEPARTMENTS % SUBDEPARTMENTS)));
+        }
+        db.store_package_mappings(mappings);
+        db.commit_bulk();
+    }
+
+    static void lookups(DepartmentsDb& db)
+    {
+        for (int i = 0; i < LOOKUPS; i++)
+        {
+            const int top = i % TOP_DEPARTMENTS;
+            db.get_department_for_package(package(i % PACKAGES));
+            db.is_descendant_of_department(department(top, i % SUBDEPARTMENTS), "dept-" + std::to_string(top));
+            db.get_parent_department_id(department(top, i % SUBDEPARTMENTS));
+        }
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+}
+
+TEST_F(DepartmentsDbBenchmark, sqlLookups)
+{
+    fill(true);
+    DepartmentsDb qt(path, false);
+    NativeDepartmentsDb native(path, false);
+    EXPECT_EQ(qt.get_packages_for_department("dept-3"), native.get_packages_for_department("dept-3"));
+
+    // the first round prepares the statements of the thread
+    lookups(qt);
+    lookups(native);
+    report("package, descendant and parent lookups", LOOKUPS,
+           time_ms([&qt]() { lookups(qt); }), time_ms([&native]() { lookups(native); }));
+    report("recursive package lookups", LOOKUPS / 100,
+           time_ms([&qt]() {
+               for (int i = 0; i < LOOKUPS / 100; i++)
+               {
+                   qt.get_packages_for_department("dept-" + std::to_string(i % TOP_DEPARTMENTS));
+               }
+           }),
+           time_ms([&native]() {
+               for (int i = 0; i < LOOKUPS / 100; i++)
+               {
+                   native.get_packages_for_department("dept-" + std::to_string(i % TOP_DEPARTMENTS));
+               }
+           }));
+}
+
+TEST_F(DepartmentsDbBenchmark, openAndLoadSnapshot)
+{
+    fill(false);
+    report("open and first hierarchy lookup", OPENS,
+           time_ms([this]() {
+               for (int i = 0; i < OPENS; i++)
+               {
+                   DepartmentsDb db(path, false);
+                   db.get_parent_department_id(department(0, 0));
+               }
+           }),
+           time_ms([this]() {
+               for (int i = 0; i < OPENS; i++)
+               {
+                   NativeDepartmentsDb db(path, false);
+                   db.get_parent_department_id(department(0, 0));
+               }
+           }));
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/click-database.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace click;
+
+namespace
+{
+
+class ClickDatabaseTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/click-database-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        core = dir + "/core";
+        custom = dir + "/custom";
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    static void make_dirs(const std::string& path)
+    {
+        ASSERT_EQ(0, std::system(("mkdir -p " + path).c_str()));
+    }
+
+    // Unpacks package/version into root and links it from the users dir.
+    static std::string install(const std::string& root, const std::string& users,
+                               const std::string& package, const std::string& version)
+    {
+        const std::string directory = root + "/" + package + "/" + version;
+        make_dirs(directory + "/.click/info");
+        register_link(root, users, package, directory);
+        return directory;
+    }
+
+    static void register_link(const std::string& root, const std::string& users,
+                     const std::string& package, const std::string& target)
+    {
+        const std::string users_dir = root + "/.click/users/" + users;
+        make_dirs(users_dir);
+        ASSERT_EQ(0, symlink(target.c_str(), (users_dir + "/" + package).c_str()));
+    }
+
+    ClickDatabase database() const
+    {
+        return ClickDatabase({core, custom}, "user");
+    }
+
+    std::string dir;
+    std::string core;
+    std::string custom;
+};
+
+}
+
+TEST_F(ClickDatabaseTest, isValidNeedsRootsAndUser)
+{
+    EXPECT_TRUE(database().is_valid());
+    EXPECT_FALSE(ClickDatabase({}, "user").is_valid());
+    EXPECT_FALSE(ClickDatabase({core}, "").is_valid());
+}
+
+TEST_F(ClickDatabaseTest, configuredRootsAreSortedByFileName)
+{
+    const std::string config_dir = dir + "/databases";
+    make_dirs(config_dir);
+    std::ofstream(config_dir + "/10_core.conf") << "[Click Database]\nroot=/usr/share/click/preinstalled\n";
+    std::ofstream(config_dir + "/99_default.conf") << "[Click Database]\nroot=/opt/click.ubuntu.com\n";
+    std::ofstream(config_dir + "/20_broken.conf") << "[Other]\nroot=/nowhere\n";
+    std::ofstream(config_dir + "/ignored.txt") << "[Click Database]\nroot=/nowhere\n";
+
+    const std::vector<std::string> expected {"/usr/share/click/preinstalled", "/opt/click.ubuntu.com"};
+    EXPECT_EQ(expected, ClickDatabase::configured_roots(config_dir));
+}
+
+TEST_F(ClickDatabaseTest, findsUserAndAllUsersRegistrations)
+{
+    const auto mine = install(custom, "user", "com.example.mine", "1.0");
+    const auto shared = install(core, "@all", "com.example.shared", "2.0");
+    install(custom, "other", "com.example.theirs", "1.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.mine", registration));
+    EXPECT_EQ("com.example.mine", registration.name);
+    EXPECT_EQ("1.0", registration.version);
+    EXPECT_EQ(mine, registration.directory);
+    EXPECT_TRUE(registration.removable);
+    EXPECT_EQ(mine + "/.click/info/com.example.mine.manifest", registration.manifest_path());
+
+    ASSERT_TRUE(database().find("com.example.shared", registration));
+    EXPECT_EQ("2.0", registration.version);
+    EXPECT_EQ(shared, registration.directory);
+    EXPECT_FALSE(registration.removable);
+
+    EXPECT_FALSE(database().find("com.example.theirs", registration));
+    EXPECT_FALSE(database().find("com.example.missing", registration));
+}
+
+TEST_F(ClickDatabaseTest, rejectsPathsAsPackageNames)
+{
+    install(custom, "user", "com.example.app", "1.0");
+
+    ClickDatabase::Registration registration;
+    EXPECT_FALSE(database().find("", registration));
+    EXPECT_FALSE(database().find(".", registration));
+    EXPECT_FALSE(database().find("..", registration));
+    EXPECT_FALSE(database().find("../user/com.example.app", registration));
+}
+
+TEST_F(ClickDatabaseTest, relativeLinksResolveAgainstUsersDir)
+{
+    make_dirs(custom + "/com.example.app/1.0");
+    register_link(custom, "user", "com.example.app", "../../../com.example.app/1.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.app", registration));
+    EXPECT_EQ(custom + "/com.example.app/1.0", registration.directory);
+    EXPECT_EQ("1.0", registration.version);
+}
+
+TEST_F(ClickDatabaseTest, higherRootTakesPrecedence)
+{
+    install(core, "@all", "com.example.app", "1.0");
+    install(custom, "@all", "com.example.app", "2.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.app", registration));
+    EXPECT_EQ("2.0", registration.version);
+    EXPECT_FALSE(registration.removable);
+}
+
+TEST_F(ClickDatabaseTest, userRegistrationTakesPrecedenceOverAllUsers)
+{
+    install(custom, "@all", "com.example.app", "1.0");
+    install(custom, "user", "com.example.app", "2.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.app", registration));
+    EXPECT_EQ("2.0", registration.version);
+    EXPECT_TRUE(registration.removable);
+}
+
+TEST_F(ClickDatabaseTest, userRegistrationInLowerRootLosesToHigherRoot)
+{
+    install(core, "user", "com.example.app", "1.0");
+    install(custom, "@all", "com.example.app", "2.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.app", registration));
+    EXPECT_EQ("2.0", registration.version);
+    EXPECT_FALSE(registration.removable);
+}
+
+TEST_F(ClickDatabaseTest, hiddenHidesLowerRoots)
+{
+    install(core, "@all", "com.example.app", "1.0");
+    register_link(custom, "user", "com.example.app", "@hidden");
+
+    ClickDatabase::Registration registration;
+    EXPECT_FALSE(database().find("com.example.app", registration));
+    EXPECT_TRUE(database().registrations().empty());
+}
+
+TEST_F(ClickDatabaseTest, hiddenHidesAllUsersOfSameRoot)
+{
+    install(custom, "@all", "com.example.app", "1.0");
+    register_link(custom, "user", "com.example.app", "@hidden");
+
+    ClickDatabase::Registration registration;
+    EXPECT_FALSE(database().find("com.example.app", registration));
+}
+
+TEST_F(ClickDatabaseTest, hiddenInLowerRootDoesNotHideHigherRoot)
+{
+    register_link(core, "user", "com.example.app", "@hidden");
+    install(custom, "@all", "com.example.app", "2.0");
+
+    ClickDatabase::Registration registration;
+    ASSERT_TRUE(database().find("com.example.app", registration));
+    EXPECT_EQ("2.0", registration.version);
+}
+
+TEST_F(ClickDatabaseTest, registrationsAreMergedAndSortedByName)
+{
+    install(custom, "user", "com.example.c", "1.0");
+    install(core, "@all", "com.example.a", "1.0");
+    install(core, "@all", "com.example.b", "1.0");
+    install(custom, "@all", "com.example.b", "3.0");
+    install(core, "@all", "com.example.hidden", "1.0");
+    register_link(custom, "user", "com.example.hidden", "@hidden");
+
+    const auto registrations = database().registrations();
+    ASSERT_EQ(3u, registrations.size());
+    EXPECT_EQ("com.example.a", registrations[0].name);
+    EXPECT_EQ("com.example.b", registrations[1].name);
+    EXPECT_EQ("3.0", registrations[1].version);
+    EXPECT_EQ("com.example.c", registrations[2].name);
+    EXPECT_TRUE(registrations[2].removable);
+}
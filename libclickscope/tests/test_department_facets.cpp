@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/department-facets.h>
+#include <click/departments-db.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+
+using namespace click;
+
+namespace
+{
+
+//  "" -+- games -+- board-games
+//      |         +- cards -- poker
+//      +- accessories
+class DepartmentFacetsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/department-facets-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        db.reset(new DepartmentsDb(dir + "/departments.db"));
+        db->store_department_mapping("games", "");
+        db->store_department_mapping("board-games", "games");
+        db->store_department_mapping("cards", "games");
+        db->store_department_mapping("poker", "cards");
+        db->store_department_mapping("accessories", "");
+    }
+
+    void TearDown() override
+    {
+        db.reset();
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    std::string dir;
+    std::unique_ptr<DepartmentsDb> db;
+};
+
+}
+
+TEST_F(DepartmentFacetsTest, countsAppsPerChild)
+{
+    DepartmentFacets facets(*db, "");
+    facets.add("games");
+    facets.add("poker");
+    facets.add("board-games");
+    facets.add("accessories");
+
+    EXPECT_EQ(3u, facets.count("games"));
+    EXPECT_EQ(1u, facets.count("accessories"));
+    EXPECT_EQ(0u, facets.count("poker"));
+    EXPECT_EQ(2u, facets.counts().size());
+}
+
+TEST_F(DepartmentFacetsTest, ignoresAppsOutsideTheSubtree)
+{
+    DepartmentFacets facets(*db, "games");
+    facets.add("games");
+    facets.add("accessories");
+    facets.add("unknown");
+    facets.add("");
+    facets.add("poker");
+
+    EXPECT_EQ(1u, facets.count("cards"));
+    EXPECT_EQ(0u, facets.count("board-games"));
+    EXPECT_EQ(1u, facets.counts().size());
+}
+
+TEST_F(DepartmentFacetsTest, leafDepartmentHasNoFacets)
+{
+    DepartmentFacets facets(*db, "poker");
+    facets.add("poker");
+    EXPECT_TRUE(facets.counts().empty());
+
+    DepartmentFacets unknown(*db, "unknown");
+    unknown.add("poker");
+    EXPECT_TRUE(unknown.counts().empty());
+}
+
+TEST_F(DepartmentFacetsTest, matchesDescendantQueries)
+{
+    const std::vector<std::string> apps = {"games", "board-games", "cards", "poker", "poker", "accessories", "unknown"};
+    DepartmentFacets facets(*db, "");
+    for (auto const& app: apps)
+    {
+        facets.add(app);
+    }
+
+    for (auto const& child: db->get_children_departments(""))
+    {
+        std::size_t expected = 0;
+        for (auto const& app: apps)
+        {
+            if (app == child.id || db->is_descendant_of_department(app, child.id))
+            {
+                ++expected;
+            }
+        }
+        EXPECT_EQ(expected, facets.count(child.id)) << child.id;
+    }
+}
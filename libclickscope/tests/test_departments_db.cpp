@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-db.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <sqlite3.h>
+
+using namespace click;
+
+namespace
+{
+
+// Runs sql on the database at path, returning its rows with the columns
+// separated by '|'.
+std::vector<std::string> query(const std::string& path, const std::string& sql)
+{
+    std::vector<std::string> rows;
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK)
+    {
+        sqlite3_close(db);
+        throw std::runtime_error("Cannot open " + path);
+    }
+    char* error = nullptr;
+    auto add_row = [](void* rows, int columns, char** values, char**) -> int {
+        std::ostringstream row;
+        for (int i = 0; i < columns; i++)
+        {
+            row << (i > 0 ? "|" : "") << (values[i] ? values[i] : "");
+        }
+        static_cast<std::vector<std::string>*>(rows)->push_back(row.str());
+        return 0;
+    };
+    const int result = sqlite3_exec(db, sql.c_str(), add_row, &rows, &error);
+    const std::string message = error ? error : "";
+    sqlite3_free(error);
+    sqlite3_close(db);
+    if (result != SQLITE_OK)
+    {
+        throw std::runtime_error(message);
+    }
+    return rows;
+}
+
+typedef std::vector<std::string> Rows;
+
+// Schema version 4, before the dept_closure table.
+const std::string VERSION_4_SCHEMA =
+    "CREATE TABLE pkgmap (pkgid TEXT, deptid TEXT, CONSTRAINT pkey PRIMARY KEY (pkgid, deptid));"
+    "CREATE TABLE depts (deptid TEXT, parentid TEXT, CONSTRAINT pkey PRIMARY KEY (deptid, parentid), CONSTRAINT fkey FOREIGN KEY (deptid) REFERENCES deptnames(deptid));"
+    "CREATE TABLE deptnames (deptid TEXT, locale TEXT, name TEXT, CONSTRAINT deptuniq PRIMARY KEY (deptid, locale));"
+    "CREATE TABLE meta (name TEXT PRIMARY KEY, value TEXT);"
+    "INSERT INTO meta (name, value) VALUES ('version', 4);";
+
+// Schema version 5 added the dept_closure table; applied to a version 4
+// database with its departments.
+const std::string VERSION_5_SCHEMA =
+    "CREATE TABLE dept_closure (ancestor TEXT, descendant TEXT, depth INTEGER, CONSTRAINT pkey PRIMARY KEY (ancestor, descendant));"
+    "CREATE INDEX dept_closure_descendant ON dept_closure (descendant);"
+    "CREATE INDEX pkgmap_deptid ON pkgmap (deptid);"
+    "INSERT INTO dept_closure VALUES ('', 'games', 1), ('', 'cards', 2), ('', 'poker', 3), ('', 'accessories', 1),"
+    "  ('games', 'games', 0), ('games', 'cards', 1), ('games', 'poker', 2), ('cards', 'cards', 0), ('cards', 'poker', 1),"
+    "  ('poker', 'poker', 0), ('accessories', 'accessories', 0);"
+    "UPDATE meta SET value='5' WHERE name='version';";
+
+//  "" -+- games -- cards -- poker
+//      +- accessories
+const std::string DEPARTMENTS =
+    "INSERT INTO depts VALUES ('games', '');"
+    "INSERT INTO depts VALUES ('cards', 'games');"
+    "INSERT INTO depts VALUES ('poker', 'cards');"
+    "INSERT INTO depts VALUES ('accessories', '');"
+    "INSERT INTO deptnames VALUES ('poker', 'en_US', 'Poker');"
+    "INSERT INTO pkgmap (pkgid, deptid) VALUES ('poker-app', 'poker');"
+    "INSERT INTO pkgmap (pkgid, deptid) VALUES ('notes', 'accessories');";
+
+const Rows CLOSURE = {
+    "|accessories|1", "|cards|2", "|games|1", "|poker|3",
+    "accessories|accessories|0",
+    "cards|cards|0", "cards|poker|1",
+    "games|cards|1", "games|games|0", "games|poker|2",
+    "poker|poker|0",
+};
+
+const std::string SELECT_CLOSURE = "SELECT ancestor, descendant, depth FROM dept_closure ORDER BY ancestor, descendant";
+const std::string SELECT_VERSION = "SELECT value FROM meta WHERE name='version'";
+
+class DepartmentsDbTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/departments-db-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        path = dir + "/departments.db";
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    void update_schema()
+    {
+        ASSERT_EQ(0, std::system(("sh " UPDATE_SCHEMA_SCRIPT " " + path + " > /dev/null").c_str()));
+    }
+
+    static void expect_hierarchy(DepartmentsDb& db)
+    {
+        EXPECT_TRUE(db.is_descendant_of_department("poker", "games"));
+        EXPECT_TRUE(db.is_descendant_of_department("poker", ""));
+        EXPECT_FALSE(db.is_descendant_of_department("poker", "accessories"));
+        EXPECT_EQ(std::unordered_set<std::string>({"poker-app"}), db.get_packages_for_department("games"));
+        EXPECT_FALSE(db.is_empty("cards"));
+        EXPECT_EQ("Poker", db.get_department_name("poker", {"en_US"}));
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+}
+
+TEST_F(DepartmentsDbTest, closureFollowsStoredDepartments)
+{
+    DepartmentsDb db(path);
+    db.store_department_mapping("games", "");
+    db.store_department_mapping("cards", "games");
+    db.store_department_mapping("poker", "cards");
+    db.store_department_mapping("accessories", "");
+    EXPECT_EQ(CLOSURE, query(path, SELECT_CLOSURE));
+    EXPECT_TRUE(db.is_descendant_of_department("poker", "games"));
+    EXPECT_FALSE(db.is_descendant_of_department("games", "poker"));
+}
+
+TEST_F(DepartmentsDbTest, closureIsRebuiltWithinBulkLoads)
+{
+    DepartmentsDb db(path);
+    db.store_department_mapping("games", "");
+    db.store_department_mapping("poker", "games");
+
+    // the bulk load replaces the hierarchy, so poker moves under cards
+    db.begin_bulk();
+    db.remove_all();
+    db.store_department_mapping("games", "");
+    db.store_department_mapping("cards", "games");
+    db.store_department_mapping("poker", "cards");
+    db.store_department_mapping("accessories", "");
+    db.commit_bulk();
+
+    EXPECT_EQ(CLOSURE, query(path, SELECT_CLOSURE));
+    EXPECT_TRUE(db.is_descendant_of_department("poker", "cards"));
+}
+
+TEST_F(DepartmentsDbTest, failedBulkLoadKeepsClosure)
+{
+    DepartmentsDb db(path);
+    db.store_department_mapping("games", "");
+    db.store_department_mapping("poker", "games");
+    auto const before = query(path, SELECT_CLOSURE);
+
+    db.begin_bulk();
+    db.remove_all();
+    db.store_department_mapping("accessories", "");
+    db.rollback_bulk();
+
+    EXPECT_EQ(before, query(path, SELECT_CLOSURE));
+    EXPECT_TRUE(db.is_descendant_of_department("poker", "games"));
+}
+
+TEST_F(DepartmentsDbTest, openingVersion4DatabaseBuildsClosure)
+{
+    query(path, VERSION_4_SCHEMA + DEPARTMENTS);
+    {
+        DepartmentsDb db(path);
+        expect_hierarchy(db);
+    }
+    EXPECT_EQ(CLOSURE, query(path, SELECT_CLOSURE));
+}
+
+TEST_F(DepartmentsDbTest, version4DatabaseIsReadWithoutClosure)
+{
+    query(path, VERSION_4_SCHEMA + DEPARTMENTS);
+    DepartmentsDb db(path, false);
+    expect_hierarchy(db);
+    EXPECT_EQ(Rows(), query(path, "SELECT name FROM sqlite_master WHERE name='dept_closure'"));
+}
+
+TEST_F(DepartmentsDbTest, updateSchemaMigratesVersion4)
+{
+    query(path, VERSION_4_SCHEMA + DEPARTMENTS);
+    update_schema();
+
+    EXPECT_EQ(Rows({"6"}), query(path, SELECT_VERSION));
+    EXPECT_EQ(CLOSURE, query(path, SELECT_CLOSURE));
+    EXPECT_EQ(Rows({"dept_closure_descendant", "pkgmap_deptid"}),
+              query(path, "SELECT name FROM sqlite_master WHERE type='index' AND name NOT LIKE 'sqlite_%' ORDER BY name"));
+
+    DepartmentsDb db(path, false);
+    expect_hierarchy(db);
+}
+
+TEST_F(DepartmentsDbTest, updateSchemaMigratesVersion5)
+{
+    query(path, VERSION_4_SCHEMA + DEPARTMENTS + VERSION_5_SCHEMA);
+    update_schema();
+
+    EXPECT_EQ(Rows({"6"}), query(path, SELECT_VERSION));
+    EXPECT_EQ(Rows({"notes|", "poker-app|"}), query(path, "SELECT pkgid, version FROM pkgmap ORDER BY pkgid"));
+    EXPECT_EQ(CLOSURE, query(path, SELECT_CLOSURE));
+
+    DepartmentsDb db(path, false);
+    expect_hierarchy(db);
+    EXPECT_EQ("", db.get_package_versions().at("poker-app"));
+}
+
+TEST_F(DepartmentsDbTest, openingVersion5DatabaseAddsVersions)
+{
+    query(path, VERSION_4_SCHEMA + DEPARTMENTS + VERSION_5_SCHEMA);
+    DepartmentsDb db(path);
+    db.begin_bulk();
+    db.store_package_version("poker-app", "1.0");
+    db.commit_bulk();
+
+    auto const versions = db.get_package_versions();
+    EXPECT_EQ(2u, versions.size());
+    EXPECT_EQ("1.0", versions.at("poker-app"));
+    EXPECT_EQ("", versions.at("notes"));
+    expect_hierarchy(db);
+}
+
+TEST_F(DepartmentsDbTest, packageVersionsNeedBulkLoad)
+{
+    DepartmentsDb db(path);
+    db.store_package_mapping("poker-app", "poker");
+    EXPECT_THROW(db.store_package_version("poker-app", "1.0"), std::logic_error);
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-db.h>
+#include <click/departments-import.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+using namespace click;
+
+namespace
+{
+
+const std::string EN_US_DEPARTMENTS =
+    "{\"_embedded\": {\"clickindex:department\": ["
+    "  {\"slug\": \"games\", \"name\": \"Games\", \"has_children\": true,"
+    "   \"_links\": {\"self\": {\"href\": \"https://example.com/departments/games\"}},"
+    "   \"_embedded\": {\"clickindex:department\": ["
+    "     {\"slug\": \"board-games\", \"name\": \"Board Games\","
+    "      \"_links\": {\"self\": {\"href\": \"https://example.com/departments/board-games\"}}}"
+    "   ]}},"
+    "  {\"slug\": \"accessories\", \"name\": \"Accessories\","
+    "   \"_links\": {\"self\": {\"href\": \"https://example.com/departments/accessories\"}}}"
+    "]}}";
+
+const std::string DE_DE_DEPARTMENTS =
+    "{\"_embedded\": {\"clickindex:department\": ["
+    "  {\"slug\": \"games\", \"name\": \"Spiele\", \"has_children\": true,"
+    "   \"_links\": {\"self\": {\"href\": \"https://example.com/departments/games\"}},"
+    "   \"_embedded\": {\"clickindex:department\": ["
+    "     {\"slug\": \"board-games\", \"name\": \"Brettspiele\","
+    "      \"_links\": {\"self\": {\"href\": \"https://example.com/departments/board-games\"}}}"
+    "   ]}},"
+    "  {\"slug\": \"accessories\", \"name\": \"Zubehör\","
+    "   \"_links\": {\"self\": {\"href\": \"https://example.com/departments/accessories\"}}}"
+    "]}}";
+
+const std::string CHESS_DETAILS =
+    "{\"name\": \"com.example.chess\", \"title\": \"Chess\", \"version\": \"1.2\","
+    " \"department\": [\"games\", \"board-games\"]}";
+
+const std::string NOTES_DETAILS =
+    "{\"name\": \"com.example.notes\", \"title\": \"Notes\", \"department\": [\"accessories\"]}";
+
+const std::list<std::pair<std::string, std::string>> EXTRA_MAPPINGS = {
+    {"dialer-app.desktop", "accessories"}
+};
+
+class DepartmentsImportTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/departments-import-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        dumps = dir + "/dumps";
+        ASSERT_EQ(0, std::system(("mkdir -p " + dumps + "/departments " + dumps + "/packages").c_str()));
+        db.reset(new DepartmentsDb(dir + "/departments.db"));
+    }
+
+    void TearDown() override
+    {
+        db.reset();
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    void write_dump(const std::string& name, const std::string& contents)
+    {
+        std::ofstream(dumps + "/" + name) << contents;
+    }
+
+    void write_fixture()
+    {
+        write_dump("departments/en_US.json", EN_US_DEPARTMENTS);
+        write_dump("departments/de_DE.json", DE_DE_DEPARTMENTS);
+        write_dump("packages/chess.json", CHESS_DETAILS);
+        write_dump("packages/notes.json", NOTES_DETAILS);
+    }
+
+    std::string dir;
+    std::string dumps;
+    std::unique_ptr<DepartmentsDb> db;
+};
+
+} // namespace
+
+TEST_F(DepartmentsImportTest, importsDepartmentsAndPackages)
+{
+    write_fixture();
+
+    auto const stats = import_departments(*db, dumps, EXTRA_MAPPINGS);
+    EXPECT_EQ(2u, stats.locales);
+    EXPECT_EQ(2u, stats.packages);
+    EXPECT_EQ(0u, stats.invalid_files);
+
+    EXPECT_EQ(3, db->department_mapping_count());
+    EXPECT_EQ(3, db->package_count());
+    EXPECT_EQ(6, db->department_name_count());
+
+    EXPECT_EQ("board-games", db->get_department_for_package("com.example.chess"));
+    EXPECT_EQ("accessories", db->get_department_for_package("dialer-app.desktop"));
+    EXPECT_EQ("games", db->get_parent_department_id("board-games"));
+    EXPECT_EQ("Brettspiele", db->get_department_name("board-games", {"de_DE"}));
+    EXPECT_EQ("Board Games", db->get_department_name("board-games", {"en_US"}));
+    EXPECT_EQ(std::unordered_set<std::string>({"com.example.chess"}), db->get_packages_for_department("games"));
+    EXPECT_EQ(std::unordered_set<std::string>({"com.example.notes", "dialer-app.desktop"}),
+              db->get_packages_for_department("accessories"));
+
+    auto const versions = db->get_package_versions();
+    ASSERT_EQ(1u, versions.count("com.example.chess"));
+    EXPECT_EQ("1.2", versions.at("com.example.chess"));
+}
+
+TEST_F(DepartmentsImportTest, skipsInvalidFiles)
+{
+    write_fixture();
+    write_dump("departments/fr_FR.json", "{\"_embedded\": {}}");
+    write_dump("packages/truncated.json", "{\"name\": \"com.example.trunc");
+    write_dump("packages/nodepartment.json", "{\"name\": \"com.example.nodept\", \"department\": []}");
+
+    auto const stats = import_departments(*db, dumps, EXTRA_MAPPINGS);
+    EXPECT_EQ(2u, stats.locales);
+    EXPECT_EQ(2u, stats.packages);
+    EXPECT_EQ(3u, stats.invalid_files);
+
+    EXPECT_EQ(3, db->package_count());
+    EXPECT_FALSE(db->has_package("com.example.nodept"));
+}
+
+TEST_F(DepartmentsImportTest, replacesStoredData)
+{
+    db->store_package_mapping("com.example.old", "games");
+    write_fixture();
+
+    import_departments(*db, dumps, EXTRA_MAPPINGS);
+    EXPECT_FALSE(db->has_package("com.example.old"));
+    EXPECT_EQ(3, db->package_count());
+}
+
+TEST_F(DepartmentsImportTest, keepsStoredDataWithoutDepartments)
+{
+    db->store_package_mapping("com.example.old", "games");
+    write_dump("packages/chess.json", CHESS_DETAILS);
+
+    auto const stats = import_departments(*db, dumps, EXTRA_MAPPINGS);
+    EXPECT_EQ(0u, stats.locales);
+    EXPECT_TRUE(db->has_package("com.example.old"));
+    EXPECT_EQ(1, db->package_count());
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-snapshot.h>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace click;
+
+namespace
+{
+
+typedef std::unordered_set<std::string> Packages;
+typedef std::vector<std::pair<std::string, bool>> Children;
+
+//  "" -+- games -+- board-games
+//      |         +- cards -- poker
+//      |         +- puzzles
+//      +- accessories
+//
+// "unlisted" has packages but no row in depts.
+DepartmentsSnapshot::Rows depts()
+{
+    return {
+        {"games", ""},
+        {"board-games", "games"},
+        {"cards", "games"},
+        {"poker", "cards"},
+        {"puzzles", "games"},
+        {"accessories", ""},
+    };
+}
+
+DepartmentsSnapshot::Rows pkgmap()
+{
+    return {
+        {"chess", "board-games"},
+        {"lost", "unlisted"},
+        {"multi", "accessories"},
+        {"multi", "games"},
+        {"notes", "accessories"},
+        {"poker-app", "poker"},
+        {"solitaire", "cards"},
+    };
+}
+
+std::shared_ptr<const DepartmentsSnapshot> snapshot()
+{
+    return DepartmentsSnapshot::build(depts(), pkgmap());
+}
+
+}
+
+TEST(DepartmentsSnapshot, parentsAndChildren)
+{
+    auto s = snapshot();
+    ASSERT_NE(nullptr, s);
+    EXPECT_EQ("", s->parent_of("games"));
+    EXPECT_EQ("cards", s->parent_of("poker"));
+    EXPECT_THROW(s->parent_of(""), std::logic_error);
+    EXPECT_THROW(s->parent_of("unlisted"), std::logic_error);
+    EXPECT_THROW(s->parent_of("unknown"), std::logic_error);
+
+    EXPECT_EQ(Children({{"games", true}, {"accessories", false}}), s->children_of(""));
+    EXPECT_EQ(Children({{"board-games", false}, {"cards", true}, {"puzzles", false}}), s->children_of("games"));
+    EXPECT_EQ(Children(), s->children_of("poker"));
+    EXPECT_EQ(Children(), s->children_of("unknown"));
+}
+
+TEST(DepartmentsSnapshot, descendantsFollowTheEulerTour)
+{
+    auto s = snapshot();
+    ASSERT_NE(nullptr, s);
+    EXPECT_TRUE(s->is_descendant_of("poker", "games"));
+    EXPECT_TRUE(s->is_descendant_of("poker", "cards"));
+    EXPECT_TRUE(s->is_descendant_of("poker", ""));
+    EXPECT_TRUE(s->is_descendant_of("puzzles", "games"));
+    EXPECT_FALSE(s->is_descendant_of("games", "games"));
+    EXPECT_FALSE(s->is_descendant_of("games", "poker"));
+    EXPECT_FALSE(s->is_descendant_of("accessories", "games"));
+    EXPECT_FALSE(s->is_descendant_of("puzzles", "cards"));
+    EXPECT_FALSE(s->is_descendant_of("unknown", ""));
+}
+
+TEST(DepartmentsSnapshot, topDepartmentsUnder)
+{
+    auto s = snapshot();
+    ASSERT_NE(nullptr, s);
+    const std::unordered_map<std::string, std::string> under_root = {
+        {"games", "games"}, {"board-games", "games"}, {"cards", "games"},
+        {"poker", "games"}, {"puzzles", "games"}, {"accessories", "accessories"},
+    };
+    EXPECT_EQ(under_root, s->top_departments_under(""));
+    const std::unordered_map<std::string, std::string> under_cards = {{"poker", "poker"}};
+    EXPECT_EQ(under_cards, s->top_departments_under("cards"));
+    EXPECT_TRUE(s->top_departments_under("unknown").empty());
+}
+
+TEST(DepartmentsSnapshot, recursivePackagesCoverTheSubtree)
+{
+    auto s = snapshot();
+    ASSERT_NE(nullptr, s);
+    EXPECT_EQ(Packages({"chess", "multi", "poker-app", "solitaire"}), s->packages_of("games", true));
+    EXPECT_EQ(Packages({"multi"}), s->packages_of("games", false));
+    EXPECT_EQ(Packages({"poker-app", "solitaire"}), s->packages_of("cards", true));
+    EXPECT_EQ(Packages({"chess", "multi", "notes", "poker-app", "solitaire"}), s->packages_of("", true));
+    EXPECT_EQ(Packages(), s->packages_of("unknown", true));
+
+    // like the recursive queries, departments without a row in depts
+    // don't count themselves
+    EXPECT_EQ(Packages(), s->packages_of("unlisted", true));
+    EXPECT_EQ(Packages({"lost"}), s->packages_of("unlisted", false));
+
+    EXPECT_FALSE(s->is_empty("games"));
+    EXPECT_FALSE(s->is_empty("poker"));
+    EXPECT_TRUE(s->is_empty("puzzles"));
+    EXPECT_TRUE(s->is_empty("unlisted"));
+    EXPECT_TRUE(s->is_empty("unknown"));
+}
+
+TEST(DepartmentsSnapshot, packagesKeepTheirFirstDepartment)
+{
+    auto s = snapshot();
+    ASSERT_NE(nullptr, s);
+    EXPECT_TRUE(s->has_package("lost"));
+    EXPECT_FALSE(s->has_package("unknown"));
+    ASSERT_NE(nullptr, s->department_of("multi"));
+    EXPECT_EQ("accessories", *s->department_of("multi"));
+    ASSERT_NE(nullptr, s->department_of("poker-app"));
+    EXPECT_EQ("poker", *s->department_of("poker-app"));
+    EXPECT_EQ(nullptr, s->department_of("unknown"));
+}
+
+TEST(DepartmentsSnapshot, repeatedRowsAreAccepted)
+{
+    auto rows = depts();
+    rows.push_back({"poker", "cards"});
+    EXPECT_NE(nullptr, DepartmentsSnapshot::build(rows, pkgmap()));
+}
+
+TEST(DepartmentsSnapshot, multipleParentsFallBack)
+{
+    auto rows = depts();
+    rows.push_back({"poker", "accessories"});
+    EXPECT_EQ(nullptr, DepartmentsSnapshot::build(rows, pkgmap()));
+}
+
+TEST(DepartmentsSnapshot, cyclesFallBack)
+{
+    auto rows = depts();
+    rows.push_back({"loop-a", "loop-b"});
+    rows.push_back({"loop-b", "loop-a"});
+    EXPECT_EQ(nullptr, DepartmentsSnapshot::build(rows, pkgmap()));
+
+    EXPECT_EQ(nullptr, DepartmentsSnapshot::build({{"self", "self"}}, {}));
+}
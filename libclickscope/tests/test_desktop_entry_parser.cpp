@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/desktop-entry-parser.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace click;
+
+namespace
+{
+
+typedef std::vector<std::string> Items;
+
+std::string unescape(const std::string& value)
+{
+    return DesktopEntryParser::unescape({value.data(), value.size()});
+}
+
+Items split_list(const std::string& value)
+{
+    return DesktopEntryParser::split_list({value.data(), value.size()});
+}
+
+}
+
+TEST(DesktopEntryParser, unescapeResolvesKnownEscapes)
+{
+    EXPECT_EQ("a b\nc\td\re\\f", unescape("a\\sb\\nc\\td\\re\\\\f"));
+}
+
+TEST(DesktopEntryParser, unescapeKeepsUnknownEscapes)
+{
+    EXPECT_EQ("a\\qb", unescape("a\\qb"));
+}
+
+TEST(DesktopEntryParser, unescapeKeepsTrailingBackslash)
+{
+    EXPECT_EQ("a\\", unescape("a\\"));
+    EXPECT_EQ("\\", unescape("\\"));
+}
+
+TEST(DesktopEntryParser, splitListSplitsOnSemicolons)
+{
+    EXPECT_EQ(Items({"a", "b", "c"}), split_list("a;b;c"));
+    EXPECT_EQ(Items({"a", "b"}), split_list("a;b;"));
+    EXPECT_EQ(Items({"a", "", "b"}), split_list("a;;b"));
+    EXPECT_EQ(Items(), split_list(""));
+}
+
+TEST(DesktopEntryParser, splitListHonoursEscapedSemicolons)
+{
+    EXPECT_EQ(Items({"a;b", "c"}), split_list("a\\;b;c"));
+}
+
+TEST(DesktopEntryParser, splitListUnescapesItems)
+{
+    EXPECT_EQ(Items({"x y", "z\\"}), split_list("x\\sy;z\\\\"));
+}
+
+TEST(DesktopEntryParser, splitListKeepsTrailingBackslash)
+{
+    EXPECT_EQ(Items({"a", "b\\"}), split_list("a;b\\"));
+    EXPECT_EQ(Items({"\\"}), split_list("\\"));
+}
+
+TEST(DesktopEntryParser, picksBestTranslation)
+{
+    char path[] = "/tmp/desktop-entry-parser-test.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    std::ofstream(path) << "[Desktop Entry]\n"
+                           "Name=Name\n"
+                           "Name[de]=Name de\n"
+                           "Name[de_DE]=Name de_DE\n"
+                           "Keywords=one;two\n"
+                           "[Other Group]\n"
+                           "Comment=Other\n";
+
+    {
+        DesktopEntryParser parser(path, "de_DE.UTF-8");
+        EXPECT_TRUE(parser.has_group());
+        EXPECT_TRUE(parser.get("Name") == "Name");
+        EXPECT_TRUE(parser.get_localized("Name") == "Name de_DE");
+        EXPECT_TRUE(parser.get_localized("Keywords") == "one;two");
+        EXPECT_FALSE(parser.has_key("Comment"));
+    }
+    {
+        DesktopEntryParser parser(path, "de_AT");
+        EXPECT_TRUE(parser.get_localized("Name") == "Name de");
+    }
+    {
+        DesktopEntryParser parser(path, "fr_FR");
+        EXPECT_TRUE(parser.get_localized("Name") == "Name");
+    }
+    unlink(path);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/desktop-file-cache.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include <fcntl.h>
+#include <libintl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace click;
+
+namespace
+{
+
+class DesktopFileCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/desktop-file-cache-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        cache_path = dir + "/cache";
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    std::string write_file(const std::string& name, const std::string& contents)
+    {
+        const std::string path = dir + "/" + name;
+        std::ofstream(path) << contents;
+        return path;
+    }
+
+    static DesktopEntry entry(const std::string& name)
+    {
+        DesktopEntry e;
+        e.filename = name + ".desktop";
+        e.has_desktop_group = true;
+        e.name = name;
+        e.keywords = {"one", "two"};
+        e.search_name = name;
+        return e;
+    }
+
+    std::string dir;
+    std::string cache_path;
+};
+
+}
+
+TEST_F(DesktopFileCacheTest, entriesSurviveReload)
+{
+    const auto path = write_file("app.desktop", "[Desktop Entry]\n");
+    DesktopFileCache::Stamp stamp;
+    ASSERT_TRUE(DesktopFileCache::stamp_for(path, stamp));
+    {
+        DesktopFileCache cache(cache_path, "en_US");
+        cache.store(path, stamp, entry("App"));
+        cache.save({path});
+    }
+
+    DesktopFileCache cache(cache_path, "en_US");
+    DesktopEntry found;
+    ASSERT_TRUE(cache.lookup(path, stamp, found));
+    EXPECT_EQ("App", found.name);
+    EXPECT_EQ("App.desktop", found.filename);
+    EXPECT_EQ(std::vector<std::string>({"one", "two"}), found.keywords);
+    EXPECT_TRUE(found.has_desktop_group);
+}
+
+TEST_F(DesktopFileCacheTest, changedStampMisses)
+{
+    const auto path = write_file("app.desktop", "[Desktop Entry]\n");
+    DesktopFileCache::Stamp stamp;
+    ASSERT_TRUE(DesktopFileCache::stamp_for(path, stamp));
+    DesktopFileCache cache(cache_path, "en_US");
+    cache.store(path, stamp, entry("App"));
+
+    auto changed = stamp;
+    changed.size++;
+    DesktopEntry found;
+    EXPECT_FALSE(cache.lookup(path, changed, found));
+}
+
+TEST_F(DesktopFileCacheTest, otherLanguageDiscardsCache)
+{
+    const auto path = write_file("app.desktop", "[Desktop Entry]\n");
+    DesktopFileCache::Stamp stamp;
+    ASSERT_TRUE(DesktopFileCache::stamp_for(path, stamp));
+    {
+        DesktopFileCache cache(cache_path, "en_US");
+        cache.store(path, stamp, entry("App"));
+        cache.save({path});
+    }
+
+    DesktopFileCache cache(cache_path, "de_DE");
+    DesktopEntry found;
+    EXPECT_FALSE(cache.lookup(path, stamp, found));
+}
+
+TEST_F(DesktopFileCacheTest, saveDropsRemovedFiles)
+{
+    const auto kept = write_file("kept.desktop", "[Desktop Entry]\n");
+    const auto removed = write_file("removed.desktop", "[Desktop Entry]\n");
+    DesktopFileCache::Stamp kept_stamp, removed_stamp;
+    ASSERT_TRUE(DesktopFileCache::stamp_for(kept, kept_stamp));
+    ASSERT_TRUE(DesktopFileCache::stamp_for(removed, removed_stamp));
+    {
+        DesktopFileCache cache(cache_path, "en_US");
+        cache.store(kept, kept_stamp, entry("Kept"));
+        cache.store(removed, removed_stamp, entry("Removed"));
+        cache.save({kept});
+    }
+
+    DesktopFileCache cache(cache_path, "en_US");
+    DesktopEntry found;
+    EXPECT_TRUE(cache.lookup(kept, kept_stamp, found));
+    EXPECT_FALSE(cache.lookup(removed, removed_stamp, found));
+}
+
+TEST_F(DesktopFileCacheTest, updatedCatalogInvalidatesTranslatedEntries)
+{
+    const std::string domain = "desktop-file-cache-test";
+    ASSERT_EQ(0, mkdir((dir + "/de").c_str(), 0700));
+    ASSERT_EQ(0, mkdir((dir + "/de/LC_MESSAGES").c_str(), 0700));
+    const auto catalog = write_file("de/LC_MESSAGES/" + domain + ".mo", "");
+    bindtextdomain(domain.c_str(), dir.c_str());
+
+    // de_DE falls back to the catalog of de
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "de_DE"));
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "de_DE.UTF-8@euro"));
+    EXPECT_EQ(0u, DesktopFileCache::catalog_mtime_for(domain, "fr_FR"));
+
+    const auto path = write_file("app.desktop", "[Desktop Entry]\n");
+    DesktopFileCache::Stamp stamp;
+    ASSERT_TRUE(DesktopFileCache::stamp_for(path, stamp));
+    auto translated = entry("App");
+    translated.gettext_domain = domain;
+    DesktopFileCache cache(cache_path, "de_DE");
+    cache.store(path, stamp, translated);
+
+    DesktopEntry found;
+    EXPECT_TRUE(cache.lookup(path, stamp, found));
+
+    const struct timespec times[2] = {{1000, 0}, {1000, 0}};
+    ASSERT_EQ(0, utimensat(AT_FDCWD, catalog.c_str(), times, 0));
+    // catalogs are only looked up again by the next scan
+    EXPECT_TRUE(cache.lookup(path, stamp, found));
+    cache.begin_scan();
+    EXPECT_FALSE(cache.lookup(path, stamp, found));
+}
+
+TEST_F(DesktopFileCacheTest, catalogLookupFollowsGettextFallbacks)
+{
+    const std::string domain = "desktop-file-cache-fallback-test";
+    const std::string messages = dir + "/pt_BR/LC_MESSAGES";
+    ASSERT_EQ(0, std::system(("mkdir -p " + messages).c_str()));
+    const auto catalog = write_file("pt_BR/LC_MESSAGES/" + domain + ".mo", "");
+    bindtextdomain(domain.c_str(), dir.c_str());
+
+    // the codeset and the modifier are dropped before the territory
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "pt_BR.UTF-8"));
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "pt_BR@latin"));
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "pt_BR.UTF-8@latin"));
+    EXPECT_EQ(0u, DesktopFileCache::catalog_mtime_for(domain, "pt"));
+    EXPECT_EQ(0u, DesktopFileCache::catalog_mtime_for(domain, "pt_PT.UTF-8"));
+
+    // and the languages of a LANGUAGE list are tried in order
+    EXPECT_NE(0u, DesktopFileCache::catalog_mtime_for(domain, "fr_FR:pt_BR.utf8"));
+
+    // the normalized codeset comes right after the given one
+    const std::string normalized = dir + "/pt_BR.utf8/LC_MESSAGES";
+    ASSERT_EQ(0, std::system(("mkdir -p " + normalized).c_str()));
+    write_file("pt_BR.utf8/LC_MESSAGES/" + domain + ".mo", "");
+    const struct timespec times[2] = {{1000, 0}, {1000, 0}};
+    ASSERT_EQ(0, utimensat(AT_FDCWD, catalog.c_str(), times, 0));
+    EXPECT_NE(1000000000000u, DesktopFileCache::catalog_mtime_for(domain, "pt_BR.UTF-8"));
+    EXPECT_EQ(1000000000000u, DesktopFileCache::catalog_mtime_for(domain, "pt_BR"));
+}
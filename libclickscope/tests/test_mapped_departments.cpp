@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-db.h>
+#include <click/departments-snapshot.h>
+#include <click/mapped-departments.h>
+#include <click/mapped-departments-db.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace click;
+
+namespace
+{
+
+typedef std::vector<std::pair<std::string, bool>> Children;
+
+MappedDepartments::Rows depts()
+{
+    return {
+        {"games", ""},
+        {"board-games", "games"},
+        {"cards", "games"},
+        {"poker", "cards"},
+        {"puzzles", "games"},
+        {"accessories", ""},
+    };
+}
+
+MappedDepartments::Rows pkgmap()
+{
+    return {
+        {"chess", "board-games"},
+        {"lost", "unlisted"},
+        {"multi", "accessories"},
+        {"multi", "games"},
+        {"notes", "accessories"},
+        {"poker-app", "poker"},
+        {"solitaire", "cards"},
+    };
+}
+
+std::vector<MappedDepartments::Name> names()
+{
+    return {
+        {"games", "en_US", "Games"},
+        {"games", "de_DE", "Spiele"},
+        {"poker", "en_US", "Poker"},
+    };
+}
+
+Children sorted(Children children)
+{
+    std::sort(children.begin(), children.end());
+    return children;
+}
+
+class MappedDepartmentsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/mapped-departments-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        path = dir + "/departments.mapped";
+        sources[0] = FileStamp{1000, 4096, 42};
+        sources[1] = FileStamp{0, -1, 0};
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    void write()
+    {
+        MappedDepartments::write(path, sources, depts(), pkgmap(), names());
+    }
+
+    // Overwrites the file at offset with the given bytes.
+    void patch(long offset, const std::string& bytes)
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.write(bytes.data(), bytes.size());
+    }
+
+    std::string dir;
+    std::string path;
+    FileStamp sources[2];
+};
+
+}
+
+TEST_F(MappedDepartmentsTest, roundTripMatchesSnapshot)
+{
+    write();
+    auto mapped = MappedDepartments::open(path);
+    ASSERT_NE(nullptr, mapped);
+    auto snapshot = DepartmentsSnapshot::build(depts(), pkgmap());
+    ASSERT_NE(nullptr, snapshot);
+
+    EXPECT_EQ(sources[0], mapped->source(0));
+    EXPECT_EQ(sources[1], mapped->source(1));
+
+    const std::vector<std::string> ids = {"", "games", "board-games", "cards", "poker", "puzzles", "accessories", "unlisted", "unknown"};
+    for (auto const& id: ids)
+    {
+        SCOPED_TRACE(id);
+        std::string parent;
+        bool known = true;
+        try
+        {
+            parent = snapshot->parent_of(id);
+        }
+        catch (const std::logic_error&)
+        {
+            known = false;
+        }
+        if (known)
+        {
+            EXPECT_EQ(parent, mapped->parent_of(id));
+        }
+        else
+        {
+            EXPECT_THROW(mapped->parent_of(id), std::logic_error);
+        }
+
+        EXPECT_EQ(sorted(snapshot->children_of(id)), sorted(mapped->children_of(id)));
+        EXPECT_EQ(snapshot->top_departments_under(id), mapped->top_departments_under(id));
+        EXPECT_EQ(snapshot->packages_of(id, true), mapped->packages_of(id, true));
+        EXPECT_EQ(snapshot->packages_of(id, false), mapped->packages_of(id, false));
+        EXPECT_EQ(snapshot->is_empty(id), mapped->is_empty(id));
+        for (auto const& other: ids)
+        {
+            EXPECT_EQ(snapshot->is_descendant_of(id, other), mapped->is_descendant_of(id, other)) << other;
+        }
+    }
+
+    for (auto const& pkg: {"chess", "lost", "multi", "poker-app", "unknown"})
+    {
+        SCOPED_TRACE(pkg);
+        EXPECT_EQ(snapshot->has_package(pkg), mapped->has_package(pkg));
+        std::string department;
+        const bool found = mapped->department_of(pkg, department);
+        ASSERT_EQ(snapshot->department_of(pkg) != nullptr, found);
+        if (found)
+        {
+            EXPECT_EQ(*snapshot->department_of(pkg), department);
+        }
+    }
+
+    std::string name;
+    EXPECT_TRUE(mapped->name_of("games", "de_DE", name));
+    EXPECT_EQ("Spiele", name);
+    EXPECT_TRUE(mapped->name_of("poker", "en_US", name));
+    EXPECT_EQ("Poker", name);
+    EXPECT_FALSE(mapped->name_of("poker", "de_DE", name));
+    EXPECT_FALSE(mapped->name_of("unknown", "en_US", name));
+}
+
+TEST_F(MappedDepartmentsTest, rewritingReplacesFile)
+{
+    write();
+    auto before = MappedDepartments::open(path);
+    ASSERT_NE(nullptr, before);
+
+    sources[0].size = 8192;
+    MappedDepartments::write(path, sources, {{"games", ""}}, {}, {});
+    auto after = MappedDepartments::open(path);
+    ASSERT_NE(nullptr, after);
+    EXPECT_EQ(8192, after->source(0).size);
+    EXPECT_TRUE(after->children_of("games").empty());
+
+    // the file mapped before stays intact
+    EXPECT_EQ(4096, before->source(0).size);
+    EXPECT_EQ(3u, before->children_of("games").size());
+}
+
+TEST_F(MappedDepartmentsTest, invalidDepartmentsAreNotWritten)
+{
+    auto rows = depts();
+    rows.push_back({"poker", "accessories"});
+    EXPECT_THROW(MappedDepartments::write(path, sources, rows, pkgmap(), names()), std::runtime_error);
+    EXPECT_EQ(-1, FileStamp::of(path).size);
+    // no temporary file is left behind
+    EXPECT_EQ(0, std::system(("test -z \"$(ls -A " + dir + ")\"").c_str()));
+}
+
+TEST_F(MappedDepartmentsTest, rejectsMissingAndShortFiles)
+{
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+
+    std::ofstream(path) << "";
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+
+    std::ofstream(path) << "CLKDEPTS";
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+}
+
+TEST_F(MappedDepartmentsTest, rejectsTruncatedFile)
+{
+    write();
+    const long size = FileStamp::of(path).size;
+    ASSERT_EQ(0, truncate(path.c_str(), size / 2));
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+}
+
+TEST_F(MappedDepartmentsTest, rejectsWrongMagicOrVersion)
+{
+    write();
+    patch(0, "X");
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+
+    write();
+    ASSERT_NE(nullptr, MappedDepartments::open(path));
+    // the format version follows the magic and the byte order mark
+    patch(12, std::string("\x7f\x00\x00\x00", 4));
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+}
+
+TEST_F(MappedDepartmentsTest, rejectsOutOfBoundsSections)
+{
+    write();
+    const long size = FileStamp::of(path).size;
+    // the node count follows the magic, byte order mark, version and the
+    // six 8 byte source stamp fields
+    patch(64, std::string("\xff\xff\xff\x0f", 4));
+    EXPECT_EQ(nullptr, MappedDepartments::open(path));
+    EXPECT_EQ(size, FileStamp::of(path).size);
+}
+
+namespace
+{
+
+class MappedDepartmentsDbTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/mapped-departments-db-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        db_path = dir + "/departments.db";
+        mapped_path = DepartmentsDb::mapped_path(db_path);
+
+        DepartmentsDb db(db_path);
+        db.store_department_mapping("games", "");
+        db.store_department_mapping("poker", "games");
+        db.store_department_name("poker", "en_US", "Poker");
+        db.store_package_mapping("poker-app", "poker");
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    // like init-departments, once the database that was written is closed
+    void export_mapped()
+    {
+        DepartmentsDb(db_path, false).export_mapped(mapped_path);
+    }
+
+    std::string dir;
+    std::string db_path;
+    std::string mapped_path;
+};
+
+}
+
+TEST_F(MappedDepartmentsDbTest, readsExportedFile)
+{
+    export_mapped();
+    auto db = MappedDepartmentsDb::open(db_path, mapped_path);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ("games", db->get_parent_department_id("poker"));
+    EXPECT_EQ("poker", db->get_department_for_package("poker-app"));
+    EXPECT_EQ("Poker", db->get_department_name("poker", {"en_US"}));
+    EXPECT_TRUE(db->is_descendant_of_department("poker", "games"));
+}
+
+TEST_F(MappedDepartmentsDbTest, ignoresFileOfChangedDatabase)
+{
+    export_mapped();
+    DepartmentsDb(db_path, false).store_package_mapping("chess", "games");
+    EXPECT_EQ(nullptr, MappedDepartmentsDb::open(db_path, mapped_path));
+
+    export_mapped();
+    auto db = MappedDepartmentsDb::open(db_path, mapped_path);
+    ASSERT_NE(nullptr, db);
+    EXPECT_EQ("games", db->get_department_for_package("chess"));
+}
+
+TEST_F(MappedDepartmentsDbTest, ignoresMissingFile)
+{
+    EXPECT_EQ(nullptr, MappedDepartmentsDb::open(db_path, mapped_path));
+}
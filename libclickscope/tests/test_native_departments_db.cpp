@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/departments-db.h>
+#include <click/native-departments-db.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include <sqlite3.h>
+
+using namespace click;
+
+namespace
+{
+
+typedef std::vector<std::string> Rows;
+
+// Rows of sql on the database at path, with the columns separated by '|'.
+Rows dump(const std::string& path, const std::string& sql)
+{
+    Rows rows;
+    sqlite3* db = nullptr;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK)
+    {
+        sqlite3_close(db);
+        throw std::runtime_error("Cannot open " + path);
+    }
+    auto add_row = [](void* rows, int columns, char** values, char**) -> int {
+        std::ostringstream row;
+        for (int i = 0; i < columns; i++)
+        {
+            row << (i > 0 ? "|" : "") << (values[i] ? values[i] : "");
+        }
+        static_cast<Rows*>(rows)->push_back(row.str());
+        return 0;
+    };
+    const int result = sqlite3_exec(db, sql.c_str(), add_row, &rows, nullptr);
+    sqlite3_close(db);
+    if (result != SQLITE_OK)
+    {
+        throw std::runtime_error("Cannot run " + sql);
+    }
+    return rows;
+}
+
+// The same writes, for both backends.
+void fill(DepartmentsDb& db)
+{
+    db.store_department_mapping("games", "");
+    db.store_department_mapping("board-games", "games");
+    db.store_department_mapping("cards", "games");
+    db.store_department_mapping("poker", "cards");
+    db.store_department_mapping("puzzles", "games");
+    db.store_department_mapping("accessories", "");
+    db.store_department_name("games", "en_US", "Games");
+    db.store_department_name("games", "de_DE", "Spiele");
+    db.store_department_name("poker", "en_US", "Poker");
+    db.store_department_name("accessories", "en_US", "Accessories");
+
+    const std::vector<std::pair<std::string, std::string>> mappings = {
+        {"chess", "board-games"},
+        {"lost", "unlisted"},
+        {"multi", "accessories"},
+        {"multi", "games"},
+        {"notes", "accessories"},
+        {"poker-app", "poker"},
+        {"solitaire", "cards"},
+    };
+    db.begin_bulk(true);
+    db.store_package_mappings(mappings);
+    db.store_package_version("chess", "1.0");
+    db.store_meta("checkpoint.run", "1");
+    db.commit_bulk();
+    db.store_package_mapping("dialer-app.desktop", "accessories");
+}
+
+const std::vector<std::string> DEPARTMENTS = {
+    "", "games", "board-games", "cards", "poker", "puzzles", "accessories", "unlisted", "unknown"
+};
+const std::vector<std::string> PACKAGES = {
+    "chess", "lost", "multi", "notes", "poker-app", "solitaire", "dialer-app.desktop", "unknown"
+};
+
+// The result of f, or "throws" if it throws std::logic_error.
+template <typename F>
+std::string result_of(F f)
+{
+    try
+    {
+        return f();
+    }
+    catch (const std::logic_error&)
+    {
+        return "throws";
+    }
+}
+
+Rows children(DepartmentsDb& db, const std::string& department_id)
+{
+    Rows children;
+    for (auto const& child: db.get_children_departments(department_id))
+    {
+        children.push_back(child.id + (child.has_children ? "+" : ""));
+    }
+    std::sort(children.begin(), children.end());
+    return children;
+}
+
+class NativeDepartmentsDbTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        char dir_template[] = "/tmp/native-departments-db-test.XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir_template));
+        dir = dir_template;
+        qt_path = dir + "/qt.db";
+        native_path = dir + "/native.db";
+    }
+
+    void TearDown() override
+    {
+        ASSERT_EQ(0, std::system(("rm -rf " + dir).c_str()));
+    }
+
+    std::string dir;
+    std::string qt_path;
+    std::string native_path;
+};
+
+}
+
+TEST_F(NativeDepartmentsDbTest, writesTheSameRows)
+{
+    {
+        DepartmentsDb qt(qt_path);
+        fill(qt);
+        NativeDepartmentsDb native(native_path);
+        fill(native);
+    }
+
+    const std::vector<std::string> tables = {
+        "SELECT pkgid, deptid, version FROM pkgmap ORDER BY pkgid, deptid",
+        "SELECT deptid, parentid FROM depts ORDER BY deptid, parentid",
+        "SELECT deptid, locale, name FROM deptnames ORDER BY deptid, locale",
+        "SELECT ancestor, descendant, depth FROM dept_closure ORDER BY ancestor, descendant",
+        "SELECT name, value FROM meta ORDER BY name",
+    };
+    for (auto const& sql: tables)
+    {
+        SCOPED_TRACE(sql);
+        auto const rows = dump(qt_path, sql);
+        EXPECT_FALSE(rows.empty());
+        EXPECT_EQ(rows, dump(native_path, sql));
+    }
+}
+
+TEST_F(NativeDepartmentsDbTest, readsTheSameAnswers)
+{
+    {
+        DepartmentsDb db(qt_path);
+        fill(db);
+    }
+    DepartmentsDb qt(qt_path, false);
+    NativeDepartmentsDb native(qt_path, false);
+
+    for (auto const& id: DEPARTMENTS)
+    {
+        SCOPED_TRACE(id);
+        EXPECT_EQ(result_of([&]() { return qt.get_parent_department_id(id); }),
+                  result_of([&]() { return native.get_parent_department_id(id); }));
+        EXPECT_EQ(children(qt, id), children(native, id));
+        EXPECT_EQ(qt.get_packages_for_department(id, true), native.get_packages_for_department(id, true));
+        EXPECT_EQ(qt.get_packages_for_department(id, false), native.get_packages_for_department(id, false));
+        EXPECT_EQ(qt.is_empty(id), native.is_empty(id));
+        EXPECT_EQ(qt.get_top_departments_under(id), native.get_top_departments_under(id));
+        EXPECT_EQ(result_of([&]() { return qt.get_department_name(id, {"de_DE", "en_US"}); }),
+                  result_of([&]() { return native.get_department_name(id, {"de_DE", "en_US"}); }));
+        for (auto const& other: DEPARTMENTS)
+        {
+            EXPECT_EQ(qt.is_descendant_of_department(id, other), native.is_descendant_of_department(id, other)) << other;
+        }
+    }
+
+    for (auto const& pkg: PACKAGES)
+    {
+        SCOPED_TRACE(pkg);
+        EXPECT_EQ(qt.has_package(pkg), native.has_package(pkg));
+        EXPECT_EQ(result_of([&]() { return qt.get_department_for_package(pkg); }),
+                  result_of([&]() { return native.get_department_for_package(pkg); }));
+    }
+    EXPECT_EQ(qt.get_departments_for_packages(PACKAGES), native.get_departments_for_packages(PACKAGES));
+    EXPECT_EQ(qt.get_package_versions(), native.get_package_versions());
+    EXPECT_EQ(qt.get_meta("checkpoint."), native.get_meta("checkpoint."));
+    EXPECT_EQ(qt.department_mapping_count(), native.department_mapping_count());
+    EXPECT_EQ(qt.package_count(), native.package_count());
+    EXPECT_EQ(qt.department_name_count(), native.department_name_count());
+}
+
+TEST_F(NativeDepartmentsDbTest, rolledBackBulkLoadLeavesNoRows)
+{
+    NativeDepartmentsDb db(native_path);
+    fill(db);
+    auto const before = dump(native_path, "SELECT pkgid, deptid FROM pkgmap ORDER BY pkgid, deptid");
+
+    db.begin_bulk();
+    db.remove_all();
+    db.store_package_mapping("new-app", "games");
+    db.rollback_bulk();
+
+    EXPECT_EQ(before, dump(native_path, "SELECT pkgid, deptid FROM pkgmap ORDER BY pkgid, deptid"));
+    EXPECT_FALSE(db.has_package("new-app"));
+    EXPECT_TRUE(db.has_package("chess"));
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/request-scheduler.h>
+
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <algorithm>
+
+using namespace click;
+
+namespace
+{
+
+class RequestSchedulerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // QTimer needs an application, which all tests share
+        static int argc = 1;
+        static char name[] = "request-scheduler-test";
+        static char* argv[] = {name, nullptr};
+        static QCoreApplication app(argc, argv);
+
+        options.timeout = std::chrono::milliseconds(50);
+        options.backoff = std::chrono::milliseconds(1);
+        options.max_attempts = 3;
+    }
+
+    // Starts the scheduler and runs the event loop until it finished, or
+    // gives up after a few seconds.
+    bool run(RequestScheduler& scheduler)
+    {
+        QTimer::singleShot(0, [&scheduler]() {
+            scheduler.start();
+        });
+        QTimer::singleShot(5000, &loop, SLOT(quit()));
+        loop.exec();
+        return finished;
+    }
+
+    std::function<void()> on_finished()
+    {
+        return [this]() {
+            finished = true;
+            loop.quit();
+        };
+    }
+
+    RequestScheduler::Options options;
+    QEventLoop loop;
+    bool finished = false;
+};
+
+}
+
+TEST_F(RequestSchedulerTest, finishesRightAwayWithoutRequests)
+{
+    RequestScheduler scheduler(options, on_finished());
+    scheduler.start();
+    EXPECT_TRUE(finished);
+}
+
+TEST_F(RequestSchedulerTest, retriesFailedAttempts)
+{
+    RequestScheduler scheduler(options, on_finished());
+    unsigned attempts = 0;
+    scheduler.add("flaky", [&attempts](const RequestScheduler::Done& done) {
+        attempts++;
+        const bool succeeded = attempts == 2;
+        QTimer::singleShot(0, [done, succeeded]() {
+            done(succeeded);
+        });
+        return RequestScheduler::Cancel();
+    });
+    ASSERT_TRUE(run(scheduler));
+    EXPECT_EQ(2u, attempts);
+    EXPECT_EQ(0u, scheduler.failed_count());
+}
+
+TEST_F(RequestSchedulerTest, givesUpAfterMaxAttempts)
+{
+    RequestScheduler scheduler(options, on_finished());
+    unsigned attempts = 0;
+    scheduler.add("broken", [&attempts](const RequestScheduler::Done& done) {
+        attempts++;
+        done(false);
+        return RequestScheduler::Cancel();
+    });
+    ASSERT_TRUE(run(scheduler));
+    EXPECT_EQ(3u, attempts);
+    EXPECT_EQ(1u, scheduler.failed_count());
+}
+
+TEST_F(RequestSchedulerTest, cancelsAttemptsThatTimeOut)
+{
+    options.max_attempts = 2;
+    RequestScheduler scheduler(options, on_finished());
+    unsigned attempts = 0, cancelled = 0;
+    std::vector<RequestScheduler::Done> replies;
+    scheduler.add("slow", [&attempts, &cancelled, &replies](const RequestScheduler::Done& done) {
+        attempts++;
+        replies.push_back(done);
+        return [&cancelled]() {
+            cancelled++;
+        };
+    });
+    ASSERT_TRUE(run(scheduler));
+    EXPECT_EQ(2u, attempts);
+    EXPECT_EQ(2u, cancelled);
+    EXPECT_EQ(1u, scheduler.failed_count());
+
+    // replies to attempts that timed out are ignored
+    for (auto const& reply: replies)
+    {
+        reply(true);
+    }
+    EXPECT_EQ(1u, scheduler.failed_count());
+}
+
+TEST_F(RequestSchedulerTest, limitsRequestsInFlight)
+{
+    options.max_in_flight = 2;
+    RequestScheduler scheduler(options, on_finished());
+    unsigned in_flight = 0, max_in_flight = 0, attempts = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        scheduler.add("request " + std::to_string(i), [&](const RequestScheduler::Done& done) {
+            attempts++;
+            max_in_flight = std::max(max_in_flight, ++in_flight);
+            QTimer::singleShot(1, [done, &in_flight]() {
+                in_flight--;
+                done(true);
+            });
+            return RequestScheduler::Cancel();
+        });
+    }
+    ASSERT_TRUE(run(scheduler));
+    EXPECT_EQ(6u, attempts);
+    EXPECT_EQ(2u, max_in_flight);
+    EXPECT_EQ(0u, scheduler.failed_count());
+}
+
+TEST_F(RequestSchedulerTest, reportsProgressInTenths)
+{
+    RequestScheduler scheduler(options, on_finished());
+    std::vector<std::size_t> reported;
+    scheduler.set_progress_callback([&reported](const RequestScheduler::Progress& progress)
+    {
+        EXPECT_EQ(20u, progress.total);
+        reported.push_back(progress.done);
+    });
+    for (int i = 0; i < 20; i++)
+    {
+        scheduler.add("request " + std::to_string(i), [](const RequestScheduler::Done& done)
+        {
+            done(true);
+            return RequestScheduler::Cancel();
+        });
+    }
+    ASSERT_TRUE(run(scheduler));
+    const std::vector<std::size_t> expected {2, 4, 6, 8, 10, 12, 14, 16, 18, 20};
+    EXPECT_EQ(expected, reported);
+}
+
+TEST_F(RequestSchedulerTest, latencyPercentilesOfSucceededAttempts)
+{
+    RequestScheduler scheduler(options, on_finished());
+    EXPECT_EQ(0, scheduler.latency_percentile(50).count());
+    for (int i = 0; i < 4; i++)
+    {
+        scheduler.add("request " + std::to_string(i), [i](const RequestScheduler::Done& done)
+        {
+            QTimer::singleShot(10 * i, [done]()
+            {
+                done(true);
+            });
+            return RequestScheduler::Cancel();
+        });
+    }
+    ASSERT_TRUE(run(scheduler));
+    EXPECT_LE(scheduler.latency_percentile(25), scheduler.latency_percentile(50));
+    EXPECT_LE(scheduler.latency_percentile(50), scheduler.latency_percentile(100));
+    EXPECT_GE(scheduler.latency_percentile(100).count(), 30);
+}
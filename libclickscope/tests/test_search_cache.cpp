@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/search-cache.h>
+
+#include <gtest/gtest.h>
+
+using namespace click;
+
+namespace
+{
+
+typedef SearchCache::Apps Apps;
+
+Application app(const std::string& name)
+{
+    Application a;
+    a.name = name;
+    a.title = name;
+    a.search_title = name;
+    return a;
+}
+
+std::shared_ptr<const Apps> apps(const std::vector<std::string>& names)
+{
+    std::shared_ptr<Apps> result(new Apps());
+    for (auto const& name: names)
+    {
+        result->push_back(app(name));
+    }
+    return result;
+}
+
+std::vector<std::string> names(const std::shared_ptr<const Apps>& apps)
+{
+    std::vector<std::string> result;
+    for (auto const& a: *apps)
+    {
+        result.push_back(a.name);
+    }
+    return result;
+}
+
+const std::vector<std::string> no_ignored_apps;
+
+}
+
+TEST(SearchCache, findsStoredResults)
+{
+    SearchCache cache;
+    const auto stored = apps({"camera", "calendar"});
+    cache.store(1, 1, no_ignored_apps, "", "ca", stored);
+    EXPECT_EQ(stored, cache.find(1, 1, no_ignored_apps, "", "ca"));
+    EXPECT_EQ(nullptr, cache.find(1, 1, no_ignored_apps, "other", "ca"));
+    EXPECT_EQ(nullptr, cache.find(1, 1, no_ignored_apps, "", "x"));
+}
+
+TEST(SearchCache, refinesEarlierQuery)
+{
+    SearchCache cache;
+    cache.store(1, 1, no_ignored_apps, "", "ca", apps({"calendar", "camera", "calculator"}));
+    auto refined = cache.find(1, 1, no_ignored_apps, "", "cal");
+    ASSERT_NE(nullptr, refined);
+    EXPECT_EQ(std::vector<std::string>({"calendar", "calculator"}), names(refined));
+}
+
+TEST(SearchCache, emptyQueryIsNotRefined)
+{
+    SearchCache cache;
+    cache.store(1, 1, no_ignored_apps, "", "ca", apps({"camera"}));
+    EXPECT_EQ(nullptr, cache.find(1, 1, no_ignored_apps, "", ""));
+}
+
+TEST(SearchCache, catalogChangeInvalidates)
+{
+    SearchCache cache;
+    cache.store(1, 1, no_ignored_apps, "", "ca", apps({"camera"}));
+    EXPECT_EQ(nullptr, cache.find(2, 1, no_ignored_apps, "", "ca"));
+    EXPECT_EQ(nullptr, cache.find(2, 1, no_ignored_apps, "", "cam"));
+}
+
+TEST(SearchCache, departmentsChangeInvalidates)
+{
+    SearchCache cache;
+    cache.store(1, 1, no_ignored_apps, "", "ca", apps({"camera"}));
+    EXPECT_EQ(nullptr, cache.find(1, 2, no_ignored_apps, "", "ca"));
+}
+
+TEST(SearchCache, ignoredAppsChangeInvalidates)
+{
+    SearchCache cache;
+    cache.store(1, 1, no_ignored_apps, "", "ca", apps({"camera"}));
+    EXPECT_EQ(nullptr, cache.find(1, 1, {"camera"}, "", "ca"));
+}
+
+TEST(SearchCache, staleGenerationsAreIgnored)
+{
+    SearchCache cache;
+    const auto current = apps({"camera"});
+    cache.store(2, 2, no_ignored_apps, "", "ca", current);
+
+    // results of an older catalog or database are neither returned nor
+    // stored, and don't drop the current ones
+    EXPECT_EQ(nullptr, cache.find(1, 2, no_ignored_apps, "", "ca"));
+    EXPECT_EQ(nullptr, cache.find(2, 1, no_ignored_apps, "", "ca"));
+    cache.store(1, 2, no_ignored_apps, "", "ca", apps({"old"}));
+    cache.store(2, 1, no_ignored_apps, "", "ca", apps({"old"}));
+    EXPECT_EQ(current, cache.find(2, 2, no_ignored_apps, "", "ca"));
+}
+
+TEST(SearchCache, capacityIsBounded)
+{
+    SearchCache cache(2);
+    cache.store(1, 1, no_ignored_apps, "", "a", apps({"a"}));
+    cache.store(1, 1, no_ignored_apps, "", "b", apps({"b"}));
+    ASSERT_NE(nullptr, cache.find(1, 1, no_ignored_apps, "", "a"));
+    cache.store(1, 1, no_ignored_apps, "", "c", apps({"c"}));
+    // b was used least recently
+    EXPECT_EQ(nullptr, cache.find(1, 1, no_ignored_apps, "", "b"));
+    EXPECT_NE(nullptr, cache.find(1, 1, no_ignored_apps, "", "a"));
+    EXPECT_NE(nullptr, cache.find(1, 1, no_ignored_apps, "", "c"));
+}
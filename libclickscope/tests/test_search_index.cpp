@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/desktop-entry.h>
+#include <click/search-index.h>
+#include <click/search-keys.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace click;
+
+namespace
+{
+
+typedef std::vector<SearchIndex::Position> Positions;
+
+DesktopEntry entry(const std::string& search_name, const std::vector<std::string>& search_keywords = {})
+{
+    DesktopEntry e;
+    e.search_name = search_name;
+    e.search_keywords = search_keywords;
+    return e;
+}
+
+std::vector<DesktopEntry> entries()
+{
+    return {
+        entry("terminal", {"shell", "console"}),
+        entry("camera"),
+        entry("calendar", {"events"}),
+        entry("", {"hidden"}),
+        entry("music", {"player"}),
+    };
+}
+
+bool matches(const DesktopEntry& e, const std::string& query)
+{
+    if (search_key_contains(e.search_name, query))
+    {
+        return true;
+    }
+    return std::any_of(e.search_keywords.begin(), e.search_keywords.end(), [&query](const std::string& key) {
+        return search_key_contains(key, query);
+    });
+}
+
+}
+
+TEST(SearchIndex, emptyIndexHasNoCandidates)
+{
+    SearchIndex index;
+    EXPECT_EQ(0u, index.size());
+    EXPECT_EQ(Positions(), index.candidates(""));
+    EXPECT_EQ(Positions(), index.candidates("a"));
+    EXPECT_EQ(Positions(), index.candidates("abc"));
+}
+
+TEST(SearchIndex, emptyQueryReturnsEverything)
+{
+    SearchIndex index(entries());
+    EXPECT_EQ(5u, index.size());
+    EXPECT_EQ(Positions({0, 1, 2, 3, 4}), index.candidates(""));
+}
+
+TEST(SearchIndex, shortQueriesUseSubstrings)
+{
+    SearchIndex index(entries());
+    EXPECT_EQ(Positions({0, 1, 2, 3, 4}), index.candidates("e"));
+    EXPECT_EQ(Positions({1, 2}), index.candidates("ca"));
+    EXPECT_EQ(Positions({4}), index.candidates("pl"));
+    EXPECT_EQ(Positions(), index.candidates("zz"));
+}
+
+TEST(SearchIndex, longQueriesIntersectTrigrams)
+{
+    SearchIndex index(entries());
+    EXPECT_EQ(Positions({2}), index.candidates("cal"));
+    EXPECT_EQ(Positions({2}), index.candidates("calendar"));
+    EXPECT_EQ(Positions({0}), index.candidates("console"));
+    EXPECT_EQ(Positions({3}), index.candidates("hidden"));
+    EXPECT_EQ(Positions(), index.candidates("calendars"));
+    EXPECT_EQ(Positions(), index.candidates("xyz"));
+    // every trigram occurs, but never all of them in one entry
+    EXPECT_EQ(Positions(), index.candidates("terame"));
+}
+
+TEST(SearchIndex, noMatchIsLeftOut)
+{
+    const auto indexed = entries();
+    SearchIndex index(indexed);
+    for (auto const& e: indexed)
+    {
+        std::vector<std::string> keys = e.search_keywords;
+        keys.push_back(e.search_name);
+        for (auto const& key: keys)
+        {
+            for (std::size_t start = 0; start < key.size(); start++)
+            {
+                for (std::size_t length = 1; start + length <= key.size(); length++)
+                {
+                    const auto query = key.substr(start, length);
+                    const auto candidates = index.candidates(query);
+                    EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+                    for (std::size_t i = 0; i < indexed.size(); i++)
+                    {
+                        if (matches(indexed[i], query))
+                        {
+                            EXPECT_TRUE(std::binary_search(candidates.begin(), candidates.end(), i))
+                                << "query " << query << " misses entry " << i;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
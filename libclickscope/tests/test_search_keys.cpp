@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/search-keys.h>
+
+#include <gtest/gtest.h>
+
+using namespace click;
+
+TEST(SearchKeys, keyIsCaseFolded)
+{
+    EXPECT_EQ("terminal", search_key("Terminal"));
+    EXPECT_EQ("terminal", search_key("TERMINAL"));
+}
+
+TEST(SearchKeys, keyStripsDiacritics)
+{
+    EXPECT_EQ("cafe", search_key("Café"));
+    EXPECT_EQ("ecole", search_key("École"));
+    EXPECT_EQ("uber", search_key("über"));
+}
+
+TEST(SearchKeys, keysKeepOrder)
+{
+    EXPECT_EQ(std::vector<std::string>({"one", "two", ""}), search_keys({"One", "TWO", ""}));
+}
+
+TEST(SearchKeys, queryMatchesSubstringOfKey)
+{
+    const auto key = search_key("Café Finder");
+    EXPECT_TRUE(search_key_contains(key, search_key("cafe")));
+    EXPECT_TRUE(search_key_contains(key, search_key("FINDER")));
+    EXPECT_TRUE(search_key_contains(key, search_key("é f")));
+    EXPECT_FALSE(search_key_contains(key, search_key("finders")));
+}
+
+TEST(SearchKeys, emptyKeyNeverMatches)
+{
+    EXPECT_FALSE(search_key_contains("", ""));
+    EXPECT_FALSE(search_key_contains("", "a"));
+    EXPECT_TRUE(search_key_contains("a", ""));
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 UBports Foundation.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3, as published
+ * by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranties of
+ * MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+
+#include <click/thread-connections.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace click;
+
+namespace
+{
+
+struct Connection
+{
+    explicit Connection(std::atomic<int>& open)
+        : open(open)
+    {
+        open++;
+    }
+    ~Connection()
+    {
+        open--;
+    }
+
+    std::atomic<int>& open;
+};
+
+}
+
+TEST(ThreadConnections, threadsHaveConnectionsOfTheirOwn)
+{
+    std::atomic<int> open(0);
+    ThreadConnections<Connection> connections;
+    EXPECT_EQ(nullptr, connections.find());
+    auto& own = connections.add(std::make_shared<Connection>(open));
+    EXPECT_EQ(&own, connections.find());
+
+    std::thread([&connections, &open]() {
+        EXPECT_EQ(nullptr, connections.find());
+        connections.add(std::make_shared<Connection>(open));
+        EXPECT_NE(nullptr, connections.find());
+        EXPECT_EQ(2, open.load());
+    }).join();
+
+    // closed when the thread exited
+    EXPECT_EQ(1, open.load());
+    EXPECT_EQ(&own, connections.find());
+    connections.release();
+    EXPECT_EQ(0, open.load());
+    EXPECT_EQ(nullptr, connections.find());
+}
+
+TEST(ThreadConnections, connectionsOfDestroyedOwnersAreClosed)
+{
+    std::atomic<int> open(0);
+    {
+        ThreadConnections<Connection> connections;
+        connections.add(std::make_shared<Connection>(open));
+    }
+    EXPECT_EQ(1, open.load());
+
+    // the next lookup of the thread closes it, and a new owner never
+    // gets it, even at the same address
+    ThreadConnections<Connection> connections;
+    EXPECT_EQ(nullptr, connections.find());
+    EXPECT_EQ(0, open.load());
+}
+
+TEST(ThreadConnections, ownersAreSeparate)
+{
+    std::atomic<int> open(0);
+    ThreadConnections<Connection> first, second;
+    auto& a = first.add(std::make_shared<Connection>(open));
+    auto& b = second.add(std::make_shared<Connection>(open));
+    EXPECT_EQ(&a, first.find());
+    EXPECT_EQ(&b, second.find());
+    first.release();
+    EXPECT_EQ(nullptr, first.find());
+    EXPECT_EQ(&b, second.find());
+    second.release();
+    EXPECT_EQ(0, open.load());
+}
@@ -28,7 +28,10 @@
  */
 
 #include <click/application.h>
+#include <click/application-catalog.h>
+#include <click/department-facets.h>
 #include <click/departments-db.h>
+#include <click/search-cache.h>
 
 #include <click/key_file_locator.h>
 
@@ -39,6 +42,7 @@
 #include <unity/scopes/SearchMetadata.h>
 #include <unity/scopes/Department.h>
 
+#include <atomic>
 #include <vector>
 #include <locale>
 
@@ -49,6 +53,10 @@
 namespace
 {
 
+std::atomic<std::uint64_t> aborted_queries(0);
+// the first query that reads the departments db logs how long it took
+std::atomic<bool> first_departments_query(true);
+
 static const std::string CATEGORY_APPS_DISPLAY = R"(
     {
         "schema-version" : 1,
@@ -72,7 +80,8 @@ static const std::string CATEGORY_APPS_DISPLAY = R"(
 }
 
 click::apps::ResultPusher::ResultPusher(const scopes::SearchReplyProxy &replyProxy, const std::vector<std::string>& apps)
-    :  replyProxy(replyProxy)
+    :  replyProxy(replyProxy),
+       created(std::chrono::steady_clock::now())
 {
     for (auto const& app: apps)
     {
@@ -107,7 +116,31 @@ void click::apps::ResultPusher::push_result(scopes::Category::SCPtr& cat, const
     res[click::apps::Query::ResultKeys::INSTALLED] = true;
     res[click::apps::Query::ResultKeys::VERSION] = a.version;
     res["lonely_result"] = lonely_result;
+    if (!pushed_any)
+    {
+        first_push = std::chrono::steady_clock::now();
+        pushed_any = true;
+    }
     replyProxy->push(res);
+    last_push = std::chrono::steady_clock::now();
+}
+
+long click::apps::ResultPusher::first_result_ms() const
+{
+    if (!pushed_any)
+    {
+        return -1;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(first_push - created).count();
+}
+
+long click::apps::ResultPusher::last_result_ms() const
+{
+    if (!pushed_any)
+    {
+        return -1;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(last_push - created).count();
 }
 
 //
@@ -200,35 +233,147 @@ void click::apps::ResultPusher::push_top_results(
     }
 }
 
+void click::apps::ResultPusher::begin_stream(const std::string& categoryTemplate, bool show_top, bool show_title)
+{
+    const scopes::CategoryRenderer rdr(categoryTemplate);
+    if (show_top)
+    {
+        top_category = replyProxy->register_category("predefined", "", "", rdr);
+    }
+    local_category = replyProxy->register_category("local", show_title ? _("Apps") : "", "", rdr);
+}
+
+void click::apps::ResultPusher::push_streamed(const click::Application& app)
+{
+    if (++streamed_count == 2 && !held_back.empty())
+    {
+        push_result(local_category, held_back.front(), false);
+        held_back.clear();
+    }
+
+    try
+    {
+        const auto id = get_app_identifier(app);
+        if (top_apps_lookup.find(id) != top_apps_lookup.end())
+        {
+            if (top_category)
+            {
+                top_apps_found[id] = app;
+                push_found_top_apps(false);
+            }
+            return;
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        qWarning() << QString::fromStdString(e.what());
+        return;
+    }
+
+    if (streamed_count == 1)
+    {
+        held_back.push_back(app);
+    }
+    else
+    {
+        push_result(local_category, app, false);
+    }
+}
+
+void click::apps::ResultPusher::end_stream()
+{
+    if (!held_back.empty())
+    {
+        push_result(local_category, held_back.front(), streamed_count == 1);
+        held_back.clear();
+    }
+    if (top_category)
+    {
+        push_found_top_apps(true);
+    }
+}
+
+//
+// push core apps in the order of core_apps; unless all is set, stop at the
+// first one that hasn't been seen yet, as it may still come.
+void click::apps::ResultPusher::push_found_top_apps(bool all)
+{
+    for (; next_top_app < core_apps.size(); next_top_app++)
+    {
+        auto const it = top_apps_found.find(core_apps[next_top_app]);
+        if (it != top_apps_found.end())
+        {
+            push_result(top_category, it->second);
+        }
+        else if (!all)
+        {
+            break;
+        }
+    }
+}
+
 struct click::apps::Query::Private
 {
     Private(std::shared_ptr<click::DepartmentsDb> depts_db,
             const scopes::SearchMetadata& metadata,
-            std::shared_future<void> const& qt_ready)
+            std::shared_future<void> const& qt_ready,
+            QSharedPointer<click::ApplicationCatalog> const& catalog,
+            std::shared_ptr<click::SearchCache> const& search_cache)
         : depts_db(depts_db),
           meta(metadata),
-          qt_ready_(qt_ready)
+          qt_ready_(qt_ready),
+          catalog(catalog),
+          catalog_iface(catalog),
+          search_cache(search_cache)
+    {
+    }
+
+    // true if the search was cancelled; counts it as aborted the first time
+    bool aborted()
     {
+        if (!cancellation.is_cancelled())
+        {
+            return false;
+        }
+        if (!abort_counted)
+        {
+            abort_counted = true;
+            qDebug() << "search aborted," << ++aborted_queries << "aborted so far";
+        }
+        return true;
     }
 
     std::shared_ptr<click::DepartmentsDb> depts_db;
     scopes::SearchMetadata meta;
     click::Configuration configuration;
     std::shared_future<void> qt_ready_;
+    QSharedPointer<click::ApplicationCatalog> catalog;
+    click::Interface catalog_iface;
+    std::shared_ptr<click::SearchCache> search_cache;
+    click::CancellationToken cancellation;
+    bool abort_counted = false;
 };
 
 click::apps::Query::Query(unity::scopes::CannedQuery const& query,
                           std::shared_ptr<DepartmentsDb> depts_db,
                           scopes::SearchMetadata const& metadata,
-                          std::shared_future<void> const& qt_ready)
+                          std::shared_future<void> const& qt_ready,
+                          QSharedPointer<ApplicationCatalog> const& catalog,
+                          std::shared_ptr<SearchCache> const& search_cache)
     : unity::scopes::SearchQueryBase(query, metadata),
-      impl(new Private(depts_db, metadata, qt_ready))
+      impl(new Private(depts_db, metadata, qt_ready, catalog, search_cache))
 {
 }
 
 void click::apps::Query::cancelled()
 {
     qDebug() << "cancelling search of" << QString::fromStdString(query().query_string());
+    impl->cancellation.cancel();
+}
+
+std::uint64_t click::apps::Query::aborted_count()
+{
+    return aborted_queries;
 }
 
 click::apps::Query::~Query()
@@ -238,6 +383,11 @@ click::apps::Query::~Query()
 
 click::Interface& click::apps::Query::clickInterfaceInstance()
 {
+    // search the scope's application catalog if there is one, instead of scanning the filesystem
+    if (impl->catalog) {
+        return impl->catalog_iface;
+    }
+
     static QSharedPointer<click::KeyFileLocator> keyFileLocator(new click::KeyFileLocator());
     static click::Interface iface(keyFileLocator);
 
@@ -246,20 +396,10 @@ click::Interface& click::apps::Query::clickInterfaceInstance()
 
 void click::apps::Query::push_local_departments(scopes::SearchReplyProxy const& replyProxy, const std::vector<Application>& apps)
 {
+    auto const started = std::chrono::steady_clock::now();
     auto const current_dep_id = query().department_id();
     const std::list<std::string> locales = { search_metadata().locale(), "en_US" };
 
-    //
-    // create helper lookup of all departments of currently installed apps.
-    // note that apps that are passed here are supposed to be already filterd by current department
-    // that means we only have subdepartments of current department (or subdepartment(s) of subdepartment(s)
-    // and so on of current department, as the hierarchy may be of arbitrary depth.
-    std::unordered_set<std::string> all_subdepartments;
-    for (auto const app: apps)
-    {
-        all_subdepartments.insert(app.real_department);
-    }
-
     unity::scopes::Department::SPtr root;
 
     try
@@ -272,37 +412,27 @@ void click::apps::Query::push_local_departments(scopes::SearchReplyProxy const&
 
         unity::scopes::DepartmentList children;
 
+        //
+        // attribute every installed app to the subdepartment it's in.
+        // note that apps that are passed here are supposed to be already filterd by current department
+        // that means we only have subdepartments of current department (or subdepartment(s) of subdepartment(s)
+        // and so on of current department, as the hierarchy may be of arbitrary depth.
+        click::DepartmentFacets facets(*impl->depts_db, current_dep_id);
+        for (auto const& app: apps)
+        {
+            facets.add(app.real_department);
+        }
+
         // attach subdepartments to it
         for (auto const& subdep: impl->depts_db->get_children_departments(current_dep_id))
         {
-            //
-            // check if this subdepartment either directly matches a subdepartment of installed app,
-            // or is any of the departments of installed apps is a descendant of current subdepartment.
-            // the latter means we have app somewhere in the subtree of the current subdepartment, so it
-            // needs to be shown.
-            bool show_subdepartment = false;
-            auto it = all_subdepartments.find(subdep.id);
-            if (it != all_subdepartments.end())
+            if (impl->aborted())
             {
-                // subdepartment id matches directly one of the ids from all_subdepartments
-                show_subdepartment = true;
-                all_subdepartments.erase(it);
-            }
-            else
-            {
-                // no direct match - we need to check descendants of this subdepartment
-                // by querying the db
-                for (auto it = all_subdepartments.begin(); it != all_subdepartments.end(); it++)
-                {
-                    if (impl->depts_db->is_descendant_of_department(*it, subdep.id))
-                    {
-                        show_subdepartment = true;
-                        all_subdepartments.erase(it);
-                        break;
-                    }
-                }
+                return;
             }
 
+            // show the subdepartment if any of the installed apps is in its subtree
+            const bool show_subdepartment = facets.count(subdep.id) > 0;
             if (show_subdepartment)
             {
                 // if single supdepartment fails, then ignore it and continue with others
@@ -320,6 +450,11 @@ void click::apps::Query::push_local_departments(scopes::SearchReplyProxy const&
             }
         }
 
+        if (impl->aborted())
+        {
+            return;
+        }
+
         if (children.size() > 0)
         {
             const std::locale loc("");
@@ -343,6 +478,15 @@ void click::apps::Query::push_local_departments(scopes::SearchReplyProxy const&
         }
 
         replyProxy->register_departments(root);
+
+        // compare with CLICK_SCOPE_DEPARTMENTS_PROFILE=sqlite, or with a
+        // query that comes before the warm-up finished
+        if (first_departments_query.exchange(false))
+        {
+            auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            qDebug() << "first departments query took" << elapsed.count() << "ms,"
+                     << (impl->depts_db->warmed_up() ? "after" : "before") << "the warm-up finished";
+        }
     }
     catch (const std::exception& e)
     {
@@ -362,21 +506,86 @@ void click::apps::Query::run(scopes::SearchReplyProxy const& searchReply)
     const bool show_top_apps = querystr.empty() && current_dept.empty();
     ResultPusher pusher(searchReply, show_top_apps ? impl->configuration.get_core_apps() : std::vector<std::string>());
     auto const ignoredApps = impl->configuration.get_ignored_apps();
-    auto const localResults = clickInterfaceInstance().find_installed_apps(querystr, ignoredApps, current_dept, impl->depts_db);
 
-    if (impl->depts_db)
+    const bool show_cat_title = current_dept.empty() && querystr.empty();
+
+    // results of earlier queries are only reusable while the catalog and
+    // the departments they were computed from are unchanged, so caching
+    // needs the catalog
+    const bool use_cache = impl->search_cache && impl->catalog;
+    std::shared_ptr<const std::vector<Application>> cachedResults;
+    std::uint64_t generation = 0;
+    std::uint64_t depts_generation = 0;
+    if (use_cache)
     {
-        push_local_departments(searchReply, localResults);
+        generation = impl->catalog->generation();
+        depts_generation = impl->depts_db ? impl->depts_db->generation() : 0;
+        cachedResults = impl->search_cache->find(generation, depts_generation, ignoredApps, current_dept, querystr);
     }
 
-    if (show_top_apps)
+    if (!cachedResults && !impl->depts_db)
     {
-        pusher.push_top_results(localResults, categoryTemplate);
+        // without departments nothing has to be registered before the first
+        // result, so results are pushed while the search is still running
+        auto results = std::make_shared<std::vector<Application>>();
+        pusher.begin_stream(categoryTemplate, show_top_apps, show_cat_title);
+        clickInterfaceInstance().stream_installed_apps(querystr, ignoredApps, current_dept, impl->depts_db,
+                                                       [&pusher, &results](const Application& app) {
+            pusher.push_streamed(app);
+            results->push_back(app);
+        }, impl->cancellation);
+        if (impl->aborted())
+        {
+            return; // partial results must not end up in the cache
+        }
+        pusher.end_stream();
+        cachedResults = results;
+        if (use_cache)
+        {
+            impl->search_cache->store(generation, depts_generation, ignoredApps, current_dept, querystr, cachedResults);
+        }
     }
+    else
+    {
+        // departments have to be registered before the first result, and
+        // which ones to show depends on the complete result set
+        if (!cachedResults)
+        {
+            cachedResults = std::make_shared<std::vector<Application>>(
+                clickInterfaceInstance().find_installed_apps(querystr, ignoredApps, current_dept, impl->depts_db,
+                                                             impl->cancellation));
+            if (impl->aborted())
+            {
+                return;
+            }
+            if (use_cache)
+            {
+                impl->search_cache->store(generation, depts_generation, ignoredApps, current_dept, querystr, cachedResults);
+            }
+        }
+        auto const& localResults = *cachedResults;
 
-    const bool show_cat_title = current_dept.empty() && querystr.empty();
-    pusher.push_local_results(
-        localResults,
-        categoryTemplate,
-        show_cat_title);
+        if (impl->depts_db)
+        {
+            push_local_departments(searchReply, localResults);
+            if (impl->aborted())
+            {
+                return;
+            }
+        }
+
+        if (show_top_apps)
+        {
+            pusher.push_top_results(localResults, categoryTemplate);
+        }
+
+        pusher.push_local_results(
+            localResults,
+            categoryTemplate,
+            show_cat_title);
+    }
+
+    qDebug() << "search for" << QString::fromStdString(querystr) << "pushed first of"
+             << cachedResults->size() << "results after" << pusher.first_result_ms() << "ms, last after"
+             << pusher.last_result_ms() << "ms";
 }
@@ -36,6 +36,9 @@
 namespace scopes = unity::scopes;
 
 #include <QSharedPointer>
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <set>
 #include <unordered_set>
 #include <click/interface.h>
@@ -46,8 +49,10 @@ namespace click
 {
 
 class Application;
+class ApplicationCatalog;
 class Configuration;
 class DepartmentsDb;
+class SearchCache;
 
 namespace apps
 {
@@ -69,7 +74,9 @@ public:
     Query(unity::scopes::CannedQuery const& query,
           std::shared_ptr<DepartmentsDb> depts_db,
           scopes::SearchMetadata const& metadata,
-          std::shared_future<void> const& qt_ready = std::future<void>());
+          std::shared_future<void> const& qt_ready = std::future<void>(),
+          QSharedPointer<ApplicationCatalog> const& catalog = QSharedPointer<ApplicationCatalog>(),
+          std::shared_ptr<SearchCache> const& search_cache = std::shared_ptr<SearchCache>());
     virtual ~Query();
 
     virtual void cancelled() override;
@@ -78,6 +85,9 @@ public:
 
     virtual void push_local_departments(scopes::SearchReplyProxy const& replyProxy, const std::vector<Application>& apps);
 
+    // Number of searches that stopped early because they were cancelled.
+    static std::uint64_t aborted_count();
+
 protected:
     virtual click::Interface& clickInterfaceInstance();
 
@@ -92,6 +102,21 @@ class ResultPusher
     std::vector<std::string> core_apps;
     std::unordered_set<std::string> top_apps_lookup;
 
+    std::chrono::steady_clock::time_point created;
+    std::chrono::steady_clock::time_point first_push;
+    std::chrono::steady_clock::time_point last_push;
+    bool pushed_any = false;
+
+    // state of a stream, see begin_stream()
+    scopes::Category::SCPtr top_category;
+    scopes::Category::SCPtr local_category;
+    std::map<std::string, click::Application> top_apps_found;
+    std::size_t next_top_app = 0;
+    std::size_t streamed_count = 0;
+    std::vector<click::Application> held_back;
+
+    void push_found_top_apps(bool all);
+
 public:
     ResultPusher(const scopes::SearchReplyProxy &replyProxy, const std::vector<std::string>& core_apps);
     virtual ~ResultPusher() = default;
@@ -103,6 +128,22 @@ public:
     virtual void push_top_results(
             const std::vector<click::Application>& apps,
             const std::string& categoryTemplate);
+
+    // Streaming counterpart of push_top_results() and push_local_results(),
+    // for apps that arrive one at a time, already in their final order.
+    // Core apps are pushed as soon as the ones before them were seen, all
+    // others right away except for the first, which is held back until it
+    // is known whether it is a lonely result.
+    virtual void begin_stream(const std::string& categoryTemplate, bool show_top, bool show_title);
+    virtual void push_streamed(const click::Application& app);
+    virtual void end_stream();
+
+    // Milliseconds between creating the pusher and pushing its first or
+    // last result, or -1 if nothing was pushed. Without streaming the first
+    // result only comes when the last one is known, so the difference is
+    // what streaming saves.
+    long first_result_ms() const;
+    long last_result_ms() const;
 protected:
     virtual void push_result(scopes::Category::SCPtr& cat, const click::Application& a, bool lonely_result = false);
     static std::string get_app_identifier(const click::Application& app);
@@ -35,6 +35,8 @@
 #include <click/interface.h>
 #include <click/scope_activation.h>
 #include <click/departments-db.h>
+#include <click/application-catalog.h>
+#include <click/search-cache.h>
 
 #include <QSharedPointer>
 #include <QDebug>
@@ -55,11 +57,17 @@ click::Scope::Scope()
 
     try
     {
-        depts_db = click::DepartmentsDb::open(false);
+        depts_db = click::DepartmentsDb::open(false, true);
+        // the scope only reads the database, which init-departments writes
+        auto profile = depts_db->profile();
+        profile.query_only = true;
+        depts_db->set_profile(profile);
+        // the mapped copy of the database is picked up by the next start
+        depts_db->warm_up(true);
     }
     catch (const std::runtime_error& e)
     {
-        std::cerr << "Failed to open departments db: " << e.what() << std::endl;
+        qWarning() << "Failed to open departments db:" << e.what();
     }
 }
 
@@ -73,6 +81,11 @@ void click::Scope::start(std::string const&)
     bindtextdomain(GETTEXT_PACKAGE, GETTEXT_LOCALEDIR);
     bind_textdomain_codeset(GETTEXT_PACKAGE, "UTF-8");
     click::Date::setup_system_locale();
+
+    // build the catalog after setting up the locale, as it holds translated app names
+    catalog.reset(new click::ApplicationCatalog());
+    catalog->start();
+    search_cache = std::make_shared<click::SearchCache>();
 }
 
 void click::Scope::run()
@@ -89,12 +102,15 @@ void click::Scope::run()
 
 void click::Scope::stop()
 {
+    if (catalog) {
+        catalog->stop();
+    }
     qt::core::world::destroy();
 }
 
 scopes::SearchQueryBase::UPtr click::Scope::search(unity::scopes::CannedQuery const& q, scopes::SearchMetadata const& metadata)
 {
-    return scopes::SearchQueryBase::UPtr(new click::apps::Query(q, depts_db, metadata, qt_ready_for_search_f.share()));
+    return scopes::SearchQueryBase::UPtr(new click::apps::Query(q, depts_db, metadata, qt_ready_for_search_f.share(), catalog, search_cache));
 }
 
 
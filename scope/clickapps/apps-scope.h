@@ -35,6 +35,8 @@
 #include <unity/scopes/QueryBase.h>
 #include <unity/scopes/ActivationQueryBase.h>
 
+#include <QSharedPointer>
+
 #include <future>
 
 namespace scopes = unity::scopes;
@@ -42,7 +44,9 @@ namespace scopes = unity::scopes;
 namespace click
 {
 
+class ApplicationCatalog;
 class DepartmentsDb;
+class SearchCache;
 
 class Scope : public scopes::ScopeBase
 {
@@ -68,6 +72,8 @@ private:
     std::future<void> qt_ready_for_preview_f;
     //QSharedPointer<click::Index> index;
     std::shared_ptr<click::DepartmentsDb> depts_db;
+    QSharedPointer<click::ApplicationCatalog> catalog;
+    std::shared_ptr<click::SearchCache> search_cache;
 };
 }
 #endif // CLICK_SCOPE_H
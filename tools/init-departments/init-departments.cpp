@@ -34,8 +34,22 @@
 #include <click/network_access_manager.h>
 #include <click/qtbridge.h>
 #include <click/departments-db.h>
+#include <click/departments-import.h>
+#include <click/departments.h>
+#include <click/package.h>
+#include <click/request-scheduler.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
 #include <future>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <unistd.h>
 #include <QDebug>
 #include <QtGlobal>
 
@@ -50,6 +64,9 @@ enum
     // sqlite db errors
     DEPTS_ERROR_DB = 5,
 
+    // unreadable or invalid files in import mode
+    DEPTS_ERROR_IMPORT = 6,
+
     // click errors
     DEPTS_ERROR_CLICK_PARSE = 10,
     DEPTS_ERROR_CLICK_CALL = 11,
@@ -70,16 +87,182 @@ click::Interface iface(keyFileLocator);
 
 void noDebug(QtMsgType, const QMessageLogContext&, const QString&) {}
 
+//
+// full runs record their progress in the meta table as they go, so that a run
+// that gets killed (it competes with unity8 at session start) is resumed by
+// the next run with the same locales instead of starting over:
+// checkpoint.run holds the id of the run, checkpoint.locales its locales,
+// checkpoint.locale.LOCALE marks a locale whose departments were stored, and
+// checkpoint.package.NAME holds the version of a package whose mapping was.
+// The rows are removed once a run completed without errors.
+static const std::string CHECKPOINT_PREFIX("checkpoint.");
+static const std::string CHECKPOINT_RUN("checkpoint.run");
+static const std::string CHECKPOINT_LOCALES("checkpoint.locales");
+static const std::string CHECKPOINT_LOCALE("checkpoint.locale.");
+static const std::string CHECKPOINT_PACKAGE("checkpoint.package.");
+
+// package mappings are committed in batches of this size while details arrive
+static const std::size_t CHECKPOINT_INTERVAL = 16;
+
+struct Checkpoint
+{
+    std::string run_id;
+    // locales and packages (with their version) completed by the run
+    std::set<std::string> locales;
+    std::unordered_map<std::string, std::string> packages;
+};
+
+template <typename Store>
+void store_atomically(click::DepartmentsDb& db, Store store)
+{
+    db.begin_bulk();
+    try
+    {
+        store();
+    }
+    catch (...)
+    {
+        db.rollback_bulk();
+        throw;
+    }
+    db.commit_bulk();
+}
+
+// Checkpoint of an interrupted run with the same locales, or a new run.
+Checkpoint resume_or_start_run(click::DepartmentsDb& db, const std::set<std::string>& locales)
+{
+    std::string run_locales;
+    for (auto const& locale: locales)
+    {
+        run_locales += (run_locales.empty() ? "" : " ") + locale;
+    }
+
+    Checkpoint checkpoint;
+    auto const meta = db.get_meta(CHECKPOINT_PREFIX);
+    auto const run = meta.find(CHECKPOINT_RUN);
+    auto const previous_locales = meta.find(CHECKPOINT_LOCALES);
+    if (run != meta.end() && previous_locales != meta.end() && previous_locales->second == run_locales)
+    {
+        checkpoint.run_id = run->second;
+        for (auto const& value: meta)
+        {
+            if (value.first.compare(0, CHECKPOINT_LOCALE.size(), CHECKPOINT_LOCALE) == 0)
+            {
+                checkpoint.locales.insert(value.first.substr(CHECKPOINT_LOCALE.size()));
+            }
+            else if (value.first.compare(0, CHECKPOINT_PACKAGE.size(), CHECKPOINT_PACKAGE) == 0)
+            {
+                checkpoint.packages[value.first.substr(CHECKPOINT_PACKAGE.size())] = value.second;
+            }
+        }
+        std::cout << "Resuming run " << checkpoint.run_id << ": " << checkpoint.locales.size() << " locales and "
+                  << checkpoint.packages.size() << " packages already done" << std::endl;
+        return checkpoint;
+    }
+
+    checkpoint.run_id = std::to_string(std::time(nullptr)) + "-" + std::to_string(getpid());
+    store_atomically(db, [&db, &checkpoint, &run_locales]() {
+        db.remove_meta(CHECKPOINT_PREFIX);
+        db.store_meta(CHECKPOINT_RUN, checkpoint.run_id);
+        db.store_meta(CHECKPOINT_LOCALES, run_locales);
+    });
+    return checkpoint;
+}
+
+//
+// stores package mappings with the versions of the packages; must be called
+// within a bulk load. Full runs (run_id set) also record them as completed.
+void store_mappings(click::DepartmentsDb& db,
+                    const std::vector<std::pair<std::string, std::string>>& mappings,
+                    const std::unordered_map<std::string, std::string>& versions,
+                    const std::string& run_id)
+{
+    db.store_package_mappings(mappings);
+    for (auto const& mapping: mappings)
+    {
+        auto const version = versions.find(mapping.first);
+        if (version == versions.end())
+        {
+            continue;
+        }
+        db.store_package_version(mapping.first, version->second);
+        if (!run_id.empty())
+        {
+            db.store_meta(CHECKPOINT_PACKAGE + mapping.first, version->second);
+        }
+    }
+}
+
+//
+// fills the database from responses saved in dir instead of the network, see
+// click::import_departments()
+int import_dumps(click::DepartmentsDb& db, const std::string& dir)
+{
+    click::DepartmentsImportStats stats;
+    try
+    {
+        stats = click::import_departments(db, dir, NON_CLICK_APPS);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to update departments database: " << e.what() << std::endl;
+        return DEPTS_ERROR_DB;
+    }
+    if (stats.locales == 0)
+    {
+        std::cerr << "No valid departments found in " << dir << "/departments" << std::endl;
+        return DEPTS_ERROR_IMPORT;
+    }
+
+    const std::size_t files = stats.locales + stats.packages + stats.invalid_files;
+    const auto total = stats.parse_time + stats.store_time;
+    std::cout << "Imported " << stats.locales << " locales and " << stats.packages << " packages: "
+              << "parsed in " << stats.parse_time.count() << " ms, stored in " << stats.store_time.count() << " ms ("
+              << files * 1000 / std::max<long>(total.count(), 1) << " files/s)" << std::endl;
+    return stats.invalid_files == 0 ? 0 : DEPTS_ERROR_IMPORT;
+}
+
+void print_summary(click::DepartmentsDb& db)
+{
+    std::cout << std::endl << "Summary:" << std::endl
+        << "Number of department mappings: " << db.department_mapping_count() << std::endl
+        << "Number of department names (all locales): " << db.department_name_count() << std::endl
+        << "Number of applications: " << db.package_count() << std::endl;
+}
+
+//
+// writes the read-only copy for the scope once the database is closed, as
+// closing it checkpoints the WAL and so touches the database file
+bool write_mapped_file(std::unique_ptr<click::DepartmentsDb> db, const std::string& dbfile)
+{
+    db.reset();
+    const std::string mapped_file = click::DepartmentsDb::mapped_path(dbfile);
+    try
+    {
+        click::DepartmentsDb(dbfile, false).export_mapped(mapped_file);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to write " << mapped_file << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char **argv)
 {
-    if (argc < 3)
+    // import mode reads saved responses instead of using the network
+    const bool import_mode = argc > 1 && strcmp(argv[1], "--import") == 0;
+    const int first_arg = import_mode ? 3 : 1;
+    if (import_mode ? argc != first_arg + 1 : argc < 3)
     {
-        std::cerr << "Usage: " << argv[0] << " DBFILE LOCALE1 [LOCALE2 ...]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " DBFILE LOCALE1 [LOCALE2 ...]" << std::endl
+                  << "       " << argv[0] << " --import DIR DBFILE" << std::endl;
         return DEPTS_ERROR_ARG;
     }
 
-    const std::string dbfile(argv[1]);
-    const std::set<std::string> locales(argv + 2, argv + argc);
+    const std::string dbfile(argv[first_arg]);
+    const std::set<std::string> locales(argv + first_arg + 1, argv + argc);
 
     if (!getenv("INIT_DEPARTMENTS_DEBUG"))
         qInstallMessageHandler(noDebug);
@@ -87,7 +270,9 @@ int main(int argc, char **argv)
     std::unique_ptr<click::DepartmentsDb> db;
     try
     {
-        db.reset(new click::DepartmentsDb(dbfile));
+        // the database itself is read, never the mapped copy of it, which
+        // may not be current
+        db = click::DepartmentsDb::open_file(dbfile);
     }
     catch (const std::exception &e)
     {
@@ -95,6 +280,32 @@ int main(int argc, char **argv)
         return DEPTS_ERROR_DB;
     }
 
+    if (import_mode)
+    {
+        const int result = import_dumps(*db, argv[2]);
+        if (result == DEPTS_ERROR_DB)
+        {
+            return result;
+        }
+        print_summary(*db);
+        return write_mapped_file(std::move(db), dbfile) ? result : DEPTS_ERROR_DB;
+    }
+
+    Checkpoint checkpoint;
+    try
+    {
+        checkpoint = resume_or_start_run(*db, locales);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to read checkpoint: " << e.what() << std::endl;
+        return DEPTS_ERROR_DB;
+    }
+    std::set<std::string> pending_locales;
+    std::set_difference(locales.begin(), locales.end(),
+                        checkpoint.locales.begin(), checkpoint.locales.end(),
+                        std::inserter(pending_locales, pending_locales.end()));
+
     auto nam = QSharedPointer<click::network::AccessManager>(new click::network::AccessManager());
     auto client = QSharedPointer<click::web::Client>(new click::web::Client(nam));
     click::Index index(client);
@@ -108,27 +319,47 @@ int main(int argc, char **argv)
     auto pkgs_ft = pkgs_ready.get_future();
 
     std::atomic<int> return_val(0);
-    std::atomic<std::vector<std::string>::size_type> num_of_locales(locales.size());
+    std::atomic<std::vector<std::string>::size_type> num_of_locales(pending_locales.size());
     std::atomic<click::PackageSet::size_type> num_of_pkgs(0);
 
+    // package mappings are collected here and committed in batches; the
+    // ones left are stored at the end, as are all of them if a batch failed
+    std::mutex mappings_mutex;
+    std::vector<std::pair<std::string, std::string>> mappings;
+    std::size_t stored_mappings = 0;
+    bool batches_failed = false;
+
+    // versions of the installed packages, filled once click listed them
+    bool packages_listed = false;
+    std::unordered_map<std::string, std::string> installed_versions;
+
     //
     // a thread that does bootstrap request
     std::thread net_thread([&]() {
         qt_ready_ft.get();
 
-        for (auto const locale: locales)
+        if (pending_locales.empty())
+        {
+            bootstrap_ready.set_value();
+            return;
+        }
+
+        for (auto const locale: pending_locales)
         {
-            qt::core::world::enter_with_task([&return_val, &bootstrap_ready, &index, &cnc, &num_of_locales, &db, locale]() {
+            qt::core::world::enter_with_task([&return_val, &bootstrap_ready, &index, &cnc, &num_of_locales, &db, &checkpoint, locale]() {
 
                 std::cout << "Getting departments for locale '" << locale << "'" << std::endl;
-                cnc.push_back(index.bootstrap([&return_val, &bootstrap_ready, &num_of_locales, &db, locale](const click::DepartmentList& depts, const click::HighlightList&, click::Index::Error error, int) {
+                cnc.push_back(index.bootstrap([&return_val, &bootstrap_ready, &num_of_locales, &db, &checkpoint, locale](const click::DepartmentList& depts, const click::HighlightList&, click::Index::Error error, int) {
                     std::cout << "Bootstrap call for locale '" << locale << "' finished" << std::endl;
 
                     if (error == click::Index::Error::NoError)
                     {
                         try
                         {
-                            db->store_departments(depts, locale);
+                            store_atomically(*db, [&db, &checkpoint, &depts, &locale]() {
+                                db->store_departments(depts, locale);
+                                db->store_meta(CHECKPOINT_LOCALE + locale, checkpoint.run_id);
+                            });
                             std::cout << "Stored departments for locale '" << locale << "'" << std::endl;
                         }
                         catch (const std::exception& e)
@@ -156,64 +387,115 @@ int main(int argc, char **argv)
         }
     });
 
+    click::RequestScheduler scheduler(click::RequestScheduler::Options::from_env(), []() {
+        std::cout << "All packages processed" << std::endl;
+        qt::core::world::destroy();
+    });
+    scheduler.set_progress_callback([](const click::RequestScheduler::Progress& progress) {
+        std::cout << "Processed " << progress.done << " of " << progress.total << " requests ("
+                  << progress.failed << " failed, " << progress.in_flight << " in flight)" << std::endl;
+    });
+
     //
     // a thread that iterates over all packages and performs details requests
     // it initially blocks on bootstrap_ft and pkgs_ft future
     // (waits until bootstrap finished and main thread gets all the click packages)
     std::thread details_thread([&]() {
         bootstrap_ft.get();
-        auto const pkgs = pkgs_ft.get();
+        auto const installed = pkgs_ft.get();
+
+        // if click list failed, then end this thread and stop Qt bridge
+        if (return_val != 0)
+        {
+            std::cerr << "An error occurred, not fetching departments" << std::endl;
+            qt::core::world::destroy();
+            return;
+        }
+
+        packages_listed = true;
+        click::PackageSet pkgs;
+        for (auto const& pkg: installed)
+        {
+            installed_versions[pkg.name] = pkg.version;
+            // packages already stored by this run before it was cut short
+            auto const stored = checkpoint.packages.find(pkg.name);
+            if (stored == checkpoint.packages.end() || stored->second != pkg.version)
+            {
+                pkgs.insert(pkg);
+            }
+        }
 
         num_of_pkgs = pkgs.size();
 
-        // if click list failed or nothing to do, then end this thread and stop Qt bridge
-        if (return_val != 0 || num_of_pkgs == 0)
+        // if nothing to do, then end this thread and stop Qt bridge
+        if (num_of_pkgs == 0)
         {
-            std::cerr << "No packages to process or an error occurred, not fetching departments" << std::endl;
+            std::cerr << "No packages to process, not fetching departments" << std::endl;
             qt::core::world::destroy();
             return;
         }
 
-            std::cout << "Getting package details for " << num_of_pkgs << " packages" << std::endl;
+        std::cout << "Getting package details for " << num_of_pkgs << " packages" << std::endl;
 
-            //
-            // note: this queues requests for all the packages; the number of packages to process
-            // is kept in num_of_pkgs which gets decreased, the last processed package will stop Qt bridge.
+        // commits the collected mappings; called with mappings_mutex held
+        auto store_batch = [&]() {
+            try
+            {
+                store_atomically(*db, [&]() {
+                    store_mappings(*db, mappings, installed_versions, checkpoint.run_id);
+                });
+                stored_mappings += mappings.size();
+                mappings.clear();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Failed to store package departments, storing them at the end: " << e.what() << std::endl;
+                batches_failed = true;
+            }
+        };
+
+        //
+        // note: the scheduler keeps a limited number of details requests in flight, and
+        // stops Qt bridge once the last package was processed.
+        qt::core::world::enter_with_task([&return_val, &index, &scheduler, pkgs, &mappings_mutex, &mappings, &batches_failed, store_batch]() {
             for (auto const& pkg: pkgs)
             {
                 auto const pkgname = pkg.name;
 
-                qt::core::world::enter_with_task([&return_val, &index, &cnc, &num_of_pkgs, pkgname, &db]() {
-
-                    cnc.push_back(index.get_details(pkgname, [&return_val, &num_of_pkgs, pkgname, &db](const click::PackageDetails& details, click::Index::Error error) {
+                scheduler.add(pkgname, [&return_val, &index, pkgname, &mappings_mutex, &mappings, &batches_failed, store_batch](const click::RequestScheduler::Done& done) {
+                    auto cancellable = index.get_details(pkgname, [&return_val, pkgname, &mappings_mutex, &mappings, &batches_failed, store_batch, done](const click::PackageDetails& details, click::Index::Error error) {
                         std::cout << "Details call for " << pkgname << " finished" << std::endl;
 
-                        if (error == click::Index::Error::NoError)
+                        if (error != click::Index::Error::NoError)
                         {
-                            try
-                            {
-                                std::cout << "Storing package department for " << pkgname << ", " << details.department << std::endl;
-                                db->store_package_mapping(pkgname, details.department);
-                            }
-                            catch (const std::exception& e)
-                            {
-                                std::cerr << "Failed to update departments database: " << e.what() << std::endl;
-                                return_val = DEPTS_ERROR_DB;
-                            }
+                            std::cerr << "Network error for " << pkgname << std::endl;
+                            done(false);
+                            return;
                         }
-                        else
+                        if (details.department.empty())
                         {
-                            std::cerr << "Network error" << std::endl;
-                            return_val = DEPTS_ERROR_NETWORK;
+                            std::cerr << "No department for " << pkgname << std::endl;
+                            return_val = DEPTS_ERROR_DB;
                         }
-                        if (--num_of_pkgs == 0)
+                        else
                         {
-                            std::cout << "All packages processed" << std::endl;
-                            qt::core::world::destroy();
+                            std::cout << "Package department for " << pkgname << ", " << details.department << std::endl;
+                            std::lock_guard<std::mutex> lock(mappings_mutex);
+                            mappings.push_back(std::make_pair(pkgname, details.department));
+                            if (!batches_failed && mappings.size() >= CHECKPOINT_INTERVAL)
+                            {
+                                store_batch();
+                            }
                         }
-                    }));
+                        done(true);
+                    });
+                    return [cancellable]() mutable {
+                        cancellable.cancel();
+                    };
                 });
             }
+            scheduler.start();
+        });
     });
 
     //
@@ -254,23 +536,46 @@ int main(int argc, char **argv)
     net_thread.join();
     details_thread.join();
 
+    if (scheduler.failed_count() > 0)
+    {
+        return_val = DEPTS_ERROR_NETWORK;
+    }
+    std::cout << "Request latencies: p50 " << scheduler.latency_percentile(50).count()
+              << " ms, p90 " << scheduler.latency_percentile(90).count()
+              << " ms, p99 " << scheduler.latency_percentile(99).count()
+              << " ms, max " << scheduler.latency_percentile(100).count() << " ms" << std::endl;
+
+    mappings.insert(mappings.end(), NON_CLICK_APPS.begin(), NON_CLICK_APPS.end());
+
+    // every locale and package was answered, even if not always usefully
+    const bool run_complete = packages_listed && num_of_locales == 0 && scheduler.failed_count() == 0;
+
+    //
+    // store the remaining package mappings in a single transaction; the database
+    // can be generated from scratch, so don't wait for the disk on every write.
+    // A run cut short by errors keeps its checkpoint, so the next one only retries what's missing
     try
     {
-        for (auto const& app: NON_CLICK_APPS)
+        std::cout << "Storing " << mappings.size() << " package departments (" << stored_mappings << " stored before)" << std::endl;
+        db->begin_bulk(true);
+        store_mappings(*db, mappings, installed_versions, checkpoint.run_id);
+        if (run_complete)
         {
-            db->store_package_mapping(app.first, app.second);
+            db->remove_meta(CHECKPOINT_PREFIX);
         }
+        db->commit_bulk();
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Failed to insert non-click appsint database" << std::endl;
+        std::cerr << "Failed to update departments database: " << e.what() << std::endl;
         return DEPTS_ERROR_DB;
     }
 
-    std::cout << std::endl << "Summary:" << std::endl
-        << "Number of department mappings: " << db->department_mapping_count() << std::endl
-        << "Number of department names (all locales): " << db->department_name_count() << std::endl
-        << "Number of applications: " << db->package_count() << std::endl;
+    print_summary(*db);
 
+    if (!write_mapped_file(std::move(db), dbfile))
+    {
+        return DEPTS_ERROR_DB;
+    }
     return return_val;
 }